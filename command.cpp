@@ -52,6 +52,8 @@ command_t commands[] = {
     { "list", "l", cmd_list, "List all jobs: resource-query> list" },
     { "info", "i", cmd_info, "Print info on a jobid: resource-query> info jobid" },
     { "cat", "a", cmd_cat, "Print jobspec file: resource-query> cat jobspec" },
+    { "stats", "s", cmd_stats, "Print planner statistics aggregated over "
+"the resource graph: resource-query> stats" },
     { "help", "h", cmd_help, "Print help message: resource-query> help" },
     { "quit", "q", cmd_quit, "Quit the session: resource-query> quit" },
     { "NA", "NA", (cmd_func_f *)NULL, "NA" }
@@ -84,6 +86,60 @@ static void get_jobstate_str (job_state_t state, string &mode)
     return;
 }
 
+/*! Planner statistics summed over one kind of planner of the graph, along
+ *  with the vertex whose planner holds the most scheduled points.
+ */
+struct planner_agg_t {
+    uint64_t planners = 0;
+    uint64_t points = 0;
+    uint64_t spans = 0;
+    uint64_t bytes = 0;
+    uint64_t searches = 0;
+    uint64_t candidates = 0;
+    uint64_t mt_visits = 0;
+    uint64_t span_updates = 0;
+    uint64_t point_updates = 0;
+    size_t max_points = 0;
+    size_t max_height = 0;
+    string worst = "-";
+};
+
+static void aggregate_stats (planner_agg_t &agg, const planner_stats_t &s,
+                             const string &name)
+{
+    agg.planners++;
+    agg.points += s.points;
+    agg.spans += s.spans;
+    agg.bytes += s.bytes;
+    agg.searches += s.searches;
+    agg.candidates += s.candidates;
+    agg.mt_visits += s.mt_visits;
+    agg.span_updates += s.span_updates;
+    agg.point_updates += s.point_updates;
+    if (s.points > agg.max_points) {
+        agg.max_points = s.points;
+        agg.worst = name;
+    }
+    if (s.point_tree_height > agg.max_height)
+        agg.max_height = s.point_tree_height;
+}
+
+static void print_stats (const string &what, const planner_agg_t &agg,
+                         bool ops)
+{
+    cout << "INFO: " << what << ": " << agg.planners << ", points: "
+         << agg.points << ", spans: " << agg.spans << ", bytes: "
+         << agg.bytes << endl;
+    cout << "INFO: " << what << ": max points: " << agg.max_points
+         << " (" << agg.worst << "), max tree height: " << agg.max_height
+         << endl;
+    if (ops)
+        cout << "INFO: " << what << ": searches: " << agg.searches
+             << ", candidates: " << agg.candidates << ", mt visits: "
+             << agg.mt_visits << ", span updates: " << agg.span_updates
+             << ", point updates: " << agg.point_updates << endl;
+}
+
 static int do_remove (resource_context_t *ctx, int64_t jobid)
 {
     int rc = -1;
@@ -261,6 +317,32 @@ int cmd_cat (resource_context_t *ctx, vector<string> &args)
     return 0;
 }
 
+int cmd_stats (resource_context_t *ctx, vector<string> &args)
+{
+    vtx_iterator vi, v_end;
+    planner_stats_t s;
+    planner_agg_t plans, x_checkers, subplans;
+    resource_graph_t &g = ctx->db.resource_graph;
+
+    for (tie (vi, v_end) = vertices (g); vi != v_end; ++vi) {
+        if (g[*vi].schedule.plans
+            && planner1d_stats (g[*vi].schedule.plans, &s) == 0)
+            aggregate_stats (plans, s, g[*vi].name);
+        if (g[*vi].schedule.x_checker
+            && planner1d_stats (g[*vi].schedule.x_checker, &s) == 0)
+            aggregate_stats (x_checkers, s, g[*vi].name);
+        for (auto &kv : g[*vi].idata.subplans)
+            if (kv.second && planner_stats (kv.second, &s) == 0)
+                aggregate_stats (subplans, s, g[*vi].name);
+    }
+    print_stats ("vertex planners", plans, false);
+    print_stats ("exclusivity checkers", x_checkers, false);
+    print_stats ("subtree planners", subplans, true);
+    cout << "INFO: total planner bytes: "
+         << plans.bytes + x_checkers.bytes + subplans.bytes << endl;
+    return 0;
+}
+
 int cmd_help (resource_context_t *ctx, vector<string> &args)
 {
     bool multi = true;
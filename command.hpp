@@ -58,6 +58,9 @@ struct test_params_t {
     std::string o_fext;          /* File extension */
     emit_format_t o_format;      /* Output graph format */
     bool elapse_time;            /* Print elapse time */
+    unsigned n_threads;          /* Threads of the parallel walk (0: off) */
+    unsigned par_depth;          /* Depth the parallel walk stops at */
+    uint64_t par_min_size;       /* Smallest subtree walked in parallel */
 };
 
 struct resource_context_t {
@@ -65,6 +68,7 @@ struct resource_context_t {
     uint64_t jobid_counter;      /* Hold the current jobid value */
     resource_graph_db_t db;      /* Resource graph data store */
     dfu_match_cb_t *matcher;     /* Match callback object */
+    int view;                    /* Graph view of the matcher (add_view) */
     dfu_traverser_t traverser;   /* Graph traverser object */
     std::map<uint64_t, job_info_t *> jobs;     /* Jobs table */
     std::map<uint64_t, uint64_t> allocations;  /* Allocation table */
@@ -80,6 +84,7 @@ int cmd_cancel (resource_context_t *ctx, std::vector<std::string> &args);
 int cmd_list (resource_context_t *ctx, std::vector<std::string> &args);
 int cmd_info (resource_context_t *ctx, std::vector<std::string> &args);
 int cmd_cat (resource_context_t *ctx, std::vector<std::string> &args);
+int cmd_stats (resource_context_t *ctx, std::vector<std::string> &args);
 int cmd_quit (resource_context_t *ctx, std::vector<std::string> &args);
 int cmd_help (resource_context_t *ctx, std::vector<std::string> &args);
 
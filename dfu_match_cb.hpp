@@ -28,6 +28,7 @@
 
 #include <set>
 #include <map>
+#include <atomic>
 #include <vector>
 #include <cstdint>
 #include <iostream>
@@ -53,12 +54,12 @@ public:
     dfu_match_cb_t (const dfu_match_cb_t &o)
         : matcher_data_t (o)
     {
-        m_trav_level = o.m_trav_level;
+        m_trav_level = o.m_trav_level.load ();
     }
     dfu_match_cb_t &operator= (const dfu_match_cb_t &o)
     {
         matcher_data_t::operator= (o);
-        m_trav_level = o.m_trav_level;
+        m_trav_level = o.m_trav_level.load ();
         return *this;
     }
     virtual ~dfu_match_cb_t () { }
@@ -187,7 +188,8 @@ public:
     }
 
 private:
-    int m_trav_level;
+    // Atomic, as the parallel explore calls back from several threads
+    std::atomic<int> m_trav_level;
 };
 } // namespace resource_model
 } // namespace Flux
@@ -87,22 +87,23 @@ public:
     {
         int64_t score = MATCH_MET;
         int64_t overall;
+        intern_id_t s = dom_subsystem_id ();
 
         for (auto &resource : resources) {
-            if (resource.type != g[u].type)
+            if (resource.type_id != g[u].type_id)
                 continue;
 
             // jobspec resource type matches with the visiting vertex
             for (auto &c_resource : resource.with) {
                 // test children resource count requirements
-                const std::string &c_type = c_resource.type;
-                unsigned int qc = dfu.qualified_count (subsystem, c_type);
+                intern_id_t c_type = c_resource.type_id;
+                unsigned int qc = dfu.qualified_count (s, c_type);
                 unsigned int count = select_count (c_resource, qc);
                 if (count == 0) {
                     score = MATCH_UNMET;
                     break;
                 }
-                dfu.choose_accum_best_k (subsystem, c_resource.type, count);
+                dfu.choose_accum_best_k (s, c_type, count);
             }
         }
 
@@ -156,24 +157,25 @@ public:
     {
         int64_t score = MATCH_MET;
         int64_t overall;
+        intern_id_t s = dom_subsystem_id ();
         // this comparator overrides default and prefer the lower id
         fold::less comp;
 
         for (auto &resource : resources) {
-            if (resource.type != g[u].type)
+            if (resource.type_id != g[u].type_id)
                 continue;
 
             // jobspec resource type matches with the visiting vertex
             for (auto &c_resource : resource.with) {
                 // test children resource count requirements
-                const std::string &c_type = c_resource.type;
-                unsigned int qc = dfu.qualified_count (subsystem, c_type);
+                intern_id_t c_type = c_resource.type_id;
+                unsigned int qc = dfu.qualified_count (s, c_type);
                 unsigned int count = select_count (c_resource, qc);
                 if (count == 0) {
                     score = MATCH_UNMET;
                     break;
                 }
-                dfu.choose_accum_best_k (subsystem, c_type, count, comp);
+                dfu.choose_accum_best_k (s, c_type, count, comp);
             }
         }
 
@@ -267,24 +269,25 @@ public:
         using namespace boost::icl;
         int score = MATCH_MET;
         int64_t overall;
+        intern_id_t s = dom_subsystem_id ();
         fold::interval_greater comp;
 
         for (auto &resource : resources) {
-            if (resource.type != g[u].type)
+            if (resource.type_id != g[u].type_id)
                 continue;
 
             for (auto &c_resource : resource.with) {
-                const std::string &c_type = c_resource.type;
-                unsigned int qc = dfu.qualified_count (subsystem, c_type);
+                intern_id_t c_type = c_resource.type_id;
+                unsigned int qc = dfu.qualified_count (s, c_type);
                 unsigned int count = select_count (c_resource, qc);
                 if (count == 0) {
                     score = MATCH_UNMET;
                     break;
                 }
-                dfu.transform (subsystem, c_type,
+                dfu.transform (s, c_type,
                                icl::inserter (comp.ivset, comp.ivset.end ()),
                                fold::to_interval);
-                dfu.choose_accum_best_k (subsystem, c_type, count, comp);
+                dfu.choose_accum_best_k (s, c_type, count, comp);
             }
         }
 
@@ -49,7 +49,6 @@ int dfu_traverser_t::schedule (Jobspec::Jobspec &jobspec,
                                std::unordered_map<string, int64_t> &dfv)
 {
     int rc = -1;
-    const subsystem_t &dom = get_match_cb ()->dom_subsystem ();
 
     /* Allocate */
     rc = detail::dfu_impl_t::select (jobspec, root, meta, x, needs);
@@ -58,15 +57,27 @@ int dfu_traverser_t::schedule (Jobspec::Jobspec &jobspec,
         meta.allocate = false;
         int64_t t = meta.at + 1;
         vector<uint64_t> agg;
-        planner_t *p = (*get_graph ())[root].idata.subplans.at (dom);
-        size_t len = planner_resources_len (p);
+        // Only the dominant subsystem's plans are updated by allocations
+        // (upd_upv does not update the auxiliary ones yet), so the root
+        // plan of the dominant subsystem alone picks the candidate times
+        const auto &subplans = (*get_graph ())[root].idata.subplans;
+        auto i = subplans.find (get_match_cb ()->dom_subsystem_id ());
+        if (i == subplans.end () || !i->second)
+            goto done;
+        planner_t *p = i->second;
+        planner_avail_iter_t *it = planner_avail_iter_new (p);
         detail::dfu_impl_t::count (p, dfv, agg);
-        for (t = planner_avail_time_first (p, t, meta.duration, &agg[0], len);
-             (t != -1 && rc != 0); t = planner_avail_time_next (p)) {
+        // A cursor of our own keeps the request and position across the
+        // candidates; the root subplan is left untouched while they are tried
+        for (t = planner_avail_iter_first (it, t, meta.duration,
+                                           &agg[0], agg.size ());
+             (t != -1 && rc != 0); t = planner_avail_iter_next (it)) {
             meta.at = t;
             rc = detail::dfu_impl_t::select (jobspec, root, meta, x, needs);
         }
+        planner_avail_iter_destroy (&it);
     }
+done:
     return rc;
 }
 
@@ -146,6 +157,12 @@ void dfu_traverser_t::clear_err_message ()
     detail::dfu_impl_t::clear_err_message ();
 }
 
+int dfu_traverser_t::set_parallel (unsigned n_threads, unsigned depth,
+                                   uint64_t min_size)
+{
+    return detail::dfu_impl_t::set_parallel (n_threads, depth, min_size);
+}
+
 int dfu_traverser_t::initialize ()
 {
     int rc = 0;
@@ -155,15 +172,17 @@ int dfu_traverser_t::initialize ()
         return -1;
     }
 
-    for (auto &subsystem : get_match_cb ()->subsystems ()) {
+    const vector<intern_id_t> &ids = get_match_cb ()->subsystem_ids ();
+    for (size_t i = 0; i < ids.size (); ++i) {
         map<string, int64_t> from_dfv;
+        const subsystem_t &subsystem = get_match_cb ()->subsystems ()[i];
         if (get_roots ()->find (subsystem) == get_roots ()->end ()) {
             errno = ENOTSUP;
             rc = -1;
             break;
         }
         root = get_roots ()->at(subsystem);
-        rc += detail::dfu_impl_t::prime (subsystem, root, from_dfv);
+        rc += detail::dfu_impl_t::prime (ids[i], root, from_dfv);
     }
     return rc;
 }
@@ -193,6 +212,11 @@ int dfu_traverser_t::run (Jobspec::Jobspec &jobspec, match_op_t op,
     detail::jobmeta_t meta;
     unsigned int needs = 0;
     vtx_t root = get_roots ()->at(dom);
+    // Reject a time before the base before any vertex is visited
+    if (*at < planner1d_base_time ((*get_graph ())[root].schedule.plans)) {
+        errno = EINVAL;
+        return -1;
+    }
     bool x = detail::dfu_impl_t::exclusivity (jobspec.resources, root);
     std::unordered_map<string, int64_t> dfv;
     detail::dfu_impl_t::prime (jobspec.resources, dfv);
@@ -204,6 +228,33 @@ int dfu_traverser_t::run (Jobspec::Jobspec &jobspec, match_op_t op,
     return rc;
 }
 
+int dfu_traverser_t::satisfiable (Jobspec::Jobspec &jobspec, int64_t at)
+{
+    if (!get_graph () || !get_roots () || !get_match_cb ()
+        || jobspec.resources.empty ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    const subsystem_t &dom = get_match_cb ()->dom_subsystem ();
+    if (get_roots ()->find (dom) == get_roots ()->end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    detail::jobmeta_t meta;
+    unsigned int needs = 0;
+    vtx_t root = get_roots ()->at(dom);
+    if (at < planner1d_base_time ((*get_graph ())[root].schedule.plans)) {
+        errno = EINVAL;
+        return -1;
+    }
+    bool x = detail::dfu_impl_t::exclusivity (jobspec.resources, root);
+    std::unordered_map<string, int64_t> dfv;
+    detail::dfu_impl_t::prime (jobspec.resources, dfv);
+    meta.build (jobspec, true, -1, at);
+    return detail::dfu_impl_t::select (jobspec, root, meta, x, &needs);
+}
+
 int dfu_traverser_t::remove (int64_t jobid)
 {
     const subsystem_t &dom = get_match_cb ()->dom_subsystem ();
@@ -218,6 +269,15 @@ int dfu_traverser_t::remove (int64_t jobid)
     return detail::dfu_impl_t::remove (root, jobid);
 }
 
+int dfu_traverser_t::advance (int64_t now)
+{
+    if (!get_graph () || !get_roots () || !get_match_cb ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    return detail::dfu_impl_t::advance (now);
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
@@ -36,6 +36,11 @@ namespace resource_model {
  *  subsystem and upwalk on each and all of the auxiliary subsystems selected
  *  by the matcher callback object (dfu_match_cb_t). Corresponding match
  *  callback methods are invoked at various well-defined graph visit events.
+ *
+ *  A traverser keeps the scratch state of its walks to itself rather than in
+ *  the resource graph. Several traversers, each with its own match callback
+ *  object, can therefore test jobspecs with satisfiable () on one graph at
+ *  the same time, as long as nothing updates the graph meanwhile.
  */
 class dfu_traverser_t : protected detail::dfu_impl_t
 {
@@ -57,6 +62,32 @@ public:
     void set_match_cb (dfu_match_cb_t *m);
     void clear_err_message ();
 
+    /*! Turn on parallel exploration of the dominant subsystem. The
+     *  children of each vertex that is less than depth below the root and
+     *  roots a subtree of at least min_size vertices are then walked as
+     *  tasks on a work-stealing pool of n_threads threads, each into a
+     *  scoring object of its own, and the results are merged in edge
+     *  order. The selection is the same as that of the serial walk, and
+     *  the match callbacks see the same inputs, but they are called from
+     *  several threads at once and must be thread-safe (as those of
+     *  dfu_match_id_based.hpp are). Call this after initialize ().
+     *
+     *  Subtrees walked at once must not share vertices, so the dominant
+     *  subsystem must be a tree, as the containment hierarchies that
+     *  resource_generator_t builds are. Otherwise, the walk stays serial.
+     *
+     *  \param n_threads number of worker threads; 0 for the serial walk.
+     *  \param depth     depth of the vertices below which the walk stays
+     *                   serial.
+     *  \param min_size  number of vertices below which a subtree is walked
+     *                   serially; 0 for no limit.
+     *  \return          0 on success; -1 on error, and the walk stays
+     *                   serial.
+     *                       EINVAL: graph, roots or match callback not set.
+     *                       ENOTSUP: the dominant subsystem is not a tree.
+     */
+    int set_parallel (unsigned n_threads, unsigned depth, uint64_t min_size);
+
     /*! Prime the resource graph with subtree plans. Assume resource graph,
      *  roots and match callback have already been registered. The subtree
      *  plans are instantiated on certain resource vertices and updated with the
@@ -106,13 +137,28 @@ public:
      *  \param at[out]   when the job is scheduled if reserved.
      *  \param ss        stringstream into which emitted R infor is stored.
      *  \return          0 on success; -1 on error.
-     *                       EINVAL: graph, roots or match callback not set.
+     *                       EINVAL: graph, roots or match callback not set,
+     *                               or at is before the base time (advance).
      *                       ENOTSUP: roots does not contain a subsystem the
      *                                match callback uses.
      */
     int run (Jobspec::Jobspec &jobspec, match_op_t op, int64_t id, int64_t *at,
              std::stringstream &ss);
 
+    /*! Test whether the resources of jobspec can be allocated at time at,
+     *  without allocating them: the resource graph is only read. The
+     *  jobspec is not: its per-resource aggregates are recomputed, so a
+     *  jobspec object can be tested again but not by two threads at once.
+     *
+     *  \param jobspec   Jobspec object.
+     *  \param at        time at which to test.
+     *  \return          0 if the jobspec can be allocated at at; -1 if not
+     *                   or on error.
+     *                       EINVAL: graph, roots or match callback not set,
+     *                               or at is before the base time (advance).
+     */
+    int satisfiable (Jobspec::Jobspec &jobspec, int64_t at);
+
     /*! Remove the allocation/reservation referred to by jobid and update
      *  the resource state.
      *
@@ -122,6 +168,18 @@ public:
      */
     int remove (int64_t jobid);
 
+    /*! Advance the base time of the schedule to now. Every vertex planner
+     *  and subtree plan of the resource graph drops its history before now,
+     *  so subsequent matches only pay for the live schedule. Jobs that are
+     *  over by now are forgotten: removing one of them afterwards is a no-op.
+     *  Matches requested before now then fail with EINVAL.
+     *
+     *  \param now       new base time.
+     *  \return          0 on success; -1 on error.
+     *                       EINVAL: graph, roots or match callback not set.
+     */
+    int advance (int64_t now);
+
 private:
     int schedule (Jobspec::Jobspec &jobspec,
                   detail::jobmeta_t &meta, bool x, match_op_t op,
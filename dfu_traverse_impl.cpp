@@ -35,6 +35,10 @@ using namespace Flux::Jobspec;
 using namespace Flux::resource_model;
 using namespace Flux::resource_model::detail;
 
+//! Interned id of the slot type of jobspecs
+static const Flux::intern_id_t slot_type_id
+    = Flux::resource_type_ids ().intern ("slot");
+
 /****************************************************************************
  *                                                                          *
  *         DFU Traverser Implementation Private API Definitions             *
@@ -61,21 +65,89 @@ void dfu_impl_t::tick_color_base ()
     m_color_base = m_color.reset (m_color_base);
 }
 
-bool dfu_impl_t::in_subsystem (edg_t e, const subsystem_t &subsystem) const
+uint64_t dfu_impl_t::color (intern_id_t subsystem, vtx_t u) const
+{
+    // A vertex that has never been colored is white
+    if ((size_t)subsystem >= m_ctx.colors.size ()
+        || u >= m_ctx.colors[subsystem].size ())
+        return 0;
+    return m_ctx.colors[subsystem][u];
+}
+
+void dfu_impl_t::set_color (intern_id_t subsystem, vtx_t u, uint64_t c)
+{
+    if ((size_t)subsystem >= m_ctx.colors.size ())
+        m_ctx.colors.resize (subsystem + 1);
+    std::vector<uint64_t> &colors = m_ctx.colors[subsystem];
+    if (u >= colors.size ())
+        colors.resize (std::max<size_t> (u + 1, num_vertices (*m_graph)), 0);
+    colors[u] = c;
+}
+
+edg_sel_t &dfu_impl_t::edge_sel (edg_t e)
 {
-    return ((*m_graph)[e].idata.member_of.find (subsystem)
-                != (*m_graph)[e].idata.member_of.end ());
+    size_t i = (size_t)(*m_graph)[e].idx;
+    if (i >= m_ctx.edges.size ())
+        m_ctx.edges.resize (i + 1);
+    return m_ctx.edges[i];
 }
 
-bool dfu_impl_t::stop_explore (edg_t e, const subsystem_t &subsystem) const
+void dfu_impl_t::add_err_message (const string &msg)
+{
+    // Parallel explore tasks can fail at once
+    lock_guard<mutex> guard (m_err_lock);
+    m_err_msg += msg;
+}
+
+void dfu_impl_t::presize_ctx (intern_id_t subsystem)
+{
+    // Size the scratch state up front, so that set_color and edge_sel
+    // never resize it while explore tasks index into it
+    size_t n_edges = m_ctx.edges.size ();
+    f_edg_iterator ei, ei_end;
+    for (tie (ei, ei_end) = edges (*m_graph); ei != ei_end; ++ei)
+        n_edges = std::max<size_t> (n_edges, (*m_graph)[*ei].idx + 1);
+    m_ctx.edges.resize (n_edges);
+    if ((size_t)subsystem >= m_ctx.colors.size ())
+        m_ctx.colors.resize (subsystem + 1);
+    if (m_ctx.colors[subsystem].size () < num_vertices (*m_graph))
+        m_ctx.colors[subsystem].resize (num_vertices (*m_graph), 0);
+}
+
+int64_t dfu_impl_t::count_subtree (intern_id_t subsystem, vtx_t u,
+                                   vtx_t parent)
+{
+    // Edges back to the parent are skipped, as the walk finds it gray.
+    // Reaching any other vertex twice means the subsystem is no tree.
+    int64_t size = 1, n = 0;
+    if (m_subtree_sizes[u] != 0)
+        return -1;
+    m_subtree_sizes[u] = 1;
+    graph_traits<f_resource_graph_t>::out_edge_iterator ei, ei_end;
+    for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei) {
+        vtx_t tgt = target (*ei, *m_graph);
+        if (!in_subsystem (*ei, subsystem) || tgt == parent)
+            continue;
+        if ((n = count_subtree (subsystem, tgt, u)) == -1)
+            return -1;
+        size += n;
+    }
+    m_subtree_sizes[u] = size;
+    return size;
+}
+
+bool dfu_impl_t::in_subsystem (edg_t e, intern_id_t subsystem) const
+{
+    return (*m_graph)[e].idata.in_subsystem (subsystem);
+}
+
+bool dfu_impl_t::stop_explore (edg_t e, intern_id_t subsystem) const
 {
     // Return true if the target vertex has been visited (forward: black)
     // or being visited (cycle: gray).
-    vtx_t u = target (e, *m_graph);
-    return (((*m_graph)[u].idata.colors[subsystem]
-                 == m_color.gray (m_color_base))
-            || ((*m_graph)[u].idata.colors[subsystem]
-                 == m_color.black (m_color_base)));
+    uint64_t c = color (subsystem, target (e, *m_graph));
+    return (c == m_color.gray (m_color_base)
+            || c == m_color.black (m_color_base));
 }
 
 bool dfu_impl_t::exclusivity (const vector<Jobspec::Resource> &resources,
@@ -85,34 +157,35 @@ bool dfu_impl_t::exclusivity (const vector<Jobspec::Resource> &resources,
     // and it requested exclusive access, return true;
     bool exclusive = false;
     for (auto &resource: resources) {
-        if (resource.type == (*m_graph)[u].type)
+        if (resource.type_id == (*m_graph)[u].type_id)
             if (resource.exclusive == Jobspec::tristate_t::TRUE)
                 exclusive = true;
     }
     return exclusive;
 }
 
-int dfu_impl_t::by_avail (const jobmeta_t &meta, const std::string &s, vtx_t u,
+int dfu_impl_t::by_avail (const jobmeta_t &meta, intern_id_t s, vtx_t u,
                           const std::vector<Jobspec::Resource> &resources)
 {
     int rc = -1;
     int64_t avail = -1;
-    planner_t *p = NULL;
+    planner1d_t *p = NULL;
     int64_t at = meta.at;
     uint64_t duration = meta.duration;
 
     // Prune by the visiting resource vertex's availability
     // if rack has been allocated exclusively, no reason to descend further.
     p = (*m_graph)[u].schedule.plans;
-    if ((avail = planner_avail_resources_during (p, at, duration, 0)) == 0) {
+    if ((avail = planner1d_avail_resources_during (p, at, duration)) == 0) {
         goto done;
     } else if (avail == -1) {
-        m_err_msg += "by_avail: planner_avail_resources_during returned -1.\n";
+        string msg = "by_avail: planner1d_avail_resources_during returned -1.\n";
         if (errno != 0) {
-            m_err_msg += strerror (errno);
-            m_err_msg += ".\n";
+            msg += strerror (errno);
+            msg += ".\n";
             errno = 0;
         }
+        add_err_message (msg);
         goto done;
     }
     rc = 0;
@@ -121,25 +194,25 @@ done:
     return rc;
 }
 
-int dfu_impl_t::by_excl (const jobmeta_t &meta, const std::string &s, vtx_t u,
+int dfu_impl_t::by_excl (const jobmeta_t &meta, intern_id_t s, vtx_t u,
                          const Jobspec::Resource &resource)
 {
     int rc = -1;
-    planner_t *p = NULL;
+    planner1d_t *p = NULL;
     int64_t at = meta.at;
     int64_t njobs = -1;
     uint64_t duration = meta.duration;
     if (resource.exclusive == Jobspec::tristate_t::TRUE) {
         p = (*m_graph)[u].schedule.x_checker;
-        njobs = planner_avail_resources_during_by_type (p, at, duration,
-                                                        X_CHECKER_JOBS_STR);
+        njobs = planner1d_avail_resources_during (p, at, duration);
         if (njobs == -1) {
-            m_err_msg += "by_excl: planner_avail_resources_during returned -1.\n";
+            string msg = "by_excl: planner1d_avail_resources_during returned -1.\n";
             if (errno != 0) {
-                m_err_msg += strerror (errno);
-                m_err_msg += ".\n";
+                msg += strerror (errno);
+                msg += ".\n";
                 errno = 0;
             }
+            add_err_message (msg);
             goto done;
         } else if (njobs < X_CHECKER_NJOBS) {
             goto done;
@@ -151,7 +224,7 @@ done:
     return rc;
 }
 
-int dfu_impl_t::by_subplan (const jobmeta_t &meta, const std::string &s, vtx_t u,
+int dfu_impl_t::by_subplan (const jobmeta_t &meta, intern_id_t s, vtx_t u,
                             const Jobspec::Resource &resource)
 {
     int rc = -1;
@@ -159,8 +232,14 @@ int dfu_impl_t::by_subplan (const jobmeta_t &meta, const std::string &s, vtx_t u
     int64_t at = meta.at;
     uint64_t duration = meta.duration;
     vector<uint64_t> aggs;
-    planner_t *p = (*m_graph)[u].idata.subplans[s];
+    planner_t *p = NULL;
+    const auto &subplans = (*m_graph)[u].idata.subplans;
+    auto i = subplans.find (s);
 
+    if (i == subplans.end () || !(p = i->second)) {
+        rc = 0;
+        goto done;
+    }
     count (p, resource.user_data, aggs);
     if (aggs.empty ()) {
         rc = 0;
@@ -170,9 +249,10 @@ int dfu_impl_t::by_subplan (const jobmeta_t &meta, const std::string &s, vtx_t u
     len = aggs.size ();
     if ((rc = planner_avail_during (p, at, duration, &(aggs[0]), len)) == -1) {
         if (errno != 0) {
-            m_err_msg += "by_subplan: planner_avail_during returned -1.\n";
-            m_err_msg += strerror (errno);
-            m_err_msg += ".\n";
+            string msg = "by_subplan: planner_avail_during returned -1.\n";
+            msg += strerror (errno);
+            msg += ".\n";
+            add_err_message (msg);
             errno = 0;
         }
         goto done;
@@ -183,7 +263,7 @@ done:
 }
 
 int dfu_impl_t::prune (const jobmeta_t &meta, bool exclusive,
-                       const std::string &s, vtx_t u,
+                       intern_id_t s, vtx_t u,
                        const std::vector<Jobspec::Resource> &resources)
 {
     int rc = 0;
@@ -192,7 +272,7 @@ int dfu_impl_t::prune (const jobmeta_t &meta, bool exclusive,
     if ( (rc = by_avail (meta, s, u, resources)) == -1)
         goto done;
     for (auto &resource : resources) {
-        if ((*m_graph)[u].type != resource.type)
+        if ((*m_graph)[u].type_id != resource.type_id)
             continue;
         // Prune by exclusivity checker
         if ( (rc = by_excl (meta, s, u, resource)) == -1)
@@ -210,9 +290,18 @@ planner_t *dfu_impl_t::subtree_plan (vtx_t u, vector<uint64_t> &av,
                                      vector<const char *> &tp)
 {
     size_t len = av.size ();
-    int64_t base_time = planner_base_time ((*m_graph)[u].schedule.plans);
-    uint64_t duration = planner_duration ((*m_graph)[u].schedule.plans);
-    return planner_new (base_time, duration, &av[0], &tp[0], len);
+    int64_t base_time = planner1d_base_time ((*m_graph)[u].schedule.plans);
+    uint64_t duration = planner1d_duration ((*m_graph)[u].schedule.plans);
+    planner_t *p = NULL;
+    // Vertices of the same kind aggregate the same types and totals, so
+    // their subtree planners all share one interned descriptor.
+    planner_desc_t *desc = planner_desc_new (&av[0], &tp[0], len);
+    if (desc) {
+        p = planner_new_with_desc (base_time, duration, desc,
+                                   PLANNER_BACKEND_RBTREE);
+        planner_desc_unref (&desc);
+    }
+    return p;
 }
 
 void dfu_impl_t::match (vtx_t u, const vector<Resource> &resources,
@@ -220,17 +309,17 @@ void dfu_impl_t::match (vtx_t u, const vector<Resource> &resources,
                        const Resource **match_resource)
 {
     for (auto &resource : resources) {
-        if ((*m_graph)[u].type == resource.type) {
+        if ((*m_graph)[u].type_id == resource.type_id) {
             *match_resource = &resource;
             if (!resource.with.empty ()) {
                 for (auto &c_resource : resource.with)
-                    if (c_resource.type == "slot")
+                    if (c_resource.type_id == slot_type_id)
                         *slot_resource = &c_resource;
             }
             // Limitations: jobspec must not have same type at same level
             // Please read README.md
             break;
-        } else if (resource.type == "slot") {
+        } else if (resource.type_id == slot_type_id) {
             *slot_resource = &resource;
             break;
         }
@@ -245,7 +334,7 @@ bool dfu_impl_t::slot_match (vtx_t u, const Resource *slot_resources)
         for (auto &c_resource : (*slot_resources).with) {
             for (tie (ei, eie) = out_edges (u, *m_graph); ei != eie; ++ei) {
                 vtx_t tgt = target (*ei, *m_graph);
-                if ((*m_graph)[tgt].type == c_resource.type)
+                if ((*m_graph)[tgt].type_id == c_resource.type_id)
                     break; // found the target resource type of the slot
             }
             if (ei == eie) {
@@ -280,12 +369,12 @@ const vector<Resource> &dfu_impl_t::test (vtx_t u,
     return *ret;
 }
 
-int dfu_impl_t::accum_if (const subsystem_t &subsystem, const string &type,
-                          unsigned int counts, map<string, int64_t> &accum)
+int dfu_impl_t::accum_if (intern_id_t subsystem, intern_id_t type_id,
+                          const string &type, unsigned int counts,
+                          map<string, int64_t> &accum)
 {
     int rc = -1;
-    if (m_match->sdau_resource_types[subsystem].find (type)
-        != m_match->sdau_resource_types[subsystem].end ()) {
+    if (m_match->sdau_tracked (subsystem, type_id)) {
         if (accum.find (type) == accum.end ())
             accum[type] = counts;
         else
@@ -295,13 +384,12 @@ int dfu_impl_t::accum_if (const subsystem_t &subsystem, const string &type,
     return rc;
 }
 
-int dfu_impl_t::accum_if (const subsystem_t &subsystem, const string &type,
-                          unsigned int counts,
+int dfu_impl_t::accum_if (intern_id_t subsystem, intern_id_t type_id,
+                          const string &type, unsigned int counts,
                           std::unordered_map<string, int64_t> &accum)
 {
     int rc = -1;
-    if (m_match->sdau_resource_types[subsystem].find (type)
-        != m_match->sdau_resource_types[subsystem].end ()) {
+    if (m_match->sdau_tracked (subsystem, type_id)) {
         if (accum.find (type) == accum.end ())
             accum[type] = counts;
         else
@@ -311,7 +399,7 @@ int dfu_impl_t::accum_if (const subsystem_t &subsystem, const string &type,
     return rc;
 }
 
-int dfu_impl_t::prime_exp (const subsystem_t &subsystem, vtx_t u,
+int dfu_impl_t::prime_exp (intern_id_t subsystem, vtx_t u,
                            map<string, int64_t> &dfv)
 {
     int rc = 0;
@@ -325,15 +413,68 @@ int dfu_impl_t::prime_exp (const subsystem_t &subsystem, vtx_t u,
     return rc;
 }
 
+void dfu_impl_t::add_child (intern_id_t subsystem, edg_t e, bool x_inout,
+                            scoring_api_t &dfu)
+{
+    unsigned int count = dfu.avail ();
+    eval_edg_t ev_edg (count, count, x_inout, e);
+    eval_egroup_t egrp (dfu.overall_score (), dfu.avail (), 0, x_inout, false);
+    egrp.edges.push_back (ev_edg);
+    dfu.add (subsystem, (*m_graph)[target (e, *m_graph)].type_id, egrp);
+}
+
+int dfu_impl_t::explore_par (const jobmeta_t &meta, vtx_t u,
+                             intern_id_t subsystem,
+                             const vector<Resource> &resources, bool *excl,
+                             scoring_api_t &dfu, unsigned depth)
+{
+    int rc2 = -1;
+    vector<edg_t> children;
+    graph_traits<f_resource_graph_t>::out_edge_iterator ei, ei_end;
+    for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei) {
+        if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem))
+            continue;
+        children.push_back (*ei);
+    }
+
+    // Each child subtree is walked into a scoring object of its own...
+    size_t n = children.size ();
+    vector<scoring_api_t> subs (n);
+    vector<int> rcs (n, -1);
+    vector<char> x_inouts (n, *excl);
+    m_pool->run_all (n, [&] (size_t i) {
+        bool x_inout = *excl;
+        vtx_t tgt = target (children[i], *m_graph);
+        rcs[i] = dom_dfv (meta, tgt, resources, &x_inout, subs[i], depth + 1);
+        x_inouts[i] = x_inout;
+    });
+
+    // ...and folded into dfu in edge order, as the serial walk would have
+    for (size_t i = 0; i < n; ++i) {
+        if (rcs[i] != 0)
+            continue;
+        dfu.merge (subs[i]);
+        dfu.set_avail (subs[i].avail ());
+        dfu.set_overall_score (subs[i].overall_score ());
+        add_child (subsystem, children[i], x_inouts[i], dfu);
+        rc2 = 0;
+    }
+    return rc2;
+}
+
 int dfu_impl_t::explore (const jobmeta_t &meta, vtx_t u,
-                         const subsystem_t &subsystem,
+                         intern_id_t subsystem,
                          const vector<Resource> &resources, bool *excl,
-                         visit_t direction, scoring_api_t &dfu)
+                         visit_t direction, scoring_api_t &dfu, unsigned depth)
 {
     int rc = -1;
     int rc2 = -1;
-    const subsystem_t &dom = m_match->dom_subsystem ();
     graph_traits<f_resource_graph_t>::out_edge_iterator ei, ei_end;
+    if (direction == visit_t::DFV && m_pool && depth < m_par_depth
+        && m_subtree_sizes[u] >= m_par_min_size
+        && out_degree (u, *m_graph) > 1)
+        return explore_par (meta, u, subsystem, resources, excl, dfu, depth);
+
     for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei) {
         if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem))
             continue;
@@ -346,47 +487,44 @@ int dfu_impl_t::explore (const jobmeta_t &meta, vtx_t u,
             break;
         case visit_t::DFV:
         default:
-            rc = dom_dfv (meta, tgt, resources, &x_inout, dfu);
+            rc = dom_dfv (meta, tgt, resources, &x_inout, dfu, depth + 1);
             break;
         }
         if (rc == 0) {
-            int64_t score = dfu.overall_score ();
-            unsigned int count = dfu.avail ();
-            eval_edg_t ev_edg (count, count, x_inout, *ei);
-            eval_egroup_t egrp (dfu.overall_score (), dfu.avail (), 0, x_inout, false);
-            egrp.edges.push_back (ev_edg);
-            dfu.add (subsystem, (*m_graph)[tgt].type, egrp);
+            add_child (subsystem, *ei, x_inout, dfu);
             rc2 = 0;
         }
     }
     return rc2;
 }
 
-int dfu_impl_t::aux_upv (const jobmeta_t &meta, vtx_t u, const subsystem_t &aux,
+int dfu_impl_t::aux_upv (const jobmeta_t &meta, vtx_t u, intern_id_t aux_id,
                          const vector<Resource> &resources, bool *excl,
                          scoring_api_t &to_parent)
 {
     int rc = -1;
+    const subsystem_t &aux = m_match->subsystem_name (aux_id);
     scoring_api_t upv;
     int64_t avail = 0, at = meta.at;
     uint64_t duration = meta.duration;
-    planner_t *p = NULL;
+    planner1d_t *p = NULL;
     bool x_in = *excl;
 
-    if ((prune (meta, x_in, aux, u, resources) == -1)
+    if ((prune (meta, x_in, aux_id, u, resources) == -1)
         || (m_match->aux_discover_vtx (u, aux, resources, *m_graph)) != 0)
         goto done;
 
-    if (u != (*m_roots)[aux])
-        explore (meta, u, aux, resources, excl, visit_t::UPV, upv);
+    if (u != m_roots->at (aux))
+        explore (meta, u, aux_id, resources, excl, visit_t::UPV, upv, 0);
 
     p = (*m_graph)[u].schedule.plans;
-    if ( (avail = planner_avail_resources_during (p, at, duration, 0)) == 0) {
+    if ( (avail = planner1d_avail_resources_during (p, at, duration)) == 0) {
         goto done;
     } else if (avail == -1) {
-        m_err_msg += "aux_upv: planner_avail_resources_during returned -1. ";
-        m_err_msg += strerror (errno);
-        m_err_msg += ".\n";
+        string msg = "aux_upv: planner1d_avail_resources_during returned -1. ";
+        msg += strerror (errno);
+        msg += ".\n";
+        add_err_message (msg);
         errno = 0;
         goto done;
     }
@@ -400,15 +538,17 @@ done:
 
 int dfu_impl_t::dom_exp (const jobmeta_t &meta, vtx_t u,
                          const vector<Resource> &resources,
-                         bool *excl, scoring_api_t &dfu)
+                         bool *excl, scoring_api_t &dfu, unsigned depth)
 {
     int rc = -1;
-    const subsystem_t &dom = m_match->dom_subsystem ();
-    for (auto &s : m_match->subsystems ()) {
+    intern_id_t dom = m_match->dom_subsystem_id ();
+    for (auto s : m_match->subsystem_ids ()) {
         if (s == dom)
-            rc = explore (meta, u, s, resources, excl, visit_t::DFV, dfu);
+            rc = explore (meta, u, s, resources, excl, visit_t::DFV, dfu,
+                          depth);
         else
-            rc = explore (meta, u, s, resources, excl, visit_t::UPV, dfu);
+            rc = explore (meta, u, s, resources, excl, visit_t::UPV, dfu,
+                          depth);
     }
     return rc;
 }
@@ -420,34 +560,35 @@ int dfu_impl_t::cnt_slot (const vector<Resource> &slot_shape,
     unsigned int fit = 0;
     unsigned int count = 0;
     unsigned int qual_num_slots = UINT_MAX;
-    const subsystem_t &dom = m_match->dom_subsystem ();
+    intern_id_t dom = m_match->dom_subsystem_id ();
 
     // qualifed slot count is determined by the most constrained resource type
     qual_num_slots = UINT_MAX;
     for (auto &slot_elem : slot_shape) {
-        qc = dfu_slot.qualified_count (dom, slot_elem.type);
+        qc = dfu_slot.qualified_count (dom, slot_elem.type_id);
         count = m_match->select_count (slot_elem, qc);
         fit = (count == 0)? count : (qc / count);
         qual_num_slots = (qual_num_slots > fit)? fit : qual_num_slots;
-        dfu_slot.rewind_iter_cur (dom, slot_elem.type);
+        dfu_slot.rewind_iter_cur (dom, slot_elem.type_id);
     }
     return qual_num_slots;
 }
 
 int dfu_impl_t::dom_slot (const jobmeta_t &meta, vtx_t u,
                           const vector<Resource> &slot_shape,
-                          bool *excl, scoring_api_t &dfu)
+                          bool *excl, scoring_api_t &dfu, unsigned depth)
 {
     int rc;
     bool x_inout = true;
     scoring_api_t dfu_slot;
     unsigned int qual_num_slots = 0;
-    const subsystem_t &dom = m_match->dom_subsystem ();
+    intern_id_t dom = m_match->dom_subsystem_id ();
 
     if ( (rc = explore (meta, u, dom, slot_shape,
-                        &x_inout, visit_t::DFV, dfu_slot)) != 0)
+                        &x_inout, visit_t::DFV, dfu_slot, depth)) != 0)
         goto done;
-    if ((rc = m_match->dom_finish_slot (dom, dfu_slot)) != 0)
+    if ((rc = m_match->dom_finish_slot (m_match->dom_subsystem (),
+                                        dfu_slot)) != 0)
         goto done;
 
     qual_num_slots = cnt_slot (slot_shape, dfu_slot);
@@ -456,23 +597,23 @@ int dfu_impl_t::dom_slot (const jobmeta_t &meta, vtx_t u,
         int score = MATCH_MET;
         for (auto &slot_elem : slot_shape) {
             unsigned int j = 0;
-            unsigned int qc = dfu_slot.qualified_count (dom, slot_elem.type);
+            unsigned int qc = dfu_slot.qualified_count (dom, slot_elem.type_id);
             unsigned int count = m_match->select_count (slot_elem, qc);
             while (j < count) {
-                auto egroup_i = dfu_slot.iter_cur (dom, slot_elem.type);
+                auto egroup_i = dfu_slot.iter_cur (dom, slot_elem.type_id);
                 eval_edg_t ev_edg ((*egroup_i).edges[0].count,
                                    (*egroup_i).edges[0].count, 1,
                                    (*egroup_i).edges[0].edge);
                 score += (*egroup_i).score;
                 edg_group.edges.push_back (ev_edg);
                 j += (*egroup_i).edges[0].count;
-                dfu_slot.incr_iter_cur (dom, slot_elem.type);
+                dfu_slot.incr_iter_cur (dom, slot_elem.type_id);
             }
         }
         edg_group.score = score;
         edg_group.count = 1;
         edg_group.exclusive = 1;
-        dfu.add (dom, string ("slot"), edg_group);
+        dfu.add (dom, slot_type_id, edg_group);
     }
 done:
     return (qual_num_slots)? 0 : -1;
@@ -480,7 +621,7 @@ done:
 
 int dfu_impl_t::dom_dfv (const jobmeta_t &meta, vtx_t u,
                          const vector<Resource> &resources, bool *excl,
-                         scoring_api_t &to_parent)
+                         scoring_api_t &to_parent, unsigned depth)
 {
     int rc = -1;
     match_kind_t sm;
@@ -489,29 +630,31 @@ int dfu_impl_t::dom_dfv (const jobmeta_t &meta, vtx_t u,
     bool x_in = *excl || exclusivity (resources, u);
     bool x_inout = x_in;
     scoring_api_t dfu;
-    planner_t *p = NULL;
+    planner1d_t *p = NULL;
     const string &dom = m_match->dom_subsystem ();
+    intern_id_t dom_id = m_match->dom_subsystem_id ();
     const vector<Resource> &next = test (u, resources, &sm);
 
-    if ((prune (meta, x_in, dom, u, resources) == -1)
+    if ((prune (meta, x_in, dom_id, u, resources) == -1)
         || (m_match->dom_discover_vtx (u, dom, resources, *m_graph) != 0))
         goto done;
 
-    (*m_graph)[u].idata.colors[dom] = m_color.gray (m_color_base);
+    set_color (dom_id, u, m_color.gray (m_color_base));
     if (sm == match_kind_t::SLOT_MATCH)
-        dom_slot (meta, u, next, &x_inout, dfu);
+        dom_slot (meta, u, next, &x_inout, dfu, depth);
     else
-        dom_exp (meta, u, next, &x_inout, dfu);
+        dom_exp (meta, u, next, &x_inout, dfu, depth);
     *excl = x_in;
-    (*m_graph)[u].idata.colors[dom] = m_color.black (m_color_base);
+    set_color (dom_id, u, m_color.black (m_color_base));
 
     p = (*m_graph)[u].schedule.plans;
-    if ( (avail = planner_avail_resources_during (p, at, duration, 0)) == 0) {
+    if ( (avail = planner1d_avail_resources_during (p, at, duration)) == 0) {
         goto done;
     } else if (avail == -1) {
-        m_err_msg += "dom_dfv: planner_avail_resources_during returned -1.\n";
-        m_err_msg += strerror (errno);
-        m_err_msg += ".\n";
+        string msg = "dom_dfv: planner1d_avail_resources_during returned -1.\n";
+        msg += strerror (errno);
+        msg += ".\n";
+        add_err_message (msg);
         errno = 0;
         goto done;
     }
@@ -537,7 +680,7 @@ int dfu_impl_t::resolve (vtx_t root, vector<Resource> &resources,
 
     *needs = 1; // if the root is not specified, assume we need 1
     for (auto &resource : resources) {
-        if (resource.type == (*m_graph)[root].type) {
+        if (resource.type_id == (*m_graph)[root].type_id) {
             qc = dfu.avail ();
             if ((count = m_match->select_count (resource, qc)) == 0)
                 goto done;
@@ -546,8 +689,8 @@ int dfu_impl_t::resolve (vtx_t root, vector<Resource> &resources,
     }
 
     // resolve remaining unconstrained resource types
-    for (auto &subsystem : m_match->subsystems ()) {
-        vector<string> types;
+    for (auto subsystem : m_match->subsystem_ids ()) {
+        vector<intern_id_t> types;
         dfu.resrc_types (subsystem, types);
         for (auto &type : types) {
             if (dfu.qualified_count (subsystem, type) == 0)
@@ -557,7 +700,7 @@ int dfu_impl_t::resolve (vtx_t root, vector<Resource> &resources,
         }
     }
     rc = 0;
-    for (auto subsystem : m_match->subsystems ())
+    for (auto subsystem : m_match->subsystem_ids ())
         rc += enforce (subsystem, dfu);
 done:
     return rc;
@@ -568,7 +711,7 @@ int dfu_impl_t::resolve (scoring_api_t &dfu, scoring_api_t &to_parent)
     int rc = 0;
     if (dfu.overall_score () > MATCH_UNMET) {
         if (dfu.hier_constrain_now ()) {
-            for (auto subsystem : m_match->subsystems ())
+            for (auto subsystem : m_match->subsystem_ids ())
                 rc += enforce (subsystem, dfu);
         }
         else {
@@ -578,11 +721,11 @@ int dfu_impl_t::resolve (scoring_api_t &dfu, scoring_api_t &to_parent)
     return rc;
 }
 
-int dfu_impl_t::enforce (const subsystem_t &subsystem, scoring_api_t &dfu)
+int dfu_impl_t::enforce (intern_id_t subsystem, scoring_api_t &dfu)
 {
     int rc = 0;
     try {
-        vector<string> resource_types;
+        vector<intern_id_t> resource_types;
         dfu.resrc_types (subsystem, resource_types);
         for (auto &t : resource_types) {
             int best_i = dfu.best_i (subsystem, t);
@@ -591,9 +734,10 @@ int dfu_impl_t::enforce (const subsystem_t &subsystem, scoring_api_t &dfu)
                     continue;
                 const eval_egroup_t &egroup = dfu.at (subsystem, t, i);
                 for (auto &e : egroup.edges) {
-                    (*m_graph)[e.edge].idata.needs = e.needs;
-                    (*m_graph)[e.edge].idata.best_k_cnt = m_best_k_cnt;
-                    (*m_graph)[e.edge].idata.exclusive = e.exclusive;
+                    edg_sel_t &sel = edge_sel (e.edge);
+                    sel.needs = e.needs;
+                    sel.best_k_cnt = m_best_k_cnt;
+                    sel.exclusive = e.exclusive;
                 }
             }
         }
@@ -620,7 +764,7 @@ int dfu_impl_t::emit_vertex (vtx_t u, unsigned int needs, bool exclusive,
     return 0;
 }
 
-int dfu_impl_t::upd_plan (vtx_t u, const subsystem_t &s, unsigned int needs,
+int dfu_impl_t::upd_plan (vtx_t u, intern_id_t s, unsigned int needs,
                            bool excl, const jobmeta_t &meta, int &n,
                            map<string, int64_t> &to_parent)
 {
@@ -628,19 +772,18 @@ int dfu_impl_t::upd_plan (vtx_t u, const subsystem_t &s, unsigned int needs,
     int64_t span = -1;
     int64_t at = meta.at;
     uint64_t duration = meta.duration;
-    const uint64_t u64needs = (const uint64_t)needs;
-    planner_t *plans = (*m_graph)[u].schedule.plans;
+    planner1d_t *plans = (*m_graph)[u].schedule.plans;
     n++;
 
-    if ( (span = planner_add_span (plans, at, duration, &u64needs, 1)) == -1) {
-        m_err_msg += "upd_plan: planner_add_span returned -1.\n";
+    if ( (span = planner1d_add_span (plans, at, duration, needs)) == -1) {
+        m_err_msg += "upd_plan: planner1d_add_span returned -1.\n";
         if (errno != 0) {
             m_err_msg += strerror (errno);
             errno = 0;
         }
         goto done;
     }
-    accum_if (s, (*m_graph)[u].type, needs, to_parent);
+    accum_if (s, (*m_graph)[u].type_id, (*m_graph)[u].type, needs, to_parent);
     if (meta.allocate)
         (*m_graph)[u].schedule.allocations[meta.jobid] = span;
     else
@@ -649,7 +792,7 @@ done:
     return span;
 }
 
-int dfu_impl_t::upd_sched (vtx_t u, const subsystem_t &s, unsigned int needs,
+int dfu_impl_t::upd_sched (vtx_t u, intern_id_t s, unsigned int needs,
                            bool excl, int n, const jobmeta_t &meta,
                            map<string, int64_t> &dfu,
                            map<string, int64_t> &to_parent, stringstream &ss)
@@ -660,12 +803,11 @@ int dfu_impl_t::upd_sched (vtx_t u, const subsystem_t &s, unsigned int needs,
 
     if (n > 0) {
         int64_t span = -1;
-        const uint64_t njobs = 1;
         // Tag on a vertex with exclusive access or all of its ancestors
         (*m_graph)[u].schedule.tags[meta.jobid] = meta.jobid;
         // Update x_checker used for quick exclusivity check during matching
-        planner_t *x_checkers = (*m_graph)[u].schedule.x_checker;
-        span = planner_add_span (x_checkers, meta.at, meta.duration, &njobs, 1);
+        planner1d_t *x_checkers = (*m_graph)[u].schedule.x_checker;
+        span = planner1d_add_span (x_checkers, meta.at, meta.duration, 1);
         (*m_graph)[u].schedule.x_spans[meta.jobid] = span;
 
         // Update subtree plan
@@ -685,8 +827,9 @@ int dfu_impl_t::upd_sched (vtx_t u, const subsystem_t &s, unsigned int needs,
             }
             (*m_graph)[u].idata.job2span[meta.jobid] = span;
         }
+        // dfu only holds the types the children have accumulated for s
         for (auto &kv : dfu)
-            accum_if (s, kv.first, kv.second, to_parent);
+            to_parent[kv.first] += kv.second;
         emit_vertex (u, needs, excl, ss);
     }
     m_trav_level--;
@@ -694,7 +837,7 @@ done:
     return n;
 }
 
-int dfu_impl_t::upd_upv (vtx_t u, const subsystem_t &subsystem,
+int dfu_impl_t::upd_upv (vtx_t u, intern_id_t subsystem,
                          unsigned int needs, bool excl, const jobmeta_t &meta,
                          map<string, int64_t> &to_parent)
 {
@@ -708,18 +851,19 @@ int dfu_impl_t::upd_dfv (vtx_t u, unsigned int needs, bool excl,
 {
     int n_plans = 0;
     map<string, int64_t> dfu;
-    const string &dom = m_match->dom_subsystem ();
+    intern_id_t dom = m_match->dom_subsystem_id ();
     graph_traits<f_resource_graph_t>::out_edge_iterator ei, ei_end;
     m_trav_level++;
-    for (auto &subsystem : m_match->subsystems ()) {
+    for (auto subsystem : m_match->subsystem_ids ()) {
         for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei) {
             if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem))
                 continue;
-            if ((*m_graph)[*ei].idata.best_k_cnt != m_best_k_cnt)
+            const edg_sel_t &sel = edge_sel (*ei);
+            if (sel.best_k_cnt != m_best_k_cnt)
                 continue;
 
-            bool x = (*m_graph)[*ei].idata.exclusive;
-            unsigned int needs = (*m_graph)[*ei].idata.needs;
+            bool x = sel.exclusive;
+            unsigned int needs = sel.needs;
             vtx_t tgt = target (*ei, *m_graph);
             if (subsystem == dom)
                 n_plans += upd_dfv (tgt, needs, x, meta, dfu, ss);
@@ -730,7 +874,7 @@ int dfu_impl_t::upd_dfv (vtx_t u, unsigned int needs, bool excl,
                 emit_edge (*ei);
         }
     }
-    (*m_graph)[u].idata.colors[dom] = m_color.black (m_color_base);
+    set_color (dom, u, m_color.black (m_color_base));
     return upd_sched (u, dom, needs, excl, n_plans, meta, dfu, to_parent, ss);
 }
 
@@ -758,10 +902,10 @@ int dfu_impl_t::rem_plan (vtx_t u, int64_t jobid)
     // No span on either table is an error condition.
 
     if (span != -1) {
-        planner_t *plans = (*m_graph)[u].schedule.plans;
-        rc = planner_rem_span (plans, span);
+        planner1d_t *plans = (*m_graph)[u].schedule.plans;
+        rc = planner1d_rem_span (plans, span);
         if (rc != 0) {
-            m_err_msg += "rem_plan: planner_rem_span returned -1.\n";
+            m_err_msg += "rem_plan: planner1d_rem_span returned -1.\n";
             m_err_msg += "rem_plan: " + (*m_graph)[u].name + ".\n";
             if (errno != 0) {
                 m_err_msg += strerror (errno);
@@ -788,10 +932,10 @@ int dfu_impl_t::rem_x_checker (vtx_t u, int64_t jobid)
     }
 
     if (span != -1) {
-        planner_t *x_checker = (*m_graph)[u].schedule.x_checker;
-        rc = planner_rem_span (x_checker, span);
+        planner1d_t *x_checker = (*m_graph)[u].schedule.x_checker;
+        rc = planner1d_rem_span (x_checker, span);
         if (rc != 0) {
-            m_err_msg += "rem_x_checker: planner_rem_span returned -1.\n";
+            m_err_msg += "rem_x_checker: planner1d_rem_span returned -1.\n";
             m_err_msg += "rem_x_checker: " + (*m_graph)[u].name + ".\n";
             if (errno != 0) {
                 m_err_msg += strerror (errno);
@@ -804,7 +948,7 @@ int dfu_impl_t::rem_x_checker (vtx_t u, int64_t jobid)
 }
 
 int dfu_impl_t::rem_subtree_plan (vtx_t u, int64_t jobid,
-                                  const string &subsystem)
+                                  intern_id_t subsystem)
 {
     int rc = 0;
     int span = -1;
@@ -820,6 +964,7 @@ int dfu_impl_t::rem_subtree_plan (vtx_t u, int64_t jobid,
         goto done;
     }
 
+    job2span.erase (jobid);
     rc = planner_rem_span (subtree_plan, span);
     if (rc != 0) {
         m_err_msg += "rem_subtree_plan: planner_rem_span returned -1.\n";
@@ -838,7 +983,7 @@ int dfu_impl_t::rem_dfv (vtx_t u, int64_t jobid)
 {
     int rc = 0;
     int64_t span = -1;
-    const string &dom = m_match->dom_subsystem ();
+    intern_id_t dom = m_match->dom_subsystem_id ();
     auto &tags = (*m_graph)[u].schedule.tags;
     graph_traits<f_resource_graph_t>::out_edge_iterator ei, ei_end;
 
@@ -852,7 +997,7 @@ int dfu_impl_t::rem_dfv (vtx_t u, int64_t jobid)
     if ( (rc = rem_subtree_plan (u, jobid, dom)) != 0)
         goto done;
 
-    for (auto &subsystem : m_match->subsystems ()) {
+    for (auto subsystem : m_match->subsystem_ids ()) {
         for (tie (ei, ei_end) = out_edges (u, *m_graph); ei != ei_end; ++ei) {
             if (!in_subsystem (*ei, subsystem) || stop_explore (*ei, subsystem))
                 continue;
@@ -867,6 +1012,45 @@ done:
     return rc;
 }
 
+int dfu_impl_t::adv_vtx (vtx_t u, int64_t now)
+{
+    int rc = 0;
+    schedule_t &sched = (*m_graph)[u].schedule;
+    pool_infra_t &idata = (*m_graph)[u].idata;
+
+    rc += planner1d_advance_base_time (sched.plans, now);
+    rc += planner1d_advance_base_time (sched.x_checker, now);
+    for (auto &kv : idata.subplans) {
+        if (kv.second)
+            rc += planner_advance_base_time (kv.second, now);
+    }
+    if (rc != 0) {
+        m_err_msg += "adv_vtx: advance_base_time returned -1.\n";
+        m_err_msg += "adv_vtx: " + (*m_graph)[u].name + ".\n";
+        if (errno != 0) {
+            m_err_msg += strerror (errno);
+            m_err_msg += ".\n";
+            errno = 0;
+        }
+        return -1;
+    }
+
+    // All spans of a job on a vertex share the same time window: a job whose
+    // x_checker span has expired is gone from every planner of the vertex.
+    for (auto it = sched.x_spans.begin (); it != sched.x_spans.end (); ) {
+        if (planner1d_is_active_span (sched.x_checker, it->second)) {
+            ++it;
+            continue;
+        }
+        sched.tags.erase (it->first);
+        sched.allocations.erase (it->first);
+        sched.reservations.erase (it->first);
+        idata.job2span.erase (it->first);
+        it = sched.x_spans.erase (it);
+    }
+    return 0;
+}
+
 
 /****************************************************************************
  *                                                                          *
@@ -889,6 +1073,7 @@ dfu_impl_t::dfu_impl_t (f_resource_graph_t *g, dfu_match_cb_t *m,
 dfu_impl_t::dfu_impl_t (const dfu_impl_t &o)
 {
     m_color = o.m_color;
+    m_ctx = o.m_ctx;
     m_best_k_cnt = o.m_best_k_cnt;
     m_color_base = o.m_color_base;
     m_trav_level = o.m_trav_level;
@@ -896,11 +1081,16 @@ dfu_impl_t::dfu_impl_t (const dfu_impl_t &o)
     m_graph = o.m_graph;
     m_match = o.m_match;
     m_err_msg = o.m_err_msg;
+    m_pool = o.m_pool;
+    m_par_depth = o.m_par_depth;
+    m_par_min_size = o.m_par_min_size;
+    m_subtree_sizes = o.m_subtree_sizes;
 }
 
 dfu_impl_t &dfu_impl_t::operator= (const dfu_impl_t &o)
 {
     m_color = o.m_color;
+    m_ctx = o.m_ctx;
     m_best_k_cnt = o.m_best_k_cnt;
     m_color_base = o.m_color_base;
     m_trav_level = o.m_trav_level;
@@ -908,6 +1098,10 @@ dfu_impl_t &dfu_impl_t::operator= (const dfu_impl_t &o)
     m_graph = o.m_graph;
     m_match = o.m_match;
     m_err_msg = o.m_err_msg;
+    m_pool = o.m_pool;
+    m_par_depth = o.m_par_depth;
+    m_par_min_size = o.m_par_min_size;
+    m_subtree_sizes = o.m_subtree_sizes;
     return *this;
 }
 
@@ -956,31 +1150,68 @@ void dfu_impl_t::clear_err_message ()
     m_err_msg = "";
 }
 
-int dfu_impl_t::prime (const subsystem_t &s, vtx_t u,
+int dfu_impl_t::set_parallel (unsigned n_threads, unsigned depth,
+                              uint64_t min_size)
+{
+    int rc = -1;
+    vtx_t root;
+    intern_id_t dom = INTERN_NONE;
+
+    if (n_threads == 0) {
+        rc = 0;
+        goto done;
+    }
+    if (!m_graph || !m_roots || !m_match
+        || m_roots->find (m_match->dom_subsystem ()) == m_roots->end ()) {
+        errno = EINVAL;
+        goto done;
+    }
+
+    // Explore tasks write the colors and edge selections of their subtrees
+    // without locking, which is only safe if no two subtrees share a vertex
+    dom = m_match->dom_subsystem_id ();
+    root = m_roots->at (m_match->dom_subsystem ());
+    m_subtree_sizes.assign (num_vertices (*m_graph), 0);
+    if (count_subtree (dom, root, graph_traits<f_resource_graph_t>
+                                      ::null_vertex ()) == -1) {
+        errno = ENOTSUP;
+        goto done;
+    }
+    if (!m_pool || m_pool->size () != n_threads)
+        m_pool = std::make_shared<work_pool_t> (n_threads);
+    m_par_depth = depth;
+    m_par_min_size = min_size;
+    return 0;
+
+done:
+    m_pool.reset ();
+    m_subtree_sizes.clear ();
+    return rc;
+}
+
+int dfu_impl_t::prime (intern_id_t s, vtx_t u,
                        map<string, int64_t> &to_parent)
 {
     int rc = -1;
     vector<uint64_t> avail;
     vector<const char *> types;
     map<string, int64_t> dfv;
-    string type = (*m_graph)[u].type;
+    const string &type = (*m_graph)[u].type;
 
-    (*m_graph)[u].idata.colors[s] = m_color.gray (m_color_base);
-    accum_if (s, type, (*m_graph)[u].size, to_parent);
+    set_color (s, u, m_color.gray (m_color_base));
+    accum_if (s, (*m_graph)[u].type_id, type, (*m_graph)[u].size, to_parent);
     if (prime_exp (s, u, dfv) != 0)
         goto done;
 
+    // dfv only holds the types the children have accumulated for s
     for (auto &aggregate : dfv) {
-        accum_if (s, aggregate.first, aggregate.second, to_parent);
+        to_parent[aggregate.first] += aggregate.second;
         types.push_back (strdup (aggregate.first.c_str ()));
         avail.push_back (aggregate.second);
     }
     if (!avail.empty () && !types.empty ()) {
         planner_t *p = NULL;
-        if (avail.size () > PLANNER_NUM_TYPES) {
-            m_err_msg += "prime: aggregate type count exceeds planner limit. ";
-            goto done;
-        } else if (!(p = subtree_plan (u, avail, types)) ) {
+        if (!(p = subtree_plan (u, avail, types)) ) {
             m_err_msg += "prime: error initializing a planner. ";
             m_err_msg += strerror (errno);
             errno = 0;
@@ -990,7 +1221,7 @@ int dfu_impl_t::prime (const subsystem_t &s, vtx_t u,
     }
     rc = 0;
 done:
-    (*m_graph)[u].idata.colors[s] = m_color.black (m_color_base);
+    set_color (s, u, m_color.black (m_color_base));
     if (!types.empty ())
         for (int i = 0; i < types.size (); ++i)
             free ((void *)types[i]);
@@ -1000,16 +1231,19 @@ done:
 void dfu_impl_t::prime (vector<Resource> &resources,
                         std::unordered_map<string, int64_t> &to_parent)
 {
-    const subsystem_t &subsystem = m_match->dom_subsystem ();
+    intern_id_t subsystem = m_match->dom_subsystem_id ();
     for (auto &resource : resources) {
         // Use minimum requirement because you don't want to prune search
         // as far as a subtree satisfies the minimum requirement
-        accum_if (subsystem, resource.type, resource.count.min, to_parent);
+        accum_if (subsystem, resource.type_id, resource.type,
+                  resource.count.min, to_parent);
+        // Recompute rather than add to what an earlier match of the same
+        // jobspec left in user_data
+        resource.user_data.clear ();
         prime (resource.with, resource.user_data);
-        for (auto &aggregate : resource.user_data) {
-            accum_if (subsystem, aggregate.first,
-                      resource.count.min * aggregate.second, to_parent);
-        }
+        // user_data only holds the types accumulated for subsystem
+        for (auto &aggregate : resource.user_data)
+            to_parent[aggregate.first] += resource.count.min * aggregate.second;
     }
 }
 
@@ -1019,15 +1253,17 @@ int dfu_impl_t::select (Jobspec::Jobspec &j, vtx_t root, jobmeta_t &meta,
     int rc = -1;
     scoring_api_t dfu;
     bool x_in = excl;
-    const string &dom = m_match->dom_subsystem ();
+    intern_id_t dom = m_match->dom_subsystem_id ();
 
     tick ();
-    rc = dom_dfv (meta, root, j.resources, &x_in, dfu);
+    if (m_pool)
+        presize_ctx (dom);
+    rc = dom_dfv (meta, root, j.resources, &x_in, dfu, 0);
     if (rc == 0) {
         eval_edg_t ev_edg (dfu.avail (), dfu.avail (), excl);
         eval_egroup_t egrp (dfu.overall_score (), dfu.avail (), 0, excl, true);
         egrp.edges.push_back (ev_edg);
-        dfu.add (dom, (*m_graph)[root].type, egrp);
+        dfu.add (dom, (*m_graph)[root].type_id, egrp);
         rc = resolve (root, j.resources, dfu, excl, needs);
     }
     return rc;
@@ -1047,6 +1283,15 @@ int dfu_impl_t::remove (vtx_t root, int64_t jobid)
     return rem_dfv (root, jobid);
 }
 
+int dfu_impl_t::advance (int64_t now)
+{
+    int rc = 0;
+    f_vtx_iterator vi, v_end;
+    for (tie (vi, v_end) = vertices (*m_graph); vi != v_end; ++vi)
+        rc += adv_vtx (*vi, now);
+    return (rc == 0)? 0 : -1;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
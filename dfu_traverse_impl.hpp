@@ -28,13 +28,17 @@
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
+#include <mutex>
+#include <memory>
 #include "system_defaults.hpp"
 #include "resource_data.hpp"
 #include "resource_graph.hpp"
 #include "dfu_match_cb.hpp"
 #include "scoring_api.hpp"
 #include "jobspec.hpp"
+#include "work_pool.hpp"
 #include "planner/planner.h"
+#include "planner/planner1d.h"
 
 namespace Flux {
 namespace resource_model {
@@ -65,6 +69,23 @@ struct jobmeta_t {
     }
 };
 
+//! Selection that enforce records on an edge for the update walk
+struct edg_sel_t {
+    uint64_t needs = 0;
+    uint64_t best_k_cnt = 0;
+    int exclusive = 0;
+};
+
+/*! Scratch state of the traversals of one traverser: the visit colors of
+ *  the vertices for each subsystem and the selection on each edge, indexed
+ *  by vertex and by edge index (resource_relation_t::idx). Keeping it out
+ *  of the resource graph lets several traversers walk one graph at once.
+ */
+struct trav_ctx_t {
+    std::vector<std::vector<uint64_t> > colors; //!< [subsystem id][vertex]
+    std::vector<edg_sel_t> edges;               //!< [edge index]
+};
+
 /*! implementation class of dfu_traverser_t
  */
 class dfu_impl_t {
@@ -87,6 +108,19 @@ public:
     void set_match_cb (dfu_match_cb_t *m);
     void clear_err_message ();
 
+    /*! Explore the children of the dominant subsystem vertices that are less
+     *  than depth below the root and root subtrees of at least min_size
+     *  vertices as tasks on a pool of n_threads worker threads. n_threads
+     *  of 0 turns parallel exploration off. The graph, roots and match
+     *  callback must already be set.
+     *
+     *  \return          0 on success; -1 on error, leaving exploration
+     *                   serial.
+     *                       EINVAL: graph, roots or match callback not set.
+     *                       ENOTSUP: the dominant subsystem is not a tree.
+     */
+    int set_parallel (unsigned n_threads, unsigned depth, uint64_t min_size);
+
     /*! Exclusive request? Return true if a resource in resources vector
      *  matches resource vertex u and its exclusivity field value is TRUE.
      *  (Note that when the system default configuration is added, it can
@@ -107,12 +141,13 @@ public:
      *  provides an interface to configure what subtree resources will be tracked
      *  by higher-level resource vertices.
      *
-     *  \param subsystem depth-first walk on this subsystem graph for priming.
+     *  \param subsystem depth-first walk on this subsystem graph for priming
+     *                   (interned subsystem id).
      *  \param u         visiting resource vertex.
      *  \return          0 on success; -1 on error -- call err_message ()
      *                   for detail.
      */
-    int prime (const subsystem_t &subsystem, vtx_t u,
+    int prime (intern_id_t subsystem, vtx_t u,
                std::map<std::string, int64_t> &to_parent);
 
     /*! Prime the resource section of the jobspec. Aggregate configured
@@ -196,23 +231,39 @@ public:
      */
     int remove (vtx_t root, int64_t jobid);
 
+    /*! Advance the base time of every planner in the resource graph to now
+     *  and forget the jobs that are over by then (see
+     *  planner_advance_base_time).
+     *
+     *  \param now       new base time.
+     *  \return          0 on success; -1 on error -- call err_message ()
+     *                   for detail.
+     */
+    int advance (int64_t now);
+
 private:
     const std::string level () const;
 
     void tick ();
     void tick_color_base ();
-    bool in_subsystem (edg_t e, const subsystem_t &subsystem) const;
-    bool stop_explore (edg_t e, const subsystem_t &subsystem) const;
+    uint64_t color (intern_id_t subsystem, vtx_t u) const;
+    void set_color (intern_id_t subsystem, vtx_t u, uint64_t c);
+    edg_sel_t &edge_sel (edg_t e);
+    bool in_subsystem (edg_t e, intern_id_t subsystem) const;
+    bool stop_explore (edg_t e, intern_id_t subsystem) const;
+    void add_err_message (const std::string &msg);
+    void presize_ctx (intern_id_t subsystem);
+    int64_t count_subtree (intern_id_t subsystem, vtx_t u, vtx_t parent);
 
     /*! Various pruning methods
      */
-    int by_avail (const jobmeta_t &meta, const std::string &s, vtx_t u,
+    int by_avail (const jobmeta_t &meta, intern_id_t s, vtx_t u,
                   const std::vector<Jobspec::Resource> &resources);
-    int by_excl (const jobmeta_t &meta, const std::string &s, vtx_t u,
+    int by_excl (const jobmeta_t &meta, intern_id_t s, vtx_t u,
                  const Jobspec::Resource &resource);
-    int by_subplan (const jobmeta_t &meta, const std::string &s, vtx_t u,
+    int by_subplan (const jobmeta_t &meta, intern_id_t s, vtx_t u,
                     const Jobspec::Resource &resource);
-    int prune (const jobmeta_t &meta, bool excl, const std::string &subsystem,
+    int prune (const jobmeta_t &meta, bool excl, intern_id_t subsystem,
                vtx_t u, const std::vector<Jobspec::Resource> &resources);
 
     planner_t *subtree_plan (vtx_t u, std::vector<uint64_t> &avail,
@@ -231,36 +282,43 @@ private:
     /*! Accumulate count into accum if type matches with one of the resource
      *  types used in the scheduler-driven aggregate update (SDAU) scheme.
      *  dfu_match_cb_t provides an interface to configure what types are used
-     *  for SDAU scheme.
+     *  for SDAU scheme. The type is given both by its interned id (type_id)
+     *  and by its name (type), the key of accum.
      */
-    int accum_if (const subsystem_t &subsystem, const std::string &type,
-                  unsigned int count, std::map<std::string, int64_t> &accum);
-    int accum_if (const subsystem_t &subsystem, const std::string &type,
-                  unsigned int count,
+    int accum_if (intern_id_t subsystem, intern_id_t type_id,
+                  const std::string &type, unsigned int count,
+                  std::map<std::string, int64_t> &accum);
+    int accum_if (intern_id_t subsystem, intern_id_t type_id,
+                  const std::string &type, unsigned int count,
                   std::unordered_map<std::string, int64_t> &accum);
 
     // Explore out-edges for priming the subtree plans
-    int prime_exp (const subsystem_t &subsystem,
+    int prime_exp (intern_id_t subsystem,
                    vtx_t u, std::map<std::string, int64_t> &dfv);
 
     // Explore for resource matching -- only DFV or UPV
-    int explore (const jobmeta_t &meta, vtx_t u, const subsystem_t &subsystem,
+    int explore (const jobmeta_t &meta, vtx_t u, intern_id_t subsystem,
                  const std::vector<Jobspec::Resource> &resources, bool *excl,
-                 visit_t direction, scoring_api_t &to_parent);
-    int aux_upv (const jobmeta_t &meta, vtx_t u, const subsystem_t &subsystem,
+                 visit_t direction, scoring_api_t &to_parent, unsigned depth);
+    int explore_par (const jobmeta_t &meta, vtx_t u, intern_id_t subsystem,
+                     const std::vector<Jobspec::Resource> &resources,
+                     bool *excl, scoring_api_t &to_parent, unsigned depth);
+    void add_child (intern_id_t subsystem, edg_t e, bool x_inout,
+                    scoring_api_t &to_parent);
+    int aux_upv (const jobmeta_t &meta, vtx_t u, intern_id_t subsystem,
                  const std::vector<Jobspec::Resource> &resources, bool *excl,
                  scoring_api_t &to_parent);
     int cnt_slot (const std::vector<Jobspec::Resource> &slot_shape,
                   scoring_api_t &dfu_slot);
     int dom_slot (const jobmeta_t &meta, vtx_t u,
                   const std::vector<Jobspec::Resource> &resources, bool *excl,
-                  scoring_api_t &dfu);
+                  scoring_api_t &dfu, unsigned depth);
     int dom_exp (const jobmeta_t &meta, vtx_t u,
                  const std::vector<Jobspec::Resource> &resources, bool *excl,
-                 scoring_api_t &to_parent);
+                 scoring_api_t &to_parent, unsigned depth);
     int dom_dfv (const jobmeta_t &meta, vtx_t u,
                  const std::vector<Jobspec::Resource> &resources, bool *excl,
-                 scoring_api_t &to_parent);
+                 scoring_api_t &to_parent, unsigned depth);
 
     // Emit R
     int emit_edge (edg_t e);
@@ -268,15 +326,15 @@ private:
                      std::stringstream &ss);
 
     // Update resource graph data store
-    int upd_plan (vtx_t u, const subsystem_t &s, unsigned int needs,
+    int upd_plan (vtx_t u, intern_id_t s, unsigned int needs,
                   bool excl, const jobmeta_t &meta, int &n_p,
                   std::map<std::string, int64_t> &to_parent);
-    int upd_sched (vtx_t u, const subsystem_t &subsystem, unsigned int needs,
+    int upd_sched (vtx_t u, intern_id_t subsystem, unsigned int needs,
                    bool excl, int n, const jobmeta_t &meta,
                    std::map<std::string, int64_t> &dfu,
                    std::map<std::string, int64_t> &to_parent,
                    std::stringstream &ss);
-    int upd_upv (vtx_t u, const subsystem_t &subsystem, unsigned int needs,
+    int upd_upv (vtx_t u, intern_id_t subsystem, unsigned int needs,
                  bool excl, const jobmeta_t &meta,
                  std::map<std::string, int64_t> &to_parent);
     int upd_dfv (vtx_t u, unsigned int needs,
@@ -285,20 +343,24 @@ private:
                  std::stringstream &ss);
 
     // Remove allocation or reservations
-    int rem_subtree_plan (vtx_t u, int64_t jobid, const std::string &subsystem);
+    int rem_subtree_plan (vtx_t u, int64_t jobid, intern_id_t subsystem);
     int rem_x_checker (vtx_t u, int64_t jobid);
     int rem_plan (vtx_t u, int64_t jobid);
     int rem_dfv (vtx_t u, int64_t jobid);
     int rem_upv (vtx_t u, int64_t jobid);
 
+    // Advance the base time of the schedule
+    int adv_vtx (vtx_t u, int64_t now);
+
     // Resolve and enforce hierarchical constraints
     int resolve (vtx_t root, std::vector<Jobspec::Resource> &resources,
                  scoring_api_t &dfu, bool excl, unsigned int *needs);
     int resolve (scoring_api_t &dfu, scoring_api_t &to_parent);
-    int enforce (const subsystem_t &subsystem, scoring_api_t &dfu);
+    int enforce (intern_id_t subsystem, scoring_api_t &dfu);
 
     // member data
     color_t m_color;
+    trav_ctx_t m_ctx;
     uint64_t m_best_k_cnt = 0;
     uint64_t m_color_base = 0;
     unsigned int m_trav_level = 0;
@@ -306,6 +368,11 @@ private:
     f_resource_graph_t *m_graph = NULL;
     dfu_match_cb_t *m_match = NULL;
     std::string m_err_msg = "";
+    std::mutex m_err_lock;
+    std::shared_ptr<work_pool_t> m_pool;
+    unsigned m_par_depth = 0;
+    uint64_t m_par_min_size = 0;
+    std::vector<uint64_t> m_subtree_sizes; //!< dominant subtree, [vertex]
 }; // the end of class dfu_impl_t
 
 template <class lookup_t>
@@ -315,6 +382,7 @@ int dfu_impl_t::count (planner_t *plan, const lookup_t &lookup,
     int rc = 0;
     size_t len = planner_resources_len (plan);
     const char **resource_types = planner_resource_types (plan);
+    resource_counts.reserve (len);
     for (int i = 0; i < len; ++i) {
         if (lookup.find (resource_types[i]) != lookup.end ()) {
             uint64_t n = (uint64_t)lookup.at (resource_types[i]);
@@ -0,0 +1,108 @@
+/*****************************************************************************\
+ *  Copyright (c) 2017 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef INTERN_HPP
+#define INTERN_HPP
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace Flux {
+
+//! Small integer id of an interned name; ids are dense and start at 0.
+typedef int intern_id_t;
+const intern_id_t INTERN_NONE = -1;
+
+/*! Table of interned names. Each distinct name is given the next id the
+ *  first time it is interned and keeps it for the life of the process, so
+ *  equal names compare as equal ids. The traverser's hot path then compares
+ *  and indexes by id instead of comparing and hashing strings.
+ */
+class intern_table_t {
+public:
+    /*! Return the id of name, giving it a new one if it has none yet. */
+    intern_id_t intern (const std::string &name)
+    {
+        std::lock_guard<std::mutex> guard (m_lock);
+        auto i = m_ids.find (name);
+        if (i != m_ids.end ())
+            return i->second;
+        intern_id_t id = (intern_id_t)m_names.size ();
+        m_names.push_back (name);
+        m_ids.insert (std::make_pair (name, id));
+        return id;
+    }
+
+    /*! Return the id of name; INTERN_NONE if it has never been interned. */
+    intern_id_t find (const std::string &name) const
+    {
+        std::lock_guard<std::mutex> guard (m_lock);
+        auto i = m_ids.find (name);
+        return (i != m_ids.end ())? i->second : INTERN_NONE;
+    }
+
+    /*! Return the name of id. Names are never moved once interned, so the
+     *  reference stays valid. Can throw an out_of_range exception.
+     */
+    const std::string &name (intern_id_t id) const
+    {
+        std::lock_guard<std::mutex> guard (m_lock);
+        return m_names.at (id);
+    }
+
+    size_t size () const
+    {
+        std::lock_guard<std::mutex> guard (m_lock);
+        return m_names.size ();
+    }
+
+private:
+    mutable std::mutex m_lock;
+    std::deque<std::string> m_names;
+    std::unordered_map<std::string, intern_id_t> m_ids;
+};
+
+//! Subsystem names (e.g., containment)
+inline intern_table_t &subsystem_ids ()
+{
+    static intern_table_t table;
+    return table;
+}
+
+//! Resource type names of the resource graph and jobspecs (e.g., core)
+inline intern_table_t &resource_type_ids ()
+{
+    static intern_table_t table;
+    return table;
+}
+
+} // namespace Flux
+
+#endif // INTERN_HPP
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
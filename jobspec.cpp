@@ -149,6 +149,7 @@ Resource::Resource (const YAML::Node &resnode)
                            "Value of \"type\" must be a scalar");
     }
     type = resnode["type"].as<string>();
+    type_id = resource_type_ids ().intern (type);
     field_count++;
 
     if (!resnode["count"]) {
@@ -49,6 +49,7 @@
 #include <unordered_map>
 #include <cstdint>
 #include <yaml-cpp/yaml.h>
+#include "intern.hpp"
 
 namespace Flux {
 namespace Jobspec {
@@ -67,6 +68,7 @@ enum class tristate_t { FALSE, TRUE, UNSPECIFIED };
 class Resource {
 public:
     std::string type;
+    intern_id_t type_id = INTERN_NONE; // type interned in resource_type_ids
     struct {
         unsigned min;
         unsigned max;
@@ -31,6 +31,7 @@
 #include <set>
 #include <map>
 #include "jobspec.hpp"
+#include "resource_data.hpp"
 #include "planner/planner.h"
 
 namespace Flux {
@@ -59,23 +60,29 @@ public:
     matcher_data_t (const std::string &name) : m_name (name) { }
     matcher_data_t (const matcher_data_t &o)
     {
-       sdau_resource_types = o.sdau_resource_types;
+       m_sdau_resource_types = o.m_sdau_resource_types;
+       m_sdau_ids = o.m_sdau_ids;
        m_name = o.m_name;
        m_subsystems = o.m_subsystems;
+       m_subsystem_ids = o.m_subsystem_ids;
        m_subsystems_map = o.m_subsystems_map;
     }
     matcher_data_t &operator=(const matcher_data_t &o)
     {
-       sdau_resource_types = o.sdau_resource_types;
+       m_sdau_resource_types = o.m_sdau_resource_types;
+       m_sdau_ids = o.m_sdau_ids;
        m_name = o.m_name;
        m_subsystems = o.m_subsystems;
+       m_subsystem_ids = o.m_subsystem_ids;
        m_subsystems_map = o.m_subsystems_map;
        return *this;
     }
     ~matcher_data_t ()
     {
-        sdau_resource_types.clear ();
+        m_sdau_resource_types.clear ();
+        m_sdau_ids.clear ();
         m_subsystems.clear ();
+        m_subsystem_ids.clear ();
         m_subsystems_map.clear ();
     }
 
@@ -98,6 +105,7 @@ public:
     {
         if (m_subsystems_map.find (s) == m_subsystems_map.end ()) {
             m_subsystems.push_back (s);
+            m_subsystem_ids.push_back (Flux::subsystem_ids ().intern (s));
             m_subsystems_map[s].insert (tf);
             return 0;
         }
@@ -116,6 +124,27 @@ public:
         return m_subsystems;
     }
 
+    /*
+     * \return           the interned ids of subsystems () in the same order.
+     */
+    const std::vector<intern_id_t> &subsystem_ids () const
+    {
+        return m_subsystem_ids;
+    }
+
+    /*
+     * \return           the name of the selected subsystem whose interned
+     *                   id is id. Unlike the intern table, this takes no
+     *                   lock, so it can be called while traversing.
+     */
+    const subsystem_t &subsystem_name (intern_id_t id) const
+    {
+        size_t i = 0;
+        while (i + 1 < m_subsystem_ids.size () && m_subsystem_ids[i] != id)
+            i++;
+        return m_subsystems[i];
+    }
+
     /*
      * \return           return the dominant subsystem this matcher has
      *                   selected to use.
@@ -124,6 +153,10 @@ public:
     {
         return *(m_subsystems.begin());
     }
+    intern_id_t dom_subsystem_id () const
+    {
+        return *(m_subsystem_ids.begin());
+    }
 
     /*
      * \return           return the subsystem selector to be used for
@@ -134,7 +167,33 @@ public:
         return m_subsystems_map;
     }
 
-    std::map<subsystem_t, std::set<std::string> > sdau_resource_types;
+    /*! Track resource type t in the scheduler-driven aggregate update
+     *  (SDAU) scheme of subsystem s: the subtree planners of s aggregate
+     *  the resources of type t under their vertex.
+     */
+    void add_sdau_resource_type (const subsystem_t &s, const std::string &t)
+    {
+        size_t sid = Flux::subsystem_ids ().intern (s);
+        size_t tid = resource_type_ids ().intern (t);
+        m_sdau_resource_types[s].insert (t);
+        if (m_sdau_ids.size () <= sid)
+            m_sdau_ids.resize (sid + 1);
+        if (m_sdau_ids[sid].size () <= tid)
+            m_sdau_ids[sid].resize (tid + 1, false);
+        m_sdau_ids[sid][tid] = true;
+    }
+    const std::map<subsystem_t, std::set<std::string> > &
+        sdau_resource_types () const
+    {
+        return m_sdau_resource_types;
+    }
+
+    /*! Is the type of id t tracked in the SDAU scheme of subsystem id s? */
+    bool sdau_tracked (intern_id_t s, intern_id_t t) const
+    {
+        return s >= 0 && t >= 0 && (size_t)s < m_sdau_ids.size ()
+               && (size_t)t < m_sdau_ids[s].size () && m_sdau_ids[s][t];
+    }
 
     unsigned int select_count (const Flux::Jobspec::Resource &resource,
                                unsigned int qc) const
@@ -181,7 +240,10 @@ public:
 private:
     std::string m_name;
     std::vector<subsystem_t> m_subsystems;
+    std::vector<intern_id_t> m_subsystem_ids;
     multi_subsystemsS m_subsystems_map;
+    std::map<subsystem_t, std::set<std::string> > m_sdau_resource_types;
+    std::vector<std::vector<bool> > m_sdau_ids; //!< [subsystem id][type id]
 };
 
 } // namespace resource_model
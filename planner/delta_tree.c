@@ -0,0 +1,522 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "rbtree.h"
+#include "rbtree_augmented.h"
+#include "xzmalloc.h"
+#include "delta_tree.h"
+
+typedef struct delta_point {
+    struct rb_node rb;           /* BST node keyed by time */
+    int64_t at;                  /* resource-state changing time */
+    int ref_count;               /* number of span end points at this time */
+    int dim;                     /* number of resource types */
+    int64_t *delta;              /* change of scheduled resources at */
+    int64_t *sum;                /* sum of deltas in the subtree */
+    int64_t *max;                /* max prefix sum within the subtree */
+    int64_t *min;                /* min prefix sum within the subtree */
+    int64_t arrays[];            /* storage for the above four arrays */
+} delta_point_t;
+
+#define DELTA_ENTRY(n) rb_entry ((n), delta_point_t, rb)
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                        Subtree Prefix Sum Augmentation                      *
+ *                                                                             *
+ *******************************************************************************/
+
+/*! Recompute the aggregates of p from its children. Return true if any of them
+ *  changed.
+ */
+static bool delta_compute (delta_point_t *p)
+{
+    int i = 0;
+    bool changed = false;
+    delta_point_t *l = p->rb.rb_left? DELTA_ENTRY (p->rb.rb_left) : NULL;
+    delta_point_t *r = p->rb.rb_right? DELTA_ENTRY (p->rb.rb_right) : NULL;
+    for (i = 0; i < p->dim; ++i) {
+        int64_t pre = (l? l->sum[i] : 0) + p->delta[i];
+        int64_t sum = pre + (r? r->sum[i] : 0);
+        int64_t max = pre;
+        int64_t min = pre;
+        if (l && l->max[i] > max)
+            max = l->max[i];
+        if (l && l->min[i] < min)
+            min = l->min[i];
+        if (r && pre + r->max[i] > max)
+            max = pre + r->max[i];
+        if (r && pre + r->min[i] < min)
+            min = pre + r->min[i];
+        if (sum != p->sum[i] || max != p->max[i] || min != p->min[i]) {
+            p->sum[i] = sum;
+            p->max[i] = max;
+            p->min[i] = min;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static void delta_propagate (struct rb_node *n, struct rb_node *stop)
+{
+    while (n != stop) {
+        if (!delta_compute (DELTA_ENTRY (n)))
+            break;
+        n = rb_parent (n);
+    }
+}
+
+static void delta_copy (struct rb_node *src, struct rb_node *dst)
+{
+    delta_point_t *o = DELTA_ENTRY (src);
+    delta_point_t *n = DELTA_ENTRY (dst);
+    memcpy (n->sum, o->sum, o->dim * sizeof (*n->sum));
+    memcpy (n->max, o->max, o->dim * sizeof (*n->max));
+    memcpy (n->min, o->min, o->dim * sizeof (*n->min));
+}
+
+static void delta_rotate (struct rb_node *src, struct rb_node *dst)
+{
+    // dst takes over src's subtree as is; src now roots a smaller one
+    delta_copy (src, dst);
+    delta_compute (DELTA_ENTRY (src));
+}
+
+static const struct rb_augment_callbacks delta_aug_cb = {
+    delta_propagate, delta_copy, delta_rotate
+};
+
+/*! The delta of n changed: refresh every aggregate on the path to the root.
+ */
+static void delta_refresh (struct rb_node *n)
+{
+    for (; n; n = rb_parent (n))
+        delta_compute (DELTA_ENTRY (n));
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                            Delta Point Management                           *
+ *                                                                             *
+ *******************************************************************************/
+
+static delta_point_t *delta_search (delta_tree_t *t, int64_t at)
+{
+    struct rb_node *node = t->root.rb_node;
+    while (node) {
+        delta_point_t *this_data = DELTA_ENTRY (node);
+        if (at < this_data->at)
+            node = node->rb_left;
+        else if (at > this_data->at)
+            node = node->rb_right;
+        else
+            return this_data;
+    }
+    return NULL;
+}
+
+static delta_point_t *delta_get_or_new (delta_tree_t *t, int64_t at)
+{
+    struct rb_node **link = &(t->root.rb_node);
+    struct rb_node *parent = NULL;
+    delta_point_t *point = NULL;
+    while (*link) {
+        delta_point_t *this_data = DELTA_ENTRY (*link);
+        parent = *link;
+        if (at < this_data->at)
+            link = &((*link)->rb_left);
+        else if (at > this_data->at)
+            link = &((*link)->rb_right);
+        else
+            return this_data;
+    }
+    // a new point has a zero delta but can still move the prefix extremes
+    // of its ancestors, so refresh the path before rebalancing.
+    point = slab_alloc (&(t->pool));
+    point->at = at;
+    point->dim = t->dimension;
+    point->delta = point->arrays;
+    point->sum = point->arrays + t->dimension;
+    point->max = point->arrays + 2 * t->dimension;
+    point->min = point->arrays + 3 * t->dimension;
+    rb_link_node (&(point->rb), parent, link);
+    delta_refresh (&(point->rb));
+    rb_insert_augmented (&(point->rb), &(t->root), &delta_aug_cb);
+    return point;
+}
+
+static void delta_put (delta_tree_t *t, delta_point_t *point)
+{
+    if (--point->ref_count > 0)
+        return;
+    rb_erase_augmented (&(point->rb), &(t->root), &delta_aug_cb);
+    slab_free (&(t->pool), point);
+}
+
+void delta_tree_init (delta_tree_t *t, int64_t base_time, size_t dimension)
+{
+    delta_point_t *p0 = NULL;
+    t->root = RB_ROOT;
+    t->dimension = dimension;
+    slab_pool_init (&(t->pool), sizeof (delta_point_t)
+                                + 4 * dimension * sizeof (int64_t));
+    p0 = delta_get_or_new (t, base_time);
+    p0->ref_count = 1;
+}
+
+void delta_tree_release (delta_tree_t *t)
+{
+    t->root = RB_ROOT;
+    slab_pool_release (&(t->pool));
+}
+
+/*! Copy the subtree rooted at n with the same shape, colors and aggregates,
+ *  so the copy neither compares keys nor rebalances.
+ */
+static struct rb_node *delta_clone (delta_tree_t *t, const struct rb_node *n,
+                                    struct rb_node *parent)
+{
+    const delta_point_t *o = NULL;
+    delta_point_t *c = NULL;
+    if (!n)
+        return NULL;
+    o = DELTA_ENTRY (n);
+    c = slab_alloc (&(t->pool));
+    memcpy (c, o, sizeof (*o) + 4 * t->dimension * sizeof (int64_t));
+    c->delta = c->arrays;
+    c->sum = c->arrays + t->dimension;
+    c->max = c->arrays + 2 * t->dimension;
+    c->min = c->arrays + 3 * t->dimension;
+    rb_set_parent_color (&(c->rb), parent, rb_color (n));
+    c->rb.rb_left = delta_clone (t, n->rb_left, &(c->rb));
+    c->rb.rb_right = delta_clone (t, n->rb_right, &(c->rb));
+    return &(c->rb);
+}
+
+void delta_tree_clone (delta_tree_t *dst, const delta_tree_t *src)
+{
+    dst->dimension = src->dimension;
+    slab_pool_init (&(dst->pool), sizeof (delta_point_t)
+                                  + 4 * src->dimension * sizeof (int64_t));
+    dst->root.rb_node = delta_clone (dst, src->root.rb_node, NULL);
+}
+
+size_t delta_tree_size (delta_tree_t *t)
+{
+    return t->pool.n_live;
+}
+
+void delta_tree_walk (delta_tree_t *t, delta_tree_walk_f cb, void *arg)
+{
+    size_t i = 0;
+    int64_t scheduled[t->dimension];
+    struct rb_node *n = NULL;
+    memset (scheduled, 0, sizeof (scheduled));
+    for (n = rb_first (&(t->root)); n; n = rb_next (n)) {
+        delta_point_t *p = DELTA_ENTRY (n);
+        for (i = 0; i < t->dimension; ++i)
+            scheduled[i] += p->delta[i];
+        cb (p->at, p->ref_count, scheduled, arg);
+    }
+}
+
+void delta_tree_build (delta_tree_t *t, size_t dimension, size_t n,
+                       const int64_t *at, const int64_t *ref_count,
+                       const int64_t *scheduled)
+{
+    size_t i = 0, j = 0;
+    struct rb_node *node = NULL;
+    struct rb_node **nodes = xzmalloc (n * sizeof (*nodes));
+    t->dimension = dimension;
+    slab_pool_init (&(t->pool), sizeof (delta_point_t)
+                                + 4 * dimension * sizeof (int64_t));
+    for (i = 0; i < n; ++i) {
+        delta_point_t *p = slab_alloc (&(t->pool));
+        const int64_t *s = scheduled + i * dimension;
+        p->at = at[i];
+        p->ref_count = (int)ref_count[i];
+        p->dim = dimension;
+        p->delta = p->arrays;
+        p->sum = p->arrays + dimension;
+        p->max = p->arrays + 2 * dimension;
+        p->min = p->arrays + 3 * dimension;
+        for (j = 0; j < dimension; ++j)
+            p->delta[j] = (i == 0)? s[j] : s[j] - s[j - dimension];
+        nodes[i] = &(p->rb);
+    }
+    rb_build_sorted (nodes, n, &(t->root));
+    for (node = rb_first_postorder (&(t->root)); node;
+         node = rb_next_postorder (node))
+        delta_compute (DELTA_ENTRY (node));
+    free (nodes);
+}
+
+int delta_tree_update (delta_tree_t *t, int64_t start, int64_t last,
+                       const int64_t *counts, int sign)
+{
+    int i = 0;
+    delta_point_t *start_p = NULL;
+    delta_point_t *last_p = NULL;
+    if (sign > 0) {
+        start_p = delta_get_or_new (t, start);
+        start_p->ref_count++;
+        last_p = delta_get_or_new (t, last);
+        last_p->ref_count++;
+    } else if (!(start_p = delta_search (t, start))
+               || !(last_p = delta_search (t, last))) {
+        return -1;
+    }
+    for (i = 0; i < t->dimension; ++i) {
+        start_p->delta[i] += sign * counts[i];
+        last_p->delta[i] -= sign * counts[i];
+    }
+    delta_refresh (&(start_p->rb));
+    delta_refresh (&(last_p->rb));
+    if (sign < 0) {
+        delta_put (t, start_p);
+        delta_put (t, last_p);
+    }
+    return 0;
+}
+
+void delta_tree_advance (delta_tree_t *t, int64_t now, int ref_count)
+{
+    int64_t scheduled[t->dimension];
+    struct rb_node *n = NULL;
+    delta_point_t *p0 = NULL;
+    delta_tree_state (t, now, scheduled);
+    p0 = delta_get_or_new (t, now);
+    while ((n = rb_first (&(t->root))) != &(p0->rb)) {
+        rb_erase_augmented (n, &(t->root), &delta_aug_cb);
+        slab_free (&(t->pool), DELTA_ENTRY (n));
+    }
+    // p0 now comes first: its delta is the whole state at now
+    memcpy (p0->delta, scheduled, t->dimension * sizeof (*p0->delta));
+    p0->ref_count = ref_count;
+    delta_refresh (&(p0->rb));
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                      Window Queries: O(log n) Descents                      *
+ *                                                                             *
+ *******************************************************************************/
+
+/* Each descent carries the prefix sum of everything left of the visited
+ * subtree (base) and whether the subtree lies entirely at or after lo (lo_in)
+ * and entirely before hi (hi_in). Subtrees that lie entirely in the window
+ * are answered from their aggregates instead of being walked.
+ */
+
+static void prefix_at (const delta_point_t *p, const int64_t *base, int64_t *pre)
+{
+    int i = 0;
+    const delta_point_t *l = p->rb.rb_left? DELTA_ENTRY (p->rb.rb_left) : NULL;
+    for (i = 0; i < p->dim; ++i)
+        pre[i] = base[i] + (l? l->sum[i] : 0) + p->delta[i];
+}
+
+static bool over (const int64_t *v, const int64_t *thresh, size_t len)
+{
+    int i = 0;
+    for (i = 0; i < len; ++i)
+        if (v[i] > thresh[i])
+            return true;
+    return false;
+}
+
+static bool any_over (const int64_t *base, const int64_t *v,
+                      const int64_t *thresh, size_t len)
+{
+    int i = 0;
+    for (i = 0; i < len; ++i)
+        if (base[i] + v[i] > thresh[i])
+            return true;
+    return false;
+}
+
+static void window_max (struct rb_node *n, const int64_t *base,
+                        int64_t lo, int64_t hi, bool lo_in, bool hi_in,
+                        int64_t *max)
+{
+    int i = 0;
+    delta_point_t *p = NULL;
+    if (!n)
+        return;
+    p = DELTA_ENTRY (n);
+    int64_t pre[p->dim];
+    if (lo_in && hi_in) {
+        for (i = 0; i < p->dim; ++i)
+            if (base[i] + p->max[i] > max[i])
+                max[i] = base[i] + p->max[i];
+        return;
+    }
+    prefix_at (p, base, pre);
+    if (!lo_in && p->at < lo) {
+        window_max (n->rb_right, pre, lo, hi, lo_in, hi_in, max);
+    } else if (!hi_in && p->at >= hi) {
+        window_max (n->rb_left, base, lo, hi, lo_in, hi_in, max);
+    } else {
+        window_max (n->rb_left, base, lo, hi, lo_in, true, max);
+        for (i = 0; i < p->dim; ++i)
+            if (pre[i] > max[i])
+                max[i] = pre[i];
+        window_max (n->rb_right, pre, lo, hi, true, hi_in, max);
+    }
+}
+
+static delta_point_t *window_first_over (struct rb_node *n, const int64_t *base,
+                                         int64_t lo, int64_t hi,
+                                         bool lo_in, bool hi_in,
+                                         const int64_t *thresh, size_t len)
+{
+    delta_point_t *p = NULL;
+    delta_point_t *found = NULL;
+    if (!n)
+        return NULL;
+    p = DELTA_ENTRY (n);
+    int64_t pre[p->dim];
+    // no point in this subtree can exceed thresh: prune it
+    if (lo_in && hi_in && !any_over (base, p->max, thresh, len))
+        return NULL;
+    prefix_at (p, base, pre);
+    if (!lo_in && p->at < lo)
+        return window_first_over (n->rb_right, pre, lo, hi,
+                                  lo_in, hi_in, thresh, len);
+    if (!hi_in && p->at >= hi)
+        return window_first_over (n->rb_left, base, lo, hi,
+                                  lo_in, hi_in, thresh, len);
+    if ((found = window_first_over (n->rb_left, base, lo, hi,
+                                    lo_in, true, thresh, len)))
+        return found;
+    if (over (pre, thresh, len))
+        return p;
+    return window_first_over (n->rb_right, pre, lo, hi,
+                              true, hi_in, thresh, len);
+}
+
+static delta_point_t *first_fit (struct rb_node *n, const int64_t *base,
+                                 int64_t lo, bool lo_in,
+                                 const int64_t *thresh, size_t len)
+{
+    delta_point_t *p = NULL;
+    delta_point_t *found = NULL;
+    if (!n)
+        return NULL;
+    p = DELTA_ENTRY (n);
+    int64_t pre[p->dim];
+    // Some type is over thresh at every point in this subtree: prune it.
+    // With more than one type, a subtree that survives may still hold no
+    // fit as the per-type minimums can come from different points.
+    if (lo_in && any_over (base, p->min, thresh, len))
+        return NULL;
+    prefix_at (p, base, pre);
+    if (!lo_in && p->at < lo)
+        return first_fit (n->rb_right, pre, lo, lo_in, thresh, len);
+    if ((found = first_fit (n->rb_left, base, lo, lo_in, thresh, len)))
+        return found;
+    if (!over (pre, thresh, len))
+        return p;
+    return first_fit (n->rb_right, pre, lo, true, thresh, len);
+}
+
+int64_t delta_tree_state (delta_tree_t *t, int64_t at, int64_t *scheduled)
+{
+    int64_t state_at = -1;
+    int64_t base[t->dimension];
+    int64_t pre[t->dimension];
+    struct rb_node *node = t->root.rb_node;
+    memset (base, 0, sizeof (base));
+    memset (scheduled, 0, t->dimension * sizeof (*scheduled));
+    while (node) {
+        delta_point_t *this_data = DELTA_ENTRY (node);
+        if (at < this_data->at) {
+            node = node->rb_left;
+        } else {
+            prefix_at (this_data, base, pre);
+            memcpy (base, pre, sizeof (base));
+            state_at = this_data->at;
+            node = node->rb_right;
+        }
+    }
+    if (state_at != -1)
+        memcpy (scheduled, base, t->dimension * sizeof (*scheduled));
+    return state_at;
+}
+
+void delta_tree_max (delta_tree_t *t, int64_t lo, int64_t hi, int64_t *max)
+{
+    int64_t base[t->dimension];
+    memset (base, 0, sizeof (base));
+    window_max (t->root.rb_node, base, lo, hi, false, false, max);
+}
+
+int64_t delta_tree_first_over (delta_tree_t *t, int64_t lo, int64_t hi,
+                               const int64_t *thresh, size_t len)
+{
+    int64_t base[t->dimension];
+    delta_point_t *p = NULL;
+    memset (base, 0, sizeof (base));
+    p = window_first_over (t->root.rb_node, base, lo, hi,
+                                          false, false, thresh, len);
+    return p? p->at : -1;
+}
+
+int64_t delta_tree_ceil (delta_tree_t *t, int64_t at)
+{
+    int64_t ceil = -1;
+    struct rb_node *node = t->root.rb_node;
+    while (node) {
+        delta_point_t *this_data = DELTA_ENTRY (node);
+        if (at <= this_data->at) {
+            ceil = this_data->at;
+            node = node->rb_left;
+        } else {
+            node = node->rb_right;
+        }
+    }
+    return ceil;
+}
+
+int64_t delta_tree_first_fit (delta_tree_t *t, int64_t lo,
+                              const int64_t *thresh, size_t len)
+{
+    int64_t base[t->dimension];
+    delta_point_t *p = NULL;
+    memset (base, 0, sizeof (base));
+    p = first_fit (t->root.rb_node, base, lo, false, thresh, len);
+    return p? p->at : -1;
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,117 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef DELTA_TREE_H
+#define DELTA_TREE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rbtree.h"
+#include "slab.h"
+#include "planner.h"
+
+/*! Delta tree: time-ordered red-black tree of scheduled points where each
+ *  point only stores how much the scheduled resources change at its time.
+ *  Every node is augmented with the sum of the deltas in its subtree as well
+ *  as the max and min prefix sums within the subtree. The scheduled resources
+ *  at a point are the prefix sum of the deltas up to that point, so adding or
+ *  removing a span touches only its two end points (O(log n)) and the
+ *  extremes of the scheduled resources over any time window can be computed
+ *  in O(log n) as well.
+ */
+typedef struct delta_tree {
+    struct rb_root root;         /* delta point rb tree keyed by time */
+    size_t dimension;            /* number of resource types */
+    slab_pool_t pool;            /* delta point allocator */
+} delta_tree_t;
+
+/*! Initialize the tree with a single, never removed point at base_time. */
+void delta_tree_init (delta_tree_t *t, int64_t base_time, size_t dimension);
+void delta_tree_release (delta_tree_t *t);
+
+/*! Initialize dst as a deep copy of src in O(n). */
+void delta_tree_clone (delta_tree_t *dst, const delta_tree_t *src);
+
+typedef void (*delta_tree_walk_f) (int64_t at, int ref_count,
+                                   const int64_t *scheduled, void *arg);
+
+/*! Number of points in the tree. */
+size_t delta_tree_size (delta_tree_t *t);
+
+/*! Call cb on each point in time order with the scheduled resources at it. */
+void delta_tree_walk (delta_tree_t *t, delta_tree_walk_f cb, void *arg);
+
+/*! Initialize t with n points in strictly increasing time order in O(n):
+ *  the inverse of delta_tree_walk. scheduled holds dimension counts per
+ *  point.
+ */
+void delta_tree_build (delta_tree_t *t, size_t dimension, size_t n,
+                       const int64_t *at, const int64_t *ref_count,
+                       const int64_t *scheduled);
+
+/*! Add (sign = 1) or subtract (sign = -1) resource counts over [start, last).
+ *  The end points are created on add and freed on subtract once no span
+ *  refers to them anymore.
+ */
+int delta_tree_update (delta_tree_t *t, int64_t start, int64_t last,
+                       const int64_t *counts, int sign);
+
+/*! Fold all points before now into a single first point at now that holds
+ *  the scheduled resources at now and ref_count references. The points
+ *  after now are left as they are.
+ */
+void delta_tree_advance (delta_tree_t *t, int64_t now, int ref_count);
+
+/*! Copy the scheduled resources at time at into scheduled and return the time
+ *  of the point that represents that state; -1 if at precedes all points.
+ */
+int64_t delta_tree_state (delta_tree_t *t, int64_t at, int64_t *scheduled);
+
+/*! Fold the per-type max of the scheduled resources of all points in
+ *  [lo, hi) into max.
+ */
+void delta_tree_max (delta_tree_t *t, int64_t lo, int64_t hi, int64_t *max);
+
+/*! Return the time of the first point in [lo, hi) whose scheduled resources
+ *  exceed thresh for any of the first len types; -1 if there is none.
+ */
+int64_t delta_tree_first_over (delta_tree_t *t, int64_t lo, int64_t hi,
+                               const int64_t *thresh, size_t len);
+
+/*! Return the time of the first point at or after at; -1 if there is none. */
+int64_t delta_tree_ceil (delta_tree_t *t, int64_t at);
+
+/*! Return the time of the first point at or after lo whose scheduled
+ *  resources are within thresh for all of the first len types; -1 if there
+ *  is none.
+ */
+int64_t delta_tree_first_fit (delta_tree_t *t, int64_t lo,
+                              const int64_t *thresh, size_t len);
+
+#endif /* DELTA_TREE_H */
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -28,30 +28,50 @@
 #include <string.h>
 #include <limits.h>
 #include <stdbool.h>
-#include <czmq.h>
+#include <errno.h>
+#include <pthread.h>
 
 #include "rbtree.h"
 #include "rbtree_augmented.h"
 #include "xzmalloc.h"
+#include "slab.h"
+#include "span_table.h"
+#include "serial.h"
+#include "delta_tree.h"
+#include "point_btree.h"
+#include "resvec.h"
 #include "planner.h"
 
 #define START(node) ((node)->start)
 #define LAST(node)  ((node)->last)
 
+/* Per-operation counters of planner_stats */
+#ifndef PLANNER_NO_OP_STATS
+#define OP_STAT(ctx, field, n) ((ctx)->op_stats.field += (n))
+#define ITER_STAT(it, field, n) ((it)->field += (n))
+#else
+#define OP_STAT(ctx, field, n) do { } while (0)
+#define ITER_STAT(it, field, n) do { } while (0)
+#endif
+
 typedef struct span span_t;
-typedef int64_t resource_array_t[PLANNER_NUM_TYPES];
-typedef char *resource_type_array_t[PLANNER_NUM_TYPES];
 
+/* Resource arrays are sized at planner creation to ctx->stride elements:
+ * the number of resource types rounded up to RESVEC_PAD and padded with zeros
+ * so that the resvec kernels never need a tail loop.
+ */
 typedef struct request {
     int64_t on_or_after;
     uint64_t duration;
-    resource_array_t resources;
+    int64_t *resources;
     size_t dimension;
+    uint64_t checked;            /* candidate times checked so far */
 } request_t;
 
 /*! Scheduled point: time at which resource state changes.  Each point's resource
  *  requirements are tracked as a node in a min-time resource (MTR) binary search
- *  tree.
+ *  tree. In the scheduled point tree, each point also keeps the per-type
+ *  minimum of the remaining resources over its subtree.
  */
 typedef struct scheduled_point {
     struct rb_node point_rb;     /* BST node for scheduled point tree */
@@ -61,8 +81,12 @@ typedef struct scheduled_point {
     int in_mt_resource_tree;     /* 1 when inserted in min-time resource tree */
     int new_point;               /* 1 when this point is newly created */
     int ref_count;               /* reference counter */
-    resource_array_t scheduled;  /* scheduled resources at this point */
-    resource_array_t remaining;  /* remaining resources (available) */
+    int tracked;                 /* 1 when on the avail_time_iter stack */
+    struct scheduled_point *tracked_next; /* next point on that stack */
+    int64_t *scheduled;          /* scheduled resources at this point */
+    int64_t *remaining;          /* remaining resources (available) */
+    int64_t *subtree_remaining;  /* per-type min remaining of the subtree */
+    int64_t arrays[];            /* storage for the above three arrays */
 } scheduled_point_t;
 
 /*! Node in a span interval tree to enable fast retrieval of intercepting spans.
@@ -71,29 +95,66 @@ struct span {
     int64_t start;               /* start time of the span */
     int64_t last;                /* end time of the span */
     int64_t span_id;             /* unique span id */
-    resource_array_t planned;    /* required resources */
     size_t dimension;            /* vector size of required resources */
     int in_system;               /* 1 when inserted into the system */
     scheduled_point_t *start_p;  /* scheduled point object at start */
     scheduled_point_t *last_p;   /* scheduled point object at last */
+    int64_t planned[];           /* required resources */
+};
+
+/*! Resource types and totals of planners. Planners with the same types and
+ *  totals in the same order share one descriptor from the intern table.
+ */
+struct planner_desc {
+    int ref_count;               /* planners and callers holding it */
+    uint64_t hash;               /* hash of the types and totals */
+    size_t dimension;            /* number of resource types */
+    size_t stride;               /* padded length of totals */
+    int64_t *totals;             /* resource totals, padded with zeros */
+    char **types;                /* resource type names */
+    struct planner_desc *next;   /* next descriptor in the same bucket */
 };
 
 /*! Planner context
  */
 struct planner {
-    resource_array_t total_resources;
-    resource_type_array_t resource_types;
+    planner_backend_t backend;   /* scheduled point index backend */
+    planner_desc_t *desc;        /* shared resource types and totals */
+    int64_t *total_resources;    /* desc->totals */
+    char **resource_types;       /* desc->types */
     size_t dimension;            /* size of the above arrays */
+    size_t stride;               /* padded length of each resource array */
     int64_t plan_start;          /* base time of the planner */
     int64_t plan_end;            /* end time of the planner */
     struct rb_root sched_point_tree;  /* scheduled point rb tree */
     struct rb_root mt_resource_tree;  /* min-time resrouce rb tree */
     scheduled_point_t *p0;       /* system's scheduled point at base time */
-    zhashx_t *span_lookup;       /* span lookup table by string id */
-    zhash_t *avail_time_iter;    /* tracking nodes temporarily deleted from MTR */
+    span_table_t span_lookup;    /* span lookup table by span id */
+    scheduled_point_t *avail_time_iter; /* stack of nodes deleted from MTR */
     request_t *current_request;  /* the req copy for avail time iteration */
     int avail_time_iter_set;     /* iterator set flag */
     uint64_t span_counter;       /* current span counter */
+    slab_pool_t point_pool;      /* scheduled point allocator */
+    slab_pool_t span_pool;       /* span allocator */
+    union {                      /* at most one is in use: see backend */
+        delta_tree_t delta_tree;     /* PLANNER_BACKEND_DELTA point index */
+        point_btree_t point_btree;   /* PLANNER_BACKEND_BTREE point index */
+    };
+    planner_stats_t op_stats;    /* per-operation counters */
+    uint64_t iter_searches;      /* searches of destroyed cursors; atomic */
+    uint64_t iter_candidates;    /* candidates checked by them; atomic */
+};
+
+/*! Availability cursor: an earliest-time search with a state of its own.
+ *  Neither tree of the planner is touched by the search.
+ */
+struct planner_avail_iter {
+    planner_t *ctx;              /* planner being searched */
+    request_t req;               /* request; req.on_or_after is the cursor */
+    int set;                     /* 1 once planner_avail_iter_first ran */
+    uint64_t searches;           /* searches run by this cursor */
+    uint64_t candidates;         /* candidate times checked by them */
+    int64_t resources[];         /* storage for req.resources */
 };
 
 
@@ -125,6 +186,24 @@ static scheduled_point_t *scheduled_point_search (int64_t t, struct rb_root *roo
     return NULL;
 }
 
+/*! Return the earliest scheduled point at or after t. */
+static scheduled_point_t *scheduled_point_ceil (int64_t t, struct rb_root *root)
+{
+    scheduled_point_t *ceil = NULL;
+    struct rb_node *node = root->rb_node;
+    while (node) {
+        scheduled_point_t *this_data = NULL;
+        this_data = container_of (node, scheduled_point_t, point_rb);
+        if (t <= this_data->at) {
+            ceil = this_data;
+            node = node->rb_left;
+        } else {
+            node = node->rb_right;
+        }
+    }
+    return ceil;
+}
+
 static inline scheduled_point_t *recent_state (scheduled_point_t *new_data,
                                                scheduled_point_t *old_data)
 {
@@ -157,6 +236,151 @@ static scheduled_point_t *scheduled_point_state (int64_t at, struct rb_root *roo
     return last_state;
 }
 
+static inline int64_t rescmp (const int64_t *s1, const int64_t *s2, size_t len)
+{
+    // single-type planners (the vast majority) skip the kernel call
+    if (len == 1)
+        return s1[0] - s2[0];
+    return resvec->cmp (s1, s2, len);
+}
+
+/*! The three arrays of a point are laid out back to back, each padded to
+ *  the stride of its planner.
+ */
+static inline size_t point_stride (const scheduled_point_t *point)
+{
+    return point->remaining - point->scheduled;
+}
+
+static void point_subtree_remaining (scheduled_point_t *point, int64_t *min)
+{
+    size_t stride = point_stride (point);
+    scheduled_point_t *p = NULL;
+    memcpy (min, point->remaining, stride * sizeof (*min));
+    if (point->point_rb.rb_left) {
+        p = rb_entry (point->point_rb.rb_left, scheduled_point_t, point_rb);
+        resvec->min (min, p->subtree_remaining, stride);
+    }
+    if (point->point_rb.rb_right) {
+        p = rb_entry (point->point_rb.rb_right, scheduled_point_t, point_rb);
+        resvec->min (min, p->subtree_remaining, stride);
+    }
+}
+
+static void scheduled_point_propagate (struct rb_node *n, struct rb_node *stop)
+{
+    while (n != stop) {
+        scheduled_point_t *point = rb_entry (n, scheduled_point_t, point_rb);
+        size_t size = point_stride (point) * sizeof (int64_t);
+        int64_t min[point_stride (point)];
+        point_subtree_remaining (point, min);
+        if (memcmp (point->subtree_remaining, min, size) == 0)
+            break;
+        memcpy (point->subtree_remaining, min, size);
+        n = rb_parent (&(point->point_rb));
+    }
+}
+
+static void scheduled_point_copy (struct rb_node *src, struct rb_node *dst)
+{
+    scheduled_point_t *o = rb_entry (src, scheduled_point_t, point_rb);
+    scheduled_point_t *n = rb_entry (dst, scheduled_point_t, point_rb);
+    memcpy (n->subtree_remaining, o->subtree_remaining,
+            point_stride (o) * sizeof (int64_t));
+}
+
+static void scheduled_point_rotate (struct rb_node *src, struct rb_node *dst)
+{
+    scheduled_point_copy (src, dst);
+    scheduled_point_t *o = rb_entry (src, scheduled_point_t, point_rb);
+    point_subtree_remaining (o, o->subtree_remaining);
+}
+
+static const struct rb_augment_callbacks scheduled_point_aug_cb = {
+    scheduled_point_propagate, scheduled_point_copy, scheduled_point_rotate
+};
+
+/*! Fold the per-type minimum of the remaining resources over the scheduled
+ *  points in [lo, hi) into min. Only the two boundary paths of the window
+ *  are walked; every subtree in between is taken whole from its
+ *  subtree_remaining, so this is O(log n) for any window.
+ */
+static void scheduled_point_window_min (struct rb_root *root, int64_t lo,
+                                        int64_t hi, int64_t *min, size_t len)
+{
+    struct rb_node *n = root->rb_node;
+    struct rb_node *b = NULL;
+    scheduled_point_t *p = NULL;
+    // the topmost point in the window splits it into the two paths
+    while (n) {
+        p = rb_entry (n, scheduled_point_t, point_rb);
+        if (p->at < lo)
+            n = n->rb_right;
+        else if (p->at >= hi)
+            n = n->rb_left;
+        else
+            break;
+    }
+    if (!n)
+        return;
+    resvec->min (min, p->remaining, len);
+    for (b = n->rb_left; b; ) {
+        p = rb_entry (b, scheduled_point_t, point_rb);
+        if (p->at < lo) {
+            b = b->rb_right;
+            continue;
+        }
+        resvec->min (min, p->remaining, len);
+        if (b->rb_right)
+            resvec->min (min, rb_entry (b->rb_right, scheduled_point_t,
+                                        point_rb)->subtree_remaining, len);
+        b = b->rb_left;
+    }
+    for (b = n->rb_right; b; ) {
+        p = rb_entry (b, scheduled_point_t, point_rb);
+        if (p->at >= hi) {
+            b = b->rb_left;
+            continue;
+        }
+        resvec->min (min, p->remaining, len);
+        if (b->rb_left)
+            resvec->min (min, rb_entry (b->rb_left, scheduled_point_t,
+                                        point_rb)->subtree_remaining, len);
+        b = b->rb_right;
+    }
+}
+
+/*! Return the earliest scheduled point in [lo, hi) at which the request does
+ *  not fit; NULL if it fits at all of them. A subtree whose per-type minimum
+ *  can take the request is skipped whole, so this is O(log n) as well.
+ */
+static scheduled_point_t *scheduled_point_first_over (struct rb_node *n,
+                                                      int64_t lo, int64_t hi,
+                                                      const int64_t *req,
+                                                      size_t len)
+{
+    scheduled_point_t *p = NULL;
+    scheduled_point_t *q = NULL;
+    while (n) {
+        p = rb_entry (n, scheduled_point_t, point_rb);
+        if (rescmp (req, p->subtree_remaining, len) <= 0)
+            return NULL;
+        if (p->at >= hi) {
+            n = n->rb_left;
+        } else if (p->at < lo) {
+            n = n->rb_right;
+        } else {
+            q = scheduled_point_first_over (n->rb_left, lo, hi, req, len);
+            if (q)
+                return q;
+            if (rescmp (req, p->remaining, len) > 0)
+                return p;
+            n = n->rb_right;
+        }
+    }
+    return NULL;
+}
+
 static int scheduled_point_insert (scheduled_point_t *new_data,
                                    struct rb_root *root)
 {
@@ -175,7 +399,10 @@ static int scheduled_point_insert (scheduled_point_t *new_data,
             return -1;
     }
     rb_link_node (&(new_data->point_rb), parent, link);
-    rb_insert_color (&(new_data->point_rb), root);
+    memcpy (new_data->subtree_remaining, new_data->remaining,
+            point_stride (new_data) * sizeof (int64_t));
+    scheduled_point_propagate (parent, NULL);
+    rb_insert_augmented (&(new_data->point_rb), root, &scheduled_point_aug_cb);
     return 0;
 }
 
@@ -184,7 +411,7 @@ static int scheduled_point_remove (scheduled_point_t *data, struct rb_root *root
     int rc = -1;
     scheduled_point_t *n = scheduled_point_search (data->at, root);
     if (n) {
-        rb_erase (&(n->point_rb), root);
+        rb_erase_augmented (&(n->point_rb), root, &scheduled_point_aug_cb);
         // Note: this must only remove the node from the scheduled point tree:
         // DO NOT free memory allocated to the node
         rc = 0;
@@ -192,16 +419,6 @@ static int scheduled_point_remove (scheduled_point_t *data, struct rb_root *root
     return rc;
 }
 
-static void scheduled_points_destroy (struct rb_node *node)
-{
-    if (node->rb_left)
-        scheduled_points_destroy (node->rb_left);
-    if (node->rb_right)
-        scheduled_points_destroy (node->rb_right);
-    scheduled_point_t *data = container_of (node, scheduled_point_t, point_rb);
-    free (data);
-}
-
 
 /*******************************************************************************
  *                                                                             *
@@ -257,19 +474,6 @@ static const struct rb_augment_callbacks mintime_resource_aug_cb = {
     mintime_resource_propagate, mintime_resource_copy, mintime_resource_rotate
 };
 
-static int64_t rescmp (const int64_t *s1, const resource_array_t s2, size_t len)
-{
-    int i = 0;
-    int less = 0;
-    int64_t r = 0;
-    for (i = 0; i < len; ++i) {
-        if ( (r = s1[i] - s2[i]) > 0)
-            break;
-        less += r;
-    }
-    return (r > 0)? r : less;
-}
-
 static void mintime_resource_insert (scheduled_point_t *new_data,
                                      unsigned int len, struct rb_root *root)
 {
@@ -312,7 +516,8 @@ static int64_t right_branch_mintime (struct rb_node *n)
 }
 
 static scheduled_point_t *find_mintime_point (struct rb_node *anchor,
-                                              int64_t min_time)
+                                              int64_t min_time,
+                                              uint64_t *visits)
 {
     if (!anchor)
         return NULL;
@@ -324,6 +529,7 @@ static scheduled_point_t *find_mintime_point (struct rb_node *anchor,
 
     struct rb_node *node = anchor->rb_right;
     while (node) {
+        (*visits)++;
         this_data = rb_entry (node, scheduled_point_t, resource_rb);
         if (this_data->at == min_time)
             return this_data;
@@ -343,13 +549,15 @@ static scheduled_point_t *find_mintime_point (struct rb_node *anchor,
 
 static int64_t find_mintime_anchor (const int64_t *ra, size_t len,
                                     struct rb_root *mtrt,
-                                    struct rb_node **anchor_p)
+                                    struct rb_node **anchor_p,
+                                    uint64_t *visits)
 {
     struct rb_node *node = mtrt->rb_node;
     int64_t min_time = INT64_MAX;
     int64_t right_min_time = INT64_MAX;
     while (node) {
         scheduled_point_t *this_data = NULL;
+        (*visits)++;
         this_data = rb_entry (node, scheduled_point_t, resource_rb);
         int64_t result = 0;
         result = rescmp (ra, this_data->remaining, len);
@@ -376,11 +584,12 @@ static int64_t find_mintime_anchor (const int64_t *ra, size_t len,
 }
 
 static scheduled_point_t *mintime_resource_mintime (const int64_t *ra, size_t len,
-                                                    struct rb_root *mtrt)
+                                                    struct rb_root *mtrt,
+                                                    uint64_t *visits)
 {
     struct rb_node *anchor = NULL;
-    int64_t min_time = find_mintime_anchor (ra, len, mtrt, &anchor);
-    return find_mintime_point (anchor, min_time);
+    int64_t min_time = find_mintime_anchor (ra, len, mtrt, &anchor, visits);
+    return find_mintime_point (anchor, min_time, visits);
 }
 
 
@@ -389,173 +598,360 @@ static scheduled_point_t *mintime_resource_mintime (const int64_t *ra, size_t le
  *                  Scheduled Point and Resource Update APIs                   *
  *                                                                             *
  *******************************************************************************/
-static int track_points (zhash_t *tracker, scheduled_point_t *point)
+static int track_points (planner_t *ctx, scheduled_point_t *point)
 {
-    char key[32];
-    sprintf (key, "%jd", (intmax_t)point->at);
-    // caller will rely on the fact that rc == -1 when key already exists.
-    // don't need to register free */
-    return zhash_insert (tracker, key, point);
+    // caller will rely on the fact that rc == -1 when already tracked.
+    if (point->tracked)
+        return -1;
+    point->tracked = 1;
+    point->tracked_next = ctx->avail_time_iter;
+    ctx->avail_time_iter = point;
+    return 0;
 }
 
+/*! Put the tracked points back into the min-time resource tree. Batch span
+ *  updates track the points they touch as well; those that a batch removal
+ *  left unreferenced are dropped here instead.
+ */
 static void restore_track_points (planner_t *ctx)
 {
     scheduled_point_t *point = NULL;
     struct rb_root *root = &(ctx->mt_resource_tree);
-    zlist_t *keys = zhash_keys (ctx->avail_time_iter);
-    const char *k = NULL;
-    for (k = zlist_first (keys); k; k = zlist_next (keys)) {
-        point = zhash_lookup (ctx->avail_time_iter, k);
-        mintime_resource_insert (point, ctx->dimension, root);
-        zhash_delete (ctx->avail_time_iter, k);
+    while ((point = ctx->avail_time_iter)) {
+        ctx->avail_time_iter = point->tracked_next;
+        point->tracked_next = NULL;
+        point->tracked = 0;
+        if (point->ref_count == 0) {
+            scheduled_point_remove (point, &(ctx->sched_point_tree));
+            slab_free (&(ctx->point_pool), point);
+        } else {
+            mintime_resource_insert (point, ctx->dimension, root);
+        }
     }
-    zlist_destroy (&keys);
 }
 
-static void update_mintime_resource_tree (planner_t *ctx, zlist_t *list)
+/*! Take the point out of the min-time resource tree until the end of the
+ *  current batch update.
+ */
+static void defer_point (planner_t *ctx, scheduled_point_t *point)
 {
-    scheduled_point_t *point = NULL;
-    struct rb_root *mtrt = &(ctx->mt_resource_tree);
-    for (point = zlist_first (list); point; point = zlist_next (list)) {
-        if (point->in_mt_resource_tree)
-            mintime_resource_remove (point, mtrt);
-        if (point->ref_count && !(point->in_mt_resource_tree))
-            mintime_resource_insert (point, ctx->dimension, mtrt);
-    }
+    if (point->in_mt_resource_tree)
+        mintime_resource_remove (point, &(ctx->mt_resource_tree));
+    track_points (ctx, point);
 }
 
-static void copy_req (request_t *dest, int64_t on_or_after, uint64_t duration,
-                      const uint64_t *resource_counts, size_t len)
+static void copy_counts (planner_t *ctx, int64_t *dest,
+                         const uint64_t *resource_counts, size_t len)
+{
+    memset (dest, 0, ctx->stride * sizeof (*dest));
+    memcpy (dest, resource_counts, len * sizeof (*dest));
+}
+
+static void copy_req (planner_t *ctx, request_t *dest, int64_t on_or_after,
+                      uint64_t duration, const uint64_t *resource_counts,
+                      size_t len)
 {
-    int i = 0;
     dest->on_or_after = on_or_after;
     dest->duration = duration;
     dest->dimension = len;
-    for (i = 0; i < len; ++i)
-        dest->resources[i] = (int64_t)resource_counts[i];
+    copy_counts (ctx, dest->resources, resource_counts, len);
+}
+
+static scheduled_point_t *point_new (planner_t *ctx, int64_t at)
+{
+    scheduled_point_t *point = slab_alloc (&(ctx->point_pool));
+    point->at = at;
+    point->scheduled = point->arrays;
+    point->remaining = point->arrays + ctx->stride;
+    point->subtree_remaining = point->arrays + 2 * ctx->stride;
+    return point;
 }
 
-static scheduled_point_t *get_or_new_point (planner_t *ctx, int64_t at)
+static scheduled_point_t *get_or_new_point (planner_t *ctx, int64_t at,
+                                            bool defer)
 {
     struct rb_root *spt = &(ctx->sched_point_tree);
     scheduled_point_t *point = NULL;
     if ( !(point = scheduled_point_search (at, spt))) {
         struct rb_root *mtrt = &(ctx->mt_resource_tree);
         scheduled_point_t *state = scheduled_point_state (at, spt);
-        point = xzmalloc (sizeof (*point));
-        point->at = at;
+        point = point_new (ctx, at);
         point->in_mt_resource_tree = 0;
         point->new_point = 1;
         point->ref_count = 0;
-        memcpy (point->scheduled, state->scheduled, sizeof (point->scheduled));
-        memcpy (point->remaining, state->remaining, sizeof(point->remaining));
+        memcpy (point->arrays, state->arrays,
+                2 * ctx->stride * sizeof (*point->arrays));
         scheduled_point_insert (point, spt);
-        mintime_resource_insert (point, ctx->dimension, mtrt);
+        if (defer)
+            track_points (ctx, point);
+        else
+            mintime_resource_insert (point, ctx->dimension, mtrt);
     }
     return point;
 }
 
-static void fetch_overlap_points (planner_t *ctx, int64_t at, uint64_t duration,
-                                  zlist_t *list)
+static inline scheduled_point_t *next_point (scheduled_point_t *point)
 {
-    struct rb_root *spr = &(ctx->sched_point_tree);
-    scheduled_point_t *point = scheduled_point_state (at, spr);
-    while (point) {
-        if (point->at >= (at + (int64_t)duration))
-            break;
-        else if (point->at >= at)
-            zlist_append (list, (void *)point);
-        struct rb_node *n = rb_next (&(point->point_rb));
-        point = rb_entry (n, scheduled_point_t, point_rb);
-    }
+    struct rb_node *n = rb_next (&(point->point_rb));
+    return (n)? rb_entry (n, scheduled_point_t, point_rb) : NULL;
 }
 
-static int update_points_add_span (planner_t *ctx, zlist_t *list, span_t *span)
+/*! Walk the scheduled points in [start, last) in a single pass over the
+ *  scheduled point tree, add planned to their resource state (or take it
+ *  away with sub) and re-key them in the min-time resource tree as they are
+ *  visited. No list of the overlapping points is ever materialized. With
+ *  defer, the points are only re-keyed once at the end of the batch (see
+ *  defer_point).
+ */
+static int update_points (planner_t *ctx, int64_t start, int64_t last,
+                          const int64_t *planned, size_t len, bool sub,
+                          bool defer)
 {
     int rc = 0;
+    int rc2 = 0;
+    struct rb_root *mtrt = &(ctx->mt_resource_tree);
     scheduled_point_t *point = NULL;
-    for (point = zlist_first (list); point; point = zlist_next (list)) {
-        int i = 0;
-        for (i = 0; i < span->dimension; ++i) {
-            point->scheduled[i] += span->planned[i];
-            point->remaining[i] -= span->planned[i];
-            if ( (point->scheduled[i] > ctx->total_resources[i])
-                  || (point->remaining[i] < 0)) {
-                errno = ERANGE;
-                rc = -1;
-            }
+    point = scheduled_point_ceil (start, &(ctx->sched_point_tree));
+    for (; point && point->at < last; point = next_point (point)) {
+        OP_STAT (ctx, point_updates, 1);
+        if (point->in_mt_resource_tree)
+            mintime_resource_remove (point, mtrt);
+        if (sub)
+            rc2 = resvec->sub (point->scheduled, point->remaining, planned,
+                               ctx->total_resources, len);
+        else
+            rc2 = resvec->add (point->scheduled, point->remaining, planned,
+                               ctx->total_resources, len);
+        if (rc2 == -1) {
+            errno = ERANGE;
+            rc = -1;
         }
+        scheduled_point_propagate (&(point->point_rb), NULL);
+        // a point no longer referenced by any span is about to be removed
+        if (defer)
+            track_points (ctx, point);
+        else if (point->ref_count)
+            mintime_resource_insert (point, ctx->dimension, mtrt);
     }
     return rc;
 }
 
-static int update_points_subtract_span (planner_t *ctx, zlist_t *list,
-                                        span_t *span)
+static inline int update_points_add_span (planner_t *ctx, span_t *span,
+                                          bool defer)
 {
-    int rc = 0;
-    scheduled_point_t *point = NULL;
-    for (point = zlist_first (list); point; point = zlist_next (list)) {
-        int i = 0;
-        for (i = 0; i < span->dimension; ++i) {
-            point->scheduled[i] -= span->planned[i];
-            point->remaining[i] += span->planned[i];
-            if ( (point->scheduled[i] < 0)
-                  || (point->remaining[i] > ctx->total_resources[i])) {
-                errno = ERANGE;
-                rc = -1;
-            }
-        }
-    }
-    return rc;
+    return update_points (ctx, span->start, span->last, span->planned,
+                          span->dimension, false, defer);
+}
+
+static inline int update_points_subtract_span (planner_t *ctx, span_t *span,
+                                               bool defer)
+{
+    return update_points (ctx, span->start, span->last, span->planned,
+                          span->dimension, true, defer);
 }
 
 static bool span_ok (planner_t *ctx, scheduled_point_t *start_point,
                      uint64_t duration, const int64_t *resource_counts,
                      size_t len)
 {
-    bool ok = true;
     struct rb_root *mtrt = &(ctx->mt_resource_tree);
-    scheduled_point_t *next_point = NULL;
-    struct rb_node *n = &(start_point->point_rb);
-    while ((next_point = rb_entry (n, scheduled_point_t, point_rb))) {
-         if (next_point->at >= (start_point->at + (int64_t)duration)) {
-             ok = true;
-             break;
-         } else if (rescmp (resource_counts, next_point->remaining, len) > 0) {
-             mintime_resource_remove (start_point, mtrt);
-             track_points (ctx->avail_time_iter, start_point);
-             ok = false;
-             break;
-         }
-         n = rb_next (&(next_point->point_rb));
+    struct rb_node *root = ctx->sched_point_tree.rb_node;
+    int64_t last = start_point->at + (int64_t)duration;
+    if (scheduled_point_first_over (root, start_point->at, last,
+                                    resource_counts, len)) {
+        mintime_resource_remove (start_point, mtrt);
+        track_points (ctx, start_point);
+        return false;
     }
-    return ok;
+    return true;
 }
 
 static int64_t avail_at (planner_t *ctx, int64_t on_or_after, uint64_t duration,
                          const int64_t *resource_counts, size_t len)
 {
     int64_t at = -1;
+    uint64_t visits = 0;
     scheduled_point_t *start_point = NULL;
     struct rb_root *mt = &(ctx->mt_resource_tree);
-    while ((start_point = mintime_resource_mintime (resource_counts, len, mt))) {
+    while ((start_point = mintime_resource_mintime (resource_counts, len, mt,
+                                                    &visits))) {
+        OP_STAT (ctx, candidates, 1);
         at = start_point->at;
         if (at < on_or_after) {
             mintime_resource_remove (start_point, mt);
-            track_points (ctx->avail_time_iter, start_point);
+            track_points (ctx, start_point);
             at = -1;
 
         } else if (span_ok (ctx, start_point, duration, resource_counts, len)) {
             mintime_resource_remove (start_point, mt);
-            track_points (ctx->avail_time_iter, start_point);
+            track_points (ctx, start_point);
             if ((at + duration) > ctx->plan_end)
                 at = -1;
             break;
         }
     }
+    OP_STAT (ctx, mt_visits, visits);
+    return at;
+}
+
+/*! The delta and B+ tree backends both keep the scheduled resources of their
+ *  points in a single time-ordered index and answer the same queries on it.
+ *  The index_ helpers below forward to whichever of the two is in use.
+ */
+static inline bool has_point_index (planner_t *ctx)
+{
+    return ctx->backend != PLANNER_BACKEND_RBTREE;
+}
+
+/*! Return the number of points updated; the delta tree only changes the two
+ *  end points.
+ */
+static int64_t index_update (planner_t *ctx, int64_t start, int64_t last,
+                             const int64_t *counts, int sign)
+{
+    if (ctx->backend == PLANNER_BACKEND_BTREE)
+        return point_btree_update (&(ctx->point_btree), start, last, counts,
+                                   sign);
+    return delta_tree_update (&(ctx->delta_tree), start, last, counts,
+                              sign) == 0? 2 : -1;
+}
+
+static inline int64_t index_state (planner_t *ctx, int64_t at,
+                                   int64_t *scheduled)
+{
+    if (ctx->backend == PLANNER_BACKEND_BTREE)
+        return point_btree_state (&(ctx->point_btree), at, scheduled);
+    return delta_tree_state (&(ctx->delta_tree), at, scheduled);
+}
+
+static inline void index_max (planner_t *ctx, int64_t lo, int64_t hi,
+                              int64_t *max)
+{
+    if (ctx->backend == PLANNER_BACKEND_BTREE)
+        point_btree_max (&(ctx->point_btree), lo, hi, max);
+    else
+        delta_tree_max (&(ctx->delta_tree), lo, hi, max);
+}
+
+static inline int64_t index_first_over (planner_t *ctx, int64_t lo, int64_t hi,
+                                        const int64_t *thresh, size_t len)
+{
+    if (ctx->backend == PLANNER_BACKEND_BTREE)
+        return point_btree_first_over (&(ctx->point_btree), lo, hi, thresh,
+                                       len);
+    return delta_tree_first_over (&(ctx->delta_tree), lo, hi, thresh, len);
+}
+
+static inline int64_t index_first_fit (planner_t *ctx, int64_t lo,
+                                       const int64_t *thresh, size_t len)
+{
+    if (ctx->backend == PLANNER_BACKEND_BTREE)
+        return point_btree_first_fit (&(ctx->point_btree), lo, thresh, len);
+    return delta_tree_first_fit (&(ctx->delta_tree), lo, thresh, len);
+}
+
+static inline int64_t index_ceil (planner_t *ctx, int64_t at)
+{
+    if (ctx->backend == PLANNER_BACKEND_BTREE)
+        return point_btree_ceil (&(ctx->point_btree), at);
+    return delta_tree_ceil (&(ctx->delta_tree), at);
+}
+
+static inline size_t index_size (planner_t *ctx)
+{
+    if (ctx->backend == PLANNER_BACKEND_BTREE)
+        return point_btree_size (&(ctx->point_btree));
+    return delta_tree_size (&(ctx->delta_tree));
+}
+
+/*! Point index counterpart of avail_at: jump to the first point that fits
+ *  at or after the cursor, check its window and, on a miss, restart right
+ *  after the first point in the window that does not fit. The cursor is kept
+ *  in the current request so that planner_avail_time_next resumes right
+ *  after the last returned time.
+ */
+static int64_t index_avail_at (planner_t *ctx, request_t *req)
+{
+    int i = 0;
+    int64_t at = req->on_or_after;
+    int64_t over = -1;
+    int64_t thresh[ctx->stride];
+    for (i = 0; i < req->dimension; ++i)
+        thresh[i] = ctx->total_resources[i] - req->resources[i];
+
+    while ((at = index_first_fit (ctx, at, thresh, req->dimension)) != -1) {
+        req->checked++;
+        if ((at + req->duration) > ctx->plan_end)
+            return -1;
+        over = index_first_over (ctx, at, at + (int64_t)req->duration,
+                                 thresh, req->dimension);
+        if (over == -1) {
+            req->on_or_after = at + 1;
+            break;
+        }
+        at = over + 1;
+    }
     return at;
 }
 
+/*! Read-only counterpart of avail_at for the scheduled point tree: try the
+ *  points in time order from the cursor and, when the window of a candidate
+ *  point does not fit, resume right after the first point in it that does
+ *  not. Each window is checked in O(log n).
+ */
+static int64_t scan_avail_at (planner_t *ctx, request_t *req)
+{
+    int64_t last = 0;
+    scheduled_point_t *point = NULL;
+    scheduled_point_t *q = NULL;
+    struct rb_node *root = ctx->sched_point_tree.rb_node;
+    point = scheduled_point_ceil (req->on_or_after, &(ctx->sched_point_tree));
+    while (point) {
+        req->checked++;
+        last = point->at + (int64_t)req->duration;
+        if (last > ctx->plan_end)
+            return -1;
+        q = scheduled_point_first_over (root, point->at, last, req->resources,
+                                        req->dimension);
+        if (!q) {
+            req->on_or_after = point->at + 1;
+            return point->at;
+        }
+        point = next_point (q);
+    }
+    return -1;
+}
+
+/*! Return the time of the first scheduled point at or after at; -1 if there
+ *  is none.
+ */
+static int64_t point_time_ceil (planner_t *ctx, int64_t at)
+{
+    scheduled_point_t *point = NULL;
+    if (has_point_index (ctx))
+        return index_ceil (ctx, at);
+    point = scheduled_point_ceil (at, &(ctx->sched_point_tree));
+    return point? point->at : -1;
+}
+
+/*! Run the earliest-time search of planner_avail_time_first and _next for
+ *  the current request.
+ */
+static int64_t avail_time_search (planner_t *ctx)
+{
+    int64_t at = -1;
+    request_t *req = ctx->current_request;
+    OP_STAT (ctx, searches, 1);
+    if (has_point_index (ctx)) {
+        req->checked = 0;
+        at = index_avail_at (ctx, req);
+        OP_STAT (ctx, candidates, req->checked);
+        return at;
+    }
+    return avail_at (ctx, req->on_or_after, req->duration, req->resources,
+                     req->dimension);
+}
+
 static bool avail_during (planner_t *ctx, int64_t at, uint64_t duration,
                           const int64_t *resource_counts, size_t len)
 {
@@ -566,46 +962,176 @@ static bool avail_during (planner_t *ctx, int64_t at, uint64_t duration,
         return -1;
     }
 
+    if (has_point_index (ctx)) {
+        int i = 0;
+        int64_t lo = 0;
+        int64_t thresh[ctx->stride];
+        int64_t scheduled[ctx->stride];
+        for (i = 0; i < len; ++i)
+            thresh[i] = ctx->total_resources[i] - resource_counts[i];
+        if ((lo = index_state (ctx, at, scheduled)) == -1)
+            lo = at;
+        return index_first_over (ctx, lo, at + (int64_t)duration,
+                                 thresh, len) == -1;
+    }
+
     spr = &(ctx->sched_point_tree);
     scheduled_point_t *point = scheduled_point_state (at, spr);
-    while (point) {
-        if (point->at >= (at + (int64_t)duration)) {
-            ok = true;
-            break;
-        } else if (rescmp (resource_counts, point->remaining, len) > 0) {
-            ok = false;
-            break;
-        }
-        struct rb_node *n = rb_next (&(point->point_rb));
-        point = rb_entry (n, scheduled_point_t, point_rb);
-    }
+    ok = !scheduled_point_first_over (spr->rb_node, point? point->at : at,
+                                      at + (int64_t)duration,
+                                      resource_counts, len);
     return ok;
 }
 
-static scheduled_point_t *avail_resources_during (planner_t *ctx, int64_t at,
-                                                  uint64_t duration)
+static int avail_resources_during (planner_t *ctx, int64_t at,
+                                   uint64_t duration, int64_t *remaining)
 {
     struct rb_root *spr = NULL;
 
     if ((at + duration) > ctx->plan_end) {
         errno = ERANGE;
-        return NULL;
+        return -1;
+    }
+
+    if (has_point_index (ctx)) {
+        int i = 0;
+        int64_t lo = 0;
+        int64_t max[ctx->stride];
+        if ((lo = index_state (ctx, at, max)) == -1)
+            lo = at;
+        index_max (ctx, lo, at + (int64_t)duration, max);
+        for (i = 0; i < ctx->dimension; ++i)
+            remaining[i] = ctx->total_resources[i] - max[i];
+        return 0;
     }
 
+    // per-type minimum over the window: the least available amount of
+    // each type need not come from the same point
     spr = &(ctx->sched_point_tree);
     scheduled_point_t *point = scheduled_point_state (at, spr);
-    scheduled_point_t *min = point;
-    while (point) {
-        if (point->at >= (at + (int64_t)duration)) {
-            break;
-        } else if (rescmp(min->remaining, point->remaining,
-                          PLANNER_NUM_TYPES) > 0) {
-          min = point;
+    memcpy (remaining, ctx->total_resources, ctx->stride * sizeof (*remaining));
+    scheduled_point_window_min (spr, point? point->at : at,
+                                at + (int64_t)duration, remaining,
+                                ctx->dimension);
+    return 0;
+}
+
+static void avail_resources_at (planner_t *ctx, int64_t at, int64_t *remaining)
+{
+    int i = 0;
+    if (has_point_index (ctx)) {
+        int64_t scheduled[ctx->stride];
+        index_state (ctx, at, scheduled);
+        for (i = 0; i < ctx->dimension; ++i)
+            remaining[i] = ctx->total_resources[i] - scheduled[i];
+    } else {
+        scheduled_point_t *state = NULL;
+        state = scheduled_point_state (at, &(ctx->sched_point_tree));
+        memcpy (remaining, state->remaining,
+                ctx->stride * sizeof (*remaining));
+    }
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                     Interned Resource Type Descriptors                      *
+ *                                                                             *
+ *******************************************************************************/
+
+/* Descriptors of all of the planners of the process, chained by hash. All
+ * accesses, reference counting included, hold the lock.
+ */
+static struct {
+    pthread_mutex_t lock;
+    planner_desc_t **buckets;
+    size_t n_buckets;
+    size_t size;
+} desc_table = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0 };
+
+/*! FNV-1a over the totals and the type names, each name terminated so
+ *  that {"ab", "c"} and {"a", "bc"} differ.
+ */
+static uint64_t desc_hash (const uint64_t *totals, const char **types,
+                           size_t len)
+{
+    size_t i = 0;
+    const char *c = NULL;
+    uint64_t h = 14695981039346656037ULL;
+    for (i = 0; i < len; ++i) {
+        h = (h ^ totals[i]) * 1099511628211ULL;
+        for (c = types[i]; *c; ++c)
+            h = (h ^ (unsigned char)*c) * 1099511628211ULL;
+        h = (h ^ 0xff) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static bool desc_equal (const planner_desc_t *desc, const uint64_t *totals,
+                        const char **types, size_t len)
+{
+    size_t i = 0;
+    if (desc->dimension != len)
+        return false;
+    for (i = 0; i < len; ++i)
+        if (desc->totals[i] != (int64_t)totals[i]
+            || strcmp (desc->types[i], types[i]) != 0)
+            return false;
+    return true;
+}
+
+static void desc_table_grow (void)
+{
+    size_t i = 0;
+    size_t n = desc_table.n_buckets? 2 * desc_table.n_buckets : 64;
+    planner_desc_t **buckets = xzmalloc (n * sizeof (*buckets));
+    for (i = 0; i < desc_table.n_buckets; ++i) {
+        planner_desc_t *desc = desc_table.buckets[i];
+        while (desc) {
+            planner_desc_t *next = desc->next;
+            desc->next = buckets[desc->hash % n];
+            buckets[desc->hash % n] = desc;
+            desc = next;
         }
-        struct rb_node *n = rb_next (&(point->point_rb));
-        point = rb_entry (n, scheduled_point_t, point_rb);
     }
-    return min;
+    free (desc_table.buckets);
+    desc_table.buckets = buckets;
+    desc_table.n_buckets = n;
+}
+
+static planner_desc_t *desc_create (uint64_t hash, const uint64_t *totals,
+                                    const char **types, size_t len)
+{
+    size_t i = 0;
+    planner_desc_t *desc = xzmalloc (sizeof (*desc));
+    desc->ref_count = 1;
+    desc->hash = hash;
+    desc->dimension = len;
+    desc->stride = RESVEC_PAD (len);
+    desc->totals = xzmalloc (desc->stride * sizeof (*desc->totals));
+    desc->types = xzmalloc (len * sizeof (*desc->types));
+    for (i = 0; i < len; ++i) {
+        desc->totals[i] = (int64_t)totals[i];
+        desc->types[i] = xstrdup (types[i]);
+    }
+    return desc;
+}
+
+static void desc_free (planner_desc_t *desc)
+{
+    size_t i = 0;
+    for (i = 0; i < desc->dimension; ++i)
+        free (desc->types[i]);
+    free (desc->types);
+    free (desc->totals);
+    free (desc);
+}
+
+static inline bool backend_ok (planner_backend_t backend)
+{
+    return backend == PLANNER_BACKEND_RBTREE
+           || backend == PLANNER_BACKEND_DELTA
+           || backend == PLANNER_BACKEND_BTREE;
 }
 
 
@@ -622,16 +1148,25 @@ static void initialize (planner_t *ctx, int64_t base_time, uint64_t duration)
     ctx->plan_end = base_time + (int64_t)duration;
     ctx->sched_point_tree = RB_ROOT;
     ctx->mt_resource_tree = RB_ROOT;
-    ctx->p0 = xzmalloc (sizeof (*(ctx->p0)));
-    ctx->p0->at = base_time;
-    ctx->p0->ref_count = 1;
-    for (i = 0; i < ctx->dimension; ++i)
-        ctx->p0->remaining[i] = ctx->total_resources[i];
-    scheduled_point_insert (ctx->p0, &(ctx->sched_point_tree));
-    mintime_resource_insert (ctx->p0, ctx->dimension, &(ctx->mt_resource_tree));
-    ctx->span_lookup = zhashx_new ();
-    ctx->avail_time_iter = zhash_new ();
+    if (ctx->backend == PLANNER_BACKEND_DELTA) {
+        ctx->p0 = NULL;
+        delta_tree_init (&(ctx->delta_tree), base_time, ctx->dimension);
+    } else if (ctx->backend == PLANNER_BACKEND_BTREE) {
+        ctx->p0 = NULL;
+        point_btree_init (&(ctx->point_btree), base_time, ctx->dimension);
+    } else {
+        ctx->p0 = point_new (ctx, base_time);
+        ctx->p0->ref_count = 1;
+        for (i = 0; i < ctx->dimension; ++i)
+            ctx->p0->remaining[i] = ctx->total_resources[i];
+        scheduled_point_insert (ctx->p0, &(ctx->sched_point_tree));
+        mintime_resource_insert (ctx->p0, ctx->dimension,
+                                 &(ctx->mt_resource_tree));
+    }
+    span_table_init (&(ctx->span_lookup), offsetof (span_t, span_id));
+    ctx->avail_time_iter = NULL;
     ctx->current_request = xzmalloc (sizeof (*(ctx->current_request)));
+    ctx->current_request->resources = xzmalloc (ctx->stride * sizeof (int64_t));
     ctx->avail_time_iter_set = 0;
     ctx->span_counter = 0;
 
@@ -639,23 +1174,37 @@ static void initialize (planner_t *ctx, int64_t base_time, uint64_t duration)
 
 static inline void erase (planner_t *ctx)
 {
-    struct rb_node *n = NULL;
-    if (ctx->span_lookup)
-        zhashx_purge (ctx->span_lookup);
-    zhashx_destroy (&(ctx->span_lookup));
+    span_table_destroy (&(ctx->span_lookup));
 
-    if (ctx->avail_time_iter) {
-        zhash_destroy (&ctx->avail_time_iter);
-        ctx->avail_time_iter = NULL;
-    }
+    ctx->avail_time_iter = NULL;
     if (ctx->current_request) {
+        free (ctx->current_request->resources);
         free (ctx->current_request);
         ctx->current_request = NULL;
     }
     if (ctx->p0 && ctx->p0->in_mt_resource_tree)
         mintime_resource_remove (ctx->p0, &(ctx->mt_resource_tree));
-    if ((n = ctx->sched_point_tree.rb_node))
-        scheduled_points_destroy (n);
+    ctx->sched_point_tree = RB_ROOT;
+    ctx->mt_resource_tree = RB_ROOT;
+    ctx->p0 = NULL;
+    // scheduled points and spans go back to the heap a whole slab at a time
+    slab_pool_release (&(ctx->point_pool));
+    slab_pool_release (&(ctx->span_pool));
+    if (ctx->backend == PLANNER_BACKEND_DELTA)
+        delta_tree_release (&(ctx->delta_tree));
+    else if (ctx->backend == PLANNER_BACKEND_BTREE)
+        point_btree_release (&(ctx->point_btree));
+}
+
+/*! Number of nodes on the longest path from n down to a leaf. */
+static size_t tree_height (const struct rb_node *n)
+{
+    size_t l = 0, r = 0;
+    if (!n)
+        return 0;
+    l = tree_height (n->rb_left);
+    r = tree_height (n->rb_right);
+    return 1 + ((l > r)? l : r);
 }
 
 static inline bool not_feasable (planner_t *ctx, int64_t start_time,
@@ -664,7 +1213,7 @@ static inline bool not_feasable (planner_t *ctx, int64_t start_time,
 {
     bool rc = (start_time < ctx->plan_start) || (duration < 1)
               || ((start_time + duration - 1) > ctx->plan_end)
-              || !resource_counts || (len > PLANNER_NUM_TYPES);
+              || !resource_counts || (len > ctx->dimension);
     return rc;
 }
 
@@ -679,13 +1228,14 @@ static int span_input_check (planner_t *ctx, int64_t start_time,
         goto done;
     } else {
         int64_t sum = 0;
-        for (i = 0; i < len; ++i) {
-            if (resource_counts[i] > ctx->total_resources[i]) {
-                errno = ERANGE;
-                goto done;
-            }
-            sum += resource_counts[i];
+        int64_t counts[ctx->stride];
+        copy_counts (ctx, counts, (const uint64_t *)resource_counts, len);
+        if (rescmp (counts, ctx->total_resources, len) > 0) {
+            errno = ERANGE;
+            goto done;
         }
+        for (i = 0; i < len; ++i)
+            sum += counts[i];
         if (sum <= 0) {
             errno = ERANGE;
             goto done;
@@ -697,36 +1247,439 @@ done:
     return rc;
 }
 
-static span_t *span_new (planner_t *ctx, int64_t start_time, uint64_t duration,
-                          const uint64_t *resource_counts, size_t len)
+static span_t *span_create (planner_t *ctx, int64_t start_time,
+                            uint64_t duration, const uint64_t *resource_counts,
+                            size_t len)
 {
     int i = 0;
-    char key[32];
-    span_t *span = NULL;
-    if (span_input_check (ctx, start_time, duration,
-                          (const int64_t *)resource_counts, len) == -1)
-        goto done;
-
-    span = xzmalloc (sizeof (*span));
+    span_t *span = slab_alloc (&(ctx->span_pool));
     span->start = start_time;
     span->last = start_time + duration;
     ctx->span_counter++;
     span->span_id = ctx->span_counter;
-    memset (span->planned, '\0', sizeof (span->planned));
     span->dimension = len;
     for (i = 0; i < len; ++i)
         span->planned[i] = (int64_t)resource_counts[i];
     span->in_system = 0;
     span->start_p = NULL;
     span->last_p = NULL;
-    sprintf (key, "%jd", (intmax_t)span->span_id);
-    zhashx_insert (ctx->span_lookup, key, span);
-    zhashx_freefn (ctx->span_lookup, key, free);
-done:
+    span_table_insert (&(ctx->span_lookup), span);
     return span;
 }
 
-
+static span_t *span_new (planner_t *ctx, int64_t start_time, uint64_t duration,
+                          const uint64_t *resource_counts, size_t len)
+{
+    if (span_input_check (ctx, start_time, duration,
+                          (const int64_t *)resource_counts, len) == -1)
+        return NULL;
+    return span_create (ctx, start_time, duration, resource_counts, len);
+}
+
+/*! Link a new span into the scheduled points. With defer, the min-time
+ *  resource tree is left to the end of the batch.
+ */
+static void span_insert (planner_t *ctx, span_t *span, bool defer)
+{
+    scheduled_point_t *start_point = NULL;
+    scheduled_point_t *last_point = NULL;
+
+    if (has_point_index (ctx)) {
+        OP_STAT (ctx, point_updates, index_update (ctx, span->start,
+                                                   span->last,
+                                                   span->planned, 1));
+        span->in_system = 1;
+        return;
+    }
+
+    start_point = get_or_new_point (ctx, span->start, defer);
+    start_point->ref_count++;
+    last_point = get_or_new_point (ctx, span->last, defer);
+    last_point->ref_count++;
+
+    update_points_add_span (ctx, span, defer);
+
+    start_point->new_point = 0;
+    span->start_p = start_point;
+    last_point->new_point = 0;
+    span->last_p = last_point;
+    span->in_system = 1;
+}
+
+/*! Free the point once no span refers to it anymore. */
+static void put_point (planner_t *ctx, scheduled_point_t *point)
+{
+    if (point->ref_count > 0)
+        return;
+    scheduled_point_remove (point, &(ctx->sched_point_tree));
+    if (point->in_mt_resource_tree)
+        mintime_resource_remove (point, &(ctx->mt_resource_tree));
+    slab_free (&(ctx->point_pool), point);
+}
+
+/*! Unlink the span from the scheduled points and free it. Without defer,
+ *  points that are no longer referenced are freed right away; with defer,
+ *  restore_track_points takes care of them at the end of the batch.
+ */
+static void span_erase (planner_t *ctx, span_t *span, bool defer)
+{
+    if (has_point_index (ctx)) {
+        OP_STAT (ctx, point_updates, index_update (ctx, span->start,
+                                                   span->last,
+                                                   span->planned, -1));
+        goto free_span;
+    }
+
+    span->start_p->ref_count--;
+    span->last_p->ref_count--;
+    if (defer) {
+        defer_point (ctx, span->start_p);
+        defer_point (ctx, span->last_p);
+    }
+    update_points_subtract_span (ctx, span, defer);
+    span->in_system = 0;
+
+    if (!defer) {
+        put_point (ctx, span->start_p);
+        put_point (ctx, span->last_p);
+        span->start_p = NULL;
+        span->last_p = NULL;
+    }
+
+free_span:
+    span_table_remove (&(ctx->span_lookup), span->span_id);
+    slab_free (&(ctx->span_pool), span);
+}
+
+/*! Check that the span still fits once moved to [start, last) with counts.
+ *  Where the new interval overlaps the old one, the span already holds its
+ *  old counts, so only the difference needs to be available there.
+ */
+static bool span_update_ok (planner_t *ctx, span_t *span, int64_t start,
+                            int64_t last, const int64_t *counts)
+{
+    int i = 0;
+    size_t len = ctx->dimension;
+    int64_t lo = (span->start > start)? span->start : start;
+    int64_t hi = (span->last < last)? span->last : last;
+    int64_t diff[ctx->stride];
+    if (lo >= hi)
+        return avail_during (ctx, start, last - start, counts, len);
+    for (i = 0; i < ctx->stride; ++i)
+        diff[i] = counts[i] - span->planned[i];
+    return (start >= lo || avail_during (ctx, start, lo - start, counts, len))
+           && avail_during (ctx, lo, hi - lo, diff, len)
+           && (last <= hi || avail_during (ctx, hi, last - hi, counts, len));
+}
+
+/*! Move the span to [start, last) with counts in place. On the scheduled
+ *  point tree, only the points covered by one of the old and new intervals
+ *  change, plus those covered by both if the counts change. The B+ tree
+ *  updates its points the same way, in one pass per interval. The delta tree
+ *  only ever touches the end points.
+ */
+static void span_update (planner_t *ctx, span_t *span, int64_t start,
+                         int64_t last, const int64_t *counts, size_t len)
+{
+    int i = 0;
+    int64_t lo = (span->start > start)? span->start : start;
+    int64_t hi = (span->last < last)? span->last : last;
+    int64_t diff[ctx->stride];
+    scheduled_point_t *start_point = NULL;
+    scheduled_point_t *last_point = NULL;
+
+    if (has_point_index (ctx)) {
+        // add first so that shared end points are never freed on the way
+        OP_STAT (ctx, point_updates, index_update (ctx, start, last, counts,
+                                                   1));
+        OP_STAT (ctx, point_updates, index_update (ctx, span->start,
+                                                   span->last, span->planned,
+                                                   -1));
+        goto done;
+    }
+
+    start_point = get_or_new_point (ctx, start, false);
+    start_point->ref_count++;
+    last_point = get_or_new_point (ctx, last, false);
+    last_point->ref_count++;
+
+    // Covered by the old interval only: the points before and after the new
+    // one; then the same for the new interval
+    update_points (ctx, span->start, (span->last < start)? span->last : start,
+                   span->planned, ctx->dimension, true, false);
+    update_points (ctx, (span->start > last)? span->start : last, span->last,
+                   span->planned, ctx->dimension, true, false);
+    update_points (ctx, start, (last < span->start)? last : span->start,
+                   counts, ctx->dimension, false, false);
+    update_points (ctx, (start > span->last)? start : span->last, last,
+                   counts, ctx->dimension, false, false);
+    if (lo < hi && memcmp (counts, span->planned,
+                           ctx->stride * sizeof (*counts)) != 0) {
+        for (i = 0; i < ctx->stride; ++i)
+            diff[i] = counts[i] - span->planned[i];
+        update_points (ctx, lo, hi, diff, ctx->dimension, false, false);
+    }
+
+    span->start_p->ref_count--;
+    span->last_p->ref_count--;
+    put_point (ctx, span->start_p);
+    put_point (ctx, span->last_p);
+    start_point->new_point = 0;
+    last_point->new_point = 0;
+    span->start_p = start_point;
+    span->last_p = last_point;
+
+done:
+    span->start = start;
+    span->last = last;
+    span->dimension = len;
+    memcpy (span->planned, counts, ctx->stride * sizeof (*counts));
+}
+
+/*! Fold all scheduled points before now into a single base time point at
+ *  now, which takes over the state at now (see planner_advance_base_time).
+ */
+static void points_advance (planner_t *ctx, int64_t now, int ref_count)
+{
+    struct rb_root *spt = &(ctx->sched_point_tree);
+    struct rb_root *mtrt = &(ctx->mt_resource_tree);
+    scheduled_point_t *point = NULL;
+    scheduled_point_t *p0 = get_or_new_point (ctx, now, false);
+    while ((point = rb_entry (rb_first (spt), scheduled_point_t,
+                              point_rb)) != p0) {
+        rb_erase_augmented (&(point->point_rb), spt, &scheduled_point_aug_cb);
+        if (point->in_mt_resource_tree)
+            mintime_resource_remove (point, mtrt);
+        slab_free (&(ctx->point_pool), point);
+    }
+    p0->new_point = 0;
+    p0->ref_count = ref_count;
+    ctx->p0 = p0;
+}
+
+typedef struct batch_entry {
+    int64_t start;
+    size_t index;
+} batch_entry_t;
+
+static int batch_entry_cmp (const void *a, const void *b)
+{
+    const batch_entry_t *x = (const batch_entry_t *)a;
+    const batch_entry_t *y = (const batch_entry_t *)b;
+    if (x->start != y->start)
+        return (x->start < y->start)? -1 : 1;
+    return (x->index < y->index)? -1 : (x->index > y->index);
+}
+
+/*! Maps the scheduled points of a planner to those of its clone, keyed by
+ *  the address of the source point, so that the links of the min-time
+ *  resource tree and of the spans are carried over without searching.
+ */
+typedef struct point_map {
+    int64_t from;                /* address of the source point */
+    scheduled_point_t *to;       /* its copy */
+} point_map_t;
+
+typedef struct clone_ctx {
+    planner_t *dst;
+    planner_t *src;
+    span_table_t map;            /* point_map_t by source point address */
+    point_map_t *entries;        /* storage of the map entries */
+    size_t n;                    /* number of entries in use */
+} clone_ctx_t;
+
+static inline scheduled_point_t *clone_of (clone_ctx_t *c,
+                                           scheduled_point_t *point)
+{
+    point_map_t *m = span_table_lookup (&(c->map), (int64_t)(intptr_t)point);
+    return m->to;
+}
+
+/*! Copy the scheduled point subtree rooted at n with the same shape and
+ *  colors, so the copy neither compares keys nor rebalances.
+ */
+static struct rb_node *point_tree_clone (clone_ctx_t *c, struct rb_node *n,
+                                         struct rb_node *parent)
+{
+    scheduled_point_t *o = NULL;
+    scheduled_point_t *p = NULL;
+    point_map_t *m = NULL;
+    if (!n)
+        return NULL;
+    o = rb_entry (n, scheduled_point_t, point_rb);
+    p = point_new (c->dst, o->at);
+    p->ref_count = o->ref_count;
+    memcpy (p->arrays, o->arrays, 3 * c->dst->stride * sizeof (*p->arrays));
+    if (o == c->src->p0)
+        c->dst->p0 = p;
+    m = &(c->entries[c->n++]);
+    m->from = (int64_t)(intptr_t)o;
+    m->to = p;
+    span_table_insert (&(c->map), m);
+    rb_set_parent_color (&(p->point_rb), parent, rb_color (n));
+    p->point_rb.rb_left = point_tree_clone (c, n->rb_left, &(p->point_rb));
+    p->point_rb.rb_right = point_tree_clone (c, n->rb_right, &(p->point_rb));
+    return &(p->point_rb);
+}
+
+/*! Same for the min-time resource tree. Copying its shape also keeps the
+ *  tree-shape dependent multi-type searches answering as they do on src.
+ */
+static struct rb_node *mt_resource_tree_clone (clone_ctx_t *c,
+                                               struct rb_node *n,
+                                               struct rb_node *parent)
+{
+    scheduled_point_t *o = NULL;
+    scheduled_point_t *p = NULL;
+    if (!n)
+        return NULL;
+    o = rb_entry (n, scheduled_point_t, resource_rb);
+    p = clone_of (c, o);
+    p->subtree_min = o->subtree_min;
+    p->in_mt_resource_tree = 1;
+    rb_set_parent_color (&(p->resource_rb), parent, rb_color (n));
+    p->resource_rb.rb_left = mt_resource_tree_clone (c, n->rb_left,
+                                                     &(p->resource_rb));
+    p->resource_rb.rb_right = mt_resource_tree_clone (c, n->rb_right,
+                                                      &(p->resource_rb));
+    return &(p->resource_rb);
+}
+
+/*! Copy the scheduled point trees of c->src into the empty ones of c->dst. */
+static void point_trees_clone (clone_ctx_t *c)
+{
+    scheduled_point_t *point = NULL;
+    planner_t *dst = c->dst;
+    planner_t *src = c->src;
+    c->n = 0;
+    c->entries = xzmalloc (src->point_pool.n_live * sizeof (*c->entries));
+    span_table_init (&(c->map), offsetof (point_map_t, from));
+    span_table_reserve (&(c->map), src->point_pool.n_live);
+    dst->sched_point_tree.rb_node = point_tree_clone (c,
+                                        src->sched_point_tree.rb_node, NULL);
+    dst->mt_resource_tree.rb_node = mt_resource_tree_clone (c,
+                                        src->mt_resource_tree.rb_node, NULL);
+    // The points an avail time iteration of src took out of its min-time
+    // resource tree go straight back in for the clone
+    for (point = src->avail_time_iter; point; point = point->tracked_next)
+        mintime_resource_insert (clone_of (c, point), dst->dimension,
+                                 &(dst->mt_resource_tree));
+}
+
+
+/*! Binary form of a planner (see serial.h). All fields are int64_t:
+ *
+ *    magic, backend, dimension, plan_start, plan_end, span_counter,
+ *    dimension x {total, type string},
+ *    n_points, n_points x {at, ref_count, dimension x scheduled},
+ *    n_mtr, n_mtr x point index,
+ *    n_spans, n_spans x {span_id, start index, last index, len,
+ *                        len x planned}
+ *
+ *  Points are in time order and are referred to by their index. The point
+ *  indices in min-time resource tree order let the tree be rebuilt as is;
+ *  there are none for the delta and B+ tree backends.
+ */
+#define PLANNER_SERIAL_MAGIC 0x31524e4c50LL    /* "PLNR1" */
+
+typedef struct serial_walk {
+    char *p;                     /* write cursor */
+    size_t dimension;
+    int64_t *times;              /* times of the points written so far */
+    size_t n;
+} serial_walk_t;
+
+static void serial_put_point (int64_t at, int ref_count,
+                              const int64_t *scheduled, void *arg)
+{
+    size_t i = 0;
+    serial_walk_t *w = (serial_walk_t *)arg;
+    serial_put (&(w->p), at);
+    serial_put (&(w->p), ref_count);
+    for (i = 0; i < w->dimension; ++i)
+        serial_put (&(w->p), scheduled[i]);
+    w->times[w->n++] = at;
+}
+
+static int64_t time_index (const int64_t *times, size_t n, int64_t at)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (times[mid] < at)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < n && times[lo] == at)? (int64_t)lo : -1;
+}
+
+static size_t serial_size (planner_t *ctx, size_t n_points, size_t n_mtr)
+{
+    size_t i = 0;
+    size_t size = (6 + ctx->dimension + 3) * sizeof (int64_t);
+    for (i = 0; i < ctx->dimension; ++i)
+        size += serial_str_size (ctx->resource_types[i]);
+    size += n_points * (2 + ctx->dimension) * sizeof (int64_t);
+    size += n_mtr * sizeof (int64_t);
+    for (i = 0; i < ctx->span_lookup.capacity; ++i) {
+        span_t *span = ctx->span_lookup.slots[i];
+        if (span)
+            size += (4 + span->dimension) * sizeof (int64_t);
+    }
+    return size;
+}
+
+/*! Rebuild the scheduled point and min-time resource trees of ctx from the
+ *  points in time order and their indices in min-time resource tree order.
+ *  Neither tree sees a single insertion.
+ */
+static int point_trees_build (planner_t *ctx, scheduled_point_t **points,
+                              size_t n, const int64_t *mtr, size_t n_mtr)
+{
+    size_t i = 0;
+    struct rb_node *node = NULL;
+    struct rb_node **nodes = xzmalloc ((n + 1) * sizeof (*nodes));
+    int rc = -1;
+
+    for (i = 0; i < n; ++i)
+        nodes[i] = &(points[i]->point_rb);
+    rb_build_sorted (nodes, n, &(ctx->sched_point_tree));
+    for (node = rb_first_postorder (&(ctx->sched_point_tree)); node;
+         node = rb_next_postorder (node)) {
+        scheduled_point_t *point = NULL;
+        point = rb_entry (node, scheduled_point_t, point_rb);
+        point_subtree_remaining (point, point->subtree_remaining);
+    }
+    ctx->p0 = points[0];
+
+    for (i = 0; i < n_mtr; ++i) {
+        scheduled_point_t *point = NULL;
+        if (mtr[i] < 0 || mtr[i] >= (int64_t)n
+            || (point = points[mtr[i]])->in_mt_resource_tree)
+            goto done;
+        point->in_mt_resource_tree = 1;
+        nodes[i] = &(point->resource_rb);
+    }
+    rb_build_sorted (nodes, n_mtr, &(ctx->mt_resource_tree));
+    for (node = rb_first_postorder (&(ctx->mt_resource_tree)); node;
+         node = rb_next_postorder (node)) {
+        scheduled_point_t *point = NULL;
+        point = rb_entry (node, scheduled_point_t, resource_rb);
+        point->subtree_min = mintime_resource_subtree_min (point);
+    }
+    // points that an avail time iteration had taken out of the tree
+    for (i = 0; i < n; ++i)
+        if (!points[i]->in_mt_resource_tree)
+            mintime_resource_insert (points[i], ctx->dimension,
+                                     &(ctx->mt_resource_tree));
+    rc = 0;
+done:
+    free (nodes);
+    return rc;
+}
+
+
 /*******************************************************************************
  *                                                                             *
  *                           PUBLIC PLANNER API                                *
@@ -737,31 +1690,399 @@ planner_t *planner_new (int64_t base_time, uint64_t duration,
                         const uint64_t *resource_totals,
                         const char **resource_types, size_t len)
 {
-    int i = 0;
+    return planner_new_backend (base_time, duration, resource_totals,
+                                resource_types, len, PLANNER_BACKEND_RBTREE);
+}
+
+planner_t *planner_new_backend (int64_t base_time, uint64_t duration,
+                                const uint64_t *resource_totals,
+                                const char **resource_types, size_t len,
+                                planner_backend_t backend)
+{
     planner_t *ctx = NULL;
+    planner_desc_t *desc = NULL;
 
-    if (duration < 1 || !resource_totals
-        || !resource_types || len > PLANNER_NUM_TYPES) {
+    if (duration < 1 || !backend_ok (backend)) {
         errno = EINVAL;
-        goto done;
-    } else {
-        for (i = 0; i < len; ++i) {
-            if (resource_totals[i] > INT64_MAX) {
-                errno = ERANGE;
+        return NULL;
+    }
+    if ( !(desc = planner_desc_new (resource_totals, resource_types, len)))
+        return NULL;
+    ctx = planner_new_with_desc (base_time, duration, desc, backend);
+    planner_desc_unref (&desc);
+    return ctx;
+}
+
+planner_desc_t *planner_desc_new (const uint64_t *resource_totals,
+                                  const char **resource_types, size_t len)
+{
+    size_t i = 0;
+    uint64_t hash = 0;
+    planner_desc_t *desc = NULL;
+
+    if (!resource_totals || !resource_types || len < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    for (i = 0; i < len; ++i) {
+        if (resource_totals[i] > INT64_MAX) {
+            errno = ERANGE;
+            return NULL;
+        }
+    }
+
+    hash = desc_hash (resource_totals, resource_types, len);
+    pthread_mutex_lock (&desc_table.lock);
+    if (desc_table.n_buckets) {
+        desc = desc_table.buckets[hash % desc_table.n_buckets];
+        for (; desc; desc = desc->next) {
+            if (desc->hash == hash
+                && desc_equal (desc, resource_totals, resource_types, len)) {
+                desc->ref_count++;
                 goto done;
             }
         }
     }
+    if (desc_table.size >= desc_table.n_buckets)
+        desc_table_grow ();
+    desc = desc_create (hash, resource_totals, resource_types, len);
+    desc->next = desc_table.buckets[hash % desc_table.n_buckets];
+    desc_table.buckets[hash % desc_table.n_buckets] = desc;
+    desc_table.size++;
+done:
+    pthread_mutex_unlock (&desc_table.lock);
+    return desc;
+}
 
-    ctx = xzmalloc (sizeof (*ctx));
-    for (i = 0; i < len; ++i) {
-        ctx->total_resources[i] = (int64_t)resource_totals[i];
-        ctx->resource_types[i] = xstrdup (resource_types[i]);
+planner_desc_t *planner_desc_ref (planner_desc_t *desc)
+{
+    if (!desc) {
+        errno = EINVAL;
+        return NULL;
     }
-    ctx->dimension = len;
+    pthread_mutex_lock (&desc_table.lock);
+    desc->ref_count++;
+    pthread_mutex_unlock (&desc_table.lock);
+    return desc;
+}
+
+void planner_desc_unref (planner_desc_t **desc_p)
+{
+    planner_desc_t *desc = NULL;
+    planner_desc_t **link = NULL;
+    if (!desc_p || !(desc = *desc_p))
+        return;
+    *desc_p = NULL;
+    pthread_mutex_lock (&desc_table.lock);
+    if (--desc->ref_count > 0) {
+        pthread_mutex_unlock (&desc_table.lock);
+        return;
+    }
+    link = &(desc_table.buckets[desc->hash % desc_table.n_buckets]);
+    while (*link != desc)
+        link = &((*link)->next);
+    *link = desc->next;
+    desc_table.size--;
+    pthread_mutex_unlock (&desc_table.lock);
+    desc_free (desc);
+}
+
+planner_t *planner_new_with_desc (int64_t base_time, uint64_t duration,
+                                  planner_desc_t *desc,
+                                  planner_backend_t backend)
+{
+    planner_t *ctx = NULL;
+
+    if (duration < 1 || !desc || !backend_ok (backend)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    resvec_init ();
+    ctx = xzmalloc (sizeof (*ctx));
+    ctx->backend = backend;
+    ctx->desc = planner_desc_ref (desc);
+    ctx->stride = desc->stride;
+    ctx->total_resources = desc->totals;
+    ctx->resource_types = desc->types;
+    ctx->dimension = desc->dimension;
+    slab_pool_init (&(ctx->point_pool), sizeof (scheduled_point_t)
+                                        + 3 * ctx->stride * sizeof (int64_t));
+    slab_pool_init (&(ctx->span_pool), sizeof (span_t)
+                                       + ctx->stride * sizeof (int64_t));
     initialize (ctx, base_time, duration);
+    return ctx;
+}
+
+planner_desc_t *planner_desc_of (planner_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return ctx->desc;
+}
+
+planner_t *planner_clone (planner_t *ctx)
+{
+    size_t i = 0;
+    clone_ctx_t c;
+
+    if (!ctx) {
+        errno = EINVAL;
+        return NULL;
+    }
+    memset (&c, 0, sizeof (c));
+    c.src = ctx;
+    if ( !(c.dst = planner_new_with_desc (ctx->plan_start,
+                                          ctx->plan_end - ctx->plan_start,
+                                          ctx->desc, ctx->backend)))
+        return NULL;
+
+    if (ctx->backend == PLANNER_BACKEND_DELTA) {
+        delta_tree_release (&(c.dst->delta_tree));
+        delta_tree_clone (&(c.dst->delta_tree), &(ctx->delta_tree));
+    } else if (ctx->backend == PLANNER_BACKEND_BTREE) {
+        point_btree_release (&(c.dst->point_btree));
+        point_btree_clone (&(c.dst->point_btree), &(ctx->point_btree));
+    } else {
+        // Swap the fresh base time point for a copy of ctx's trees
+        mintime_resource_remove (c.dst->p0, &(c.dst->mt_resource_tree));
+        slab_free (&(c.dst->point_pool), c.dst->p0);
+        point_trees_clone (&c);
+    }
+
+    span_table_reserve (&(c.dst->span_lookup), ctx->span_lookup.size);
+    for (i = 0; i < ctx->span_lookup.capacity; ++i) {
+        span_t *span = NULL;
+        span_t *o = ctx->span_lookup.slots[i];
+        if (!o)
+            continue;
+        span = slab_alloc (&(c.dst->span_pool));
+        memcpy (span, o, sizeof (*o) + o->dimension * sizeof (*o->planned));
+        if (ctx->backend == PLANNER_BACKEND_RBTREE) {
+            span->start_p = clone_of (&c, o->start_p);
+            span->last_p = clone_of (&c, o->last_p);
+        }
+        span_table_insert (&(c.dst->span_lookup), span);
+    }
+    c.dst->span_counter = ctx->span_counter;
+    span_table_destroy (&(c.map));
+    free (c.entries);
+    return c.dst;
+}
+
+int planner_serialize (planner_t *ctx, char **buf, size_t *size)
+{
+    size_t i = 0, j = 0;
+    size_t n_points = 0, n_mtr = 0;
+    scheduled_point_t *point = NULL;
+    struct rb_node *n = NULL;
+    serial_walk_t w;
 
+    if (!ctx || !buf || !size) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (has_point_index (ctx)) {
+        n_points = index_size (ctx);
+    } else {
+        n_points = ctx->point_pool.n_live;
+        n_mtr = n_points;
+        for (point = ctx->avail_time_iter; point; point = point->tracked_next)
+            n_mtr--;
+    }
+    *size = serial_size (ctx, n_points, n_mtr);
+    *buf = xzmalloc (*size);
+    w.p = *buf;
+    w.dimension = ctx->dimension;
+    w.times = xzmalloc ((n_points + 1) * sizeof (*w.times));
+    w.n = 0;
+
+    serial_put (&w.p, PLANNER_SERIAL_MAGIC);
+    serial_put (&w.p, ctx->backend);
+    serial_put (&w.p, ctx->dimension);
+    serial_put (&w.p, ctx->plan_start);
+    serial_put (&w.p, ctx->plan_end);
+    serial_put (&w.p, ctx->span_counter);
+    for (i = 0; i < ctx->dimension; ++i) {
+        serial_put (&w.p, ctx->total_resources[i]);
+        serial_put_str (&w.p, ctx->resource_types[i]);
+    }
+
+    serial_put (&w.p, n_points);
+    if (ctx->backend == PLANNER_BACKEND_DELTA) {
+        delta_tree_walk (&(ctx->delta_tree), serial_put_point, &w);
+    } else if (ctx->backend == PLANNER_BACKEND_BTREE) {
+        point_btree_walk (&(ctx->point_btree), serial_put_point, &w);
+    } else {
+        for (n = rb_first (&(ctx->sched_point_tree)); n; n = rb_next (n)) {
+            point = rb_entry (n, scheduled_point_t, point_rb);
+            serial_put_point (point->at, point->ref_count, point->scheduled,
+                              &w);
+        }
+    }
+    serial_put (&w.p, n_mtr);
+    for (n = rb_first (&(ctx->mt_resource_tree)); n; n = rb_next (n)) {
+        point = rb_entry (n, scheduled_point_t, resource_rb);
+        serial_put (&w.p, time_index (w.times, w.n, point->at));
+    }
+
+    serial_put (&w.p, ctx->span_lookup.size);
+    for (i = 0; i < ctx->span_lookup.capacity; ++i) {
+        span_t *span = ctx->span_lookup.slots[i];
+        if (!span)
+            continue;
+        serial_put (&w.p, span->span_id);
+        serial_put (&w.p, time_index (w.times, w.n, span->start));
+        serial_put (&w.p, time_index (w.times, w.n, span->last));
+        serial_put (&w.p, span->dimension);
+        for (j = 0; j < span->dimension; ++j)
+            serial_put (&w.p, span->planned[j]);
+    }
+    free (w.times);
+    return 0;
+}
+
+planner_t *planner_deserialize (const char *buf, size_t size)
+{
+    int64_t i = 0, j = 0;
+    int64_t magic = 0, backend = 0, dim = 0, start = 0, end = 0, counter = 0;
+    int64_t n = 0, n_mtr = 0, n_spans = 0;
+    const char *p = buf;
+    const char *e = buf + size;
+    uint64_t *totals = NULL;
+    char **types = NULL;
+    int64_t *at = NULL;
+    int64_t *refs = NULL;
+    int64_t *sched = NULL;
+    int64_t *mtr = NULL;
+    scheduled_point_t **points = NULL;
+    planner_t *ctx = NULL;
+
+    if (!buf || serial_get (&p, e, &magic) == -1
+        || magic != PLANNER_SERIAL_MAGIC
+        || serial_get (&p, e, &backend) == -1
+        || serial_get (&p, e, &dim) == -1
+        || serial_get (&p, e, &start) == -1
+        || serial_get (&p, e, &end) == -1
+        || serial_get (&p, e, &counter) == -1
+        || dim < 1 || dim > (e - p) / (int64_t)sizeof (int64_t)
+        || end <= start || counter < 0)
+        goto error;
+    totals = xzmalloc (dim * sizeof (*totals));
+    types = xzmalloc (dim * sizeof (*types));
+    for (i = 0; i < dim; ++i) {
+        const char *str = NULL;
+        int64_t len = 0;
+        if (serial_get (&p, e, (int64_t *)&totals[i]) == -1
+            || serial_get_str (&p, e, &str, &len) == -1)
+            goto error;
+        types[i] = xzmalloc (len + 1);
+        memcpy (types[i], str, len);
+    }
+    if ( !(ctx = planner_new_backend (start, end - start, totals,
+                                      (const char **)types, dim, backend)))
+        goto error;
+
+    // Points in time order: the first one is the base time point
+    if (serial_get (&p, e, &n) == -1 || n < 1
+        || n > (e - p) / (int64_t)((2 + dim) * sizeof (int64_t)))
+        goto error;
+    at = xzmalloc (n * sizeof (*at));
+    refs = xzmalloc (n * sizeof (*refs));
+    sched = xzmalloc (n * dim * sizeof (*sched));
+    for (i = 0; i < n; ++i) {
+        serial_get (&p, e, &at[i]);
+        serial_get (&p, e, &refs[i]);
+        for (j = 0; j < dim; ++j)
+            serial_get (&p, e, &sched[i * dim + j]);
+        if ((i == 0)? at[i] != start : at[i] <= at[i - 1])
+            goto error;
+    }
+    if (serial_get (&p, e, &n_mtr) == -1 || n_mtr < 0 || n_mtr > n
+        || n_mtr > (e - p) / (int64_t)sizeof (int64_t))
+        goto error;
+    mtr = xzmalloc ((n_mtr + 1) * sizeof (*mtr));
+    for (i = 0; i < n_mtr; ++i)
+        serial_get (&p, e, &mtr[i]);
+
+    if (backend == PLANNER_BACKEND_DELTA) {
+        delta_tree_release (&(ctx->delta_tree));
+        delta_tree_build (&(ctx->delta_tree), dim, n, at, refs, sched);
+    } else if (backend == PLANNER_BACKEND_BTREE) {
+        point_btree_release (&(ctx->point_btree));
+        point_btree_build (&(ctx->point_btree), dim, n, at, refs, sched);
+    } else {
+        mintime_resource_remove (ctx->p0, &(ctx->mt_resource_tree));
+        slab_free (&(ctx->point_pool), ctx->p0);
+        ctx->p0 = NULL;
+        ctx->sched_point_tree = RB_ROOT;
+        ctx->mt_resource_tree = RB_ROOT;
+        points = xzmalloc (n * sizeof (*points));
+        for (i = 0; i < n; ++i) {
+            points[i] = point_new (ctx, at[i]);
+            points[i]->ref_count = (int)refs[i];
+            for (j = 0; j < dim; ++j) {
+                points[i]->scheduled[j] = sched[i * dim + j];
+                points[i]->remaining[j] = ctx->total_resources[j]
+                                          - sched[i * dim + j];
+            }
+        }
+        if (point_trees_build (ctx, points, n, mtr, n_mtr) == -1)
+            goto error;
+    }
+
+    if (serial_get (&p, e, &n_spans) == -1 || n_spans < 0)
+        goto error;
+    for (i = 0; i < n_spans; ++i) {
+        int64_t id = 0, si = 0, li = 0, len = 0;
+        span_t *span = NULL;
+        if (serial_get (&p, e, &id) == -1 || serial_get (&p, e, &si) == -1
+            || serial_get (&p, e, &li) == -1 || serial_get (&p, e, &len) == -1
+            || id < 1 || id > counter || si < 0 || si >= li || li >= n
+            || len < 1 || len > dim)
+            goto error;
+        span = slab_alloc (&(ctx->span_pool));
+        span->span_id = id;
+        span->start = at[si];
+        span->last = at[li];
+        span->dimension = len;
+        span->in_system = 1;
+        for (j = 0; j < len; ++j)
+            if (serial_get (&p, e, &span->planned[j]) == -1)
+                goto error;
+        if (points) {
+            span->start_p = points[si];
+            span->last_p = points[li];
+        }
+        if (span_table_insert (&(ctx->span_lookup), span) == -1)
+            goto error;
+    }
+    if (p != e)
+        goto error;
+    ctx->span_counter = counter;
+    goto done;
+
+error:
+    if (ctx) {
+        // the trees may be half built: drop them with the slabs
+        ctx->p0 = NULL;
+        ctx->sched_point_tree = RB_ROOT;
+        ctx->mt_resource_tree = RB_ROOT;
+        planner_destroy (&ctx);
+    }
+    errno = EINVAL;
 done:
+    for (i = 0; types && i < dim; ++i)
+        free (types[i]);
+    free (types);
+    free (totals);
+    free (at);
+    free (refs);
+    free (sched);
+    free (mtr);
+    free (points);
     return ctx;
 }
 
@@ -777,15 +2098,63 @@ int planner_reset (planner_t *ctx, int64_t base_time, uint64_t duration)
     return 0;
 }
 
+int planner_advance_base_time (planner_t *ctx, int64_t now)
+{
+    size_t i = 0, n = 0;
+    int ref_count = 1;
+    span_t **expired = NULL;
+
+    if (!ctx || now < ctx->plan_start || now >= ctx->plan_end) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (now == ctx->plan_start)
+        return 0;
+
+    restore_track_points (ctx);
+    // Spans that are over by now go; those that are still running are
+    // clipped to start at now and refer to the new base time point.
+    expired = xzmalloc ((ctx->span_lookup.size + 1) * sizeof (*expired));
+    for (i = 0; i < ctx->span_lookup.capacity; ++i) {
+        span_t *span = ctx->span_lookup.slots[i];
+        if (!span)
+            continue;
+        if (span->last <= now) {
+            expired[n++] = span;
+        } else if (span->start <= now) {
+            span->start = now;
+            ref_count++;
+        }
+    }
+    for (i = 0; i < n; ++i) {
+        span_table_remove (&(ctx->span_lookup), expired[i]->span_id);
+        slab_free (&(ctx->span_pool), expired[i]);
+    }
+    free (expired);
+
+    if (ctx->backend == PLANNER_BACKEND_DELTA) {
+        delta_tree_advance (&(ctx->delta_tree), now, ref_count);
+    } else if (ctx->backend == PLANNER_BACKEND_BTREE) {
+        point_btree_advance (&(ctx->point_btree), now, ref_count);
+    } else {
+        points_advance (ctx, now, ref_count);
+        for (i = 0; i < ctx->span_lookup.capacity; ++i) {
+            span_t *span = ctx->span_lookup.slots[i];
+            if (span && span->start == now)
+                span->start_p = ctx->p0;
+        }
+    }
+    ctx->plan_start = now;
+    ctx->avail_time_iter_set = 0;
+    return 0;
+}
+
 void planner_destroy (planner_t **ctx_p)
 {
     if (ctx_p && *ctx_p) {
-        int i;
         restore_track_points (*ctx_p);
         erase (*ctx_p);
-        for (i = 0; i < (*ctx_p)->dimension; i++)
-            if ((*ctx_p)->resource_types[i])
-                free ((*ctx_p)->resource_types[i]);
+        planner_desc_unref (&((*ctx_p)->desc));
         free (*ctx_p);
         *ctx_p = NULL;
     }
@@ -800,6 +2169,15 @@ int64_t planner_base_time (planner_t *ctx)
     return ctx->plan_start;
 }
 
+planner_backend_t planner_backend (planner_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return PLANNER_BACKEND_RBTREE;
+    }
+    return ctx->backend;
+}
+
 int64_t planner_duration (planner_t *ctx)
 {
     if (!ctx) {
@@ -892,38 +2270,178 @@ int64_t planner_avail_time_first (planner_t *ctx, int64_t on_or_after,
         errno = EINVAL;
         return -1;
     }
-    if (rescmp ((const int64_t *)resource_counts,
+    copy_req (ctx, ctx->current_request, on_or_after, duration,
+              resource_counts, len);
+    if (rescmp (ctx->current_request->resources,
                 ctx->total_resources, len) > 0) {
         errno = ERANGE;
         return -1;
     }
     restore_track_points (ctx);
     ctx->avail_time_iter_set = 1;
-    copy_req (ctx->current_request, on_or_after, duration, resource_counts, len);
-    return avail_at (ctx, on_or_after, duration,
-                     (const int64_t *)resource_counts, len);
+    return avail_time_search (ctx);
 }
 
 int64_t planner_avail_time_next (planner_t *ctx)
 {
-    size_t len = 0;
-    int64_t on_or_after = -1;
-    uint64_t duration = 0;
-    const int64_t *resource_counts = NULL;
     if (!ctx || !ctx->avail_time_iter_set) {
         errno = EINVAL;
         return -1;
     }
-    len = ctx->current_request->dimension;
-    resource_counts = ctx->current_request->resources;
-    on_or_after = ctx->current_request->on_or_after;
-    duration = ctx->current_request->duration;
-    if (rescmp (resource_counts, ctx->total_resources, len) > 0) {
+    if (rescmp (ctx->current_request->resources, ctx->total_resources,
+                ctx->current_request->dimension) > 0) {
+        errno = ERANGE;
+        return -1;
+    }
+    return avail_time_search (ctx);
+}
+
+planner_avail_iter_t *planner_avail_iter_new (planner_t *ctx)
+{
+    planner_avail_iter_t *it = NULL;
+    if (!ctx) {
+        errno = EINVAL;
+        return NULL;
+    }
+    it = xzmalloc (sizeof (*it) + ctx->stride * sizeof (*it->resources));
+    it->ctx = ctx;
+    it->req.resources = it->resources;
+    return it;
+}
+
+void planner_avail_iter_destroy (planner_avail_iter_t **it_p)
+{
+    if (it_p && *it_p) {
+        // The cursor searched without writing to the planner: its counters
+        // are only handed over now, atomically, as other cursors may be
+        // destroyed concurrently
+        planner_t *ctx = (*it_p)->ctx;
+        __atomic_fetch_add (&(ctx->iter_searches), (*it_p)->searches,
+                            __ATOMIC_RELAXED);
+        __atomic_fetch_add (&(ctx->iter_candidates), (*it_p)->candidates,
+                            __ATOMIC_RELAXED);
+        free (*it_p);
+        *it_p = NULL;
+    }
+}
+
+int64_t planner_avail_iter_first (planner_avail_iter_t *it, int64_t on_or_after,
+                                  uint64_t duration,
+                                  const uint64_t *resource_counts, size_t len)
+{
+    planner_t *ctx = it? it->ctx : NULL;
+    if (!ctx || on_or_after < ctx->plan_start
+        || on_or_after >= ctx->plan_end || duration < 1
+        || !resource_counts || len > ctx->dimension) {
+        errno = EINVAL;
+        return -1;
+    }
+    copy_req (ctx, &(it->req), on_or_after, duration, resource_counts, len);
+    if (rescmp (it->req.resources, ctx->total_resources, len) > 0) {
         errno = ERANGE;
         return -1;
     }
-    return avail_at (ctx, on_or_after, duration,
-                     (const int64_t *)resource_counts, len);
+    it->set = 1;
+    return planner_avail_iter_next (it);
+}
+
+int64_t planner_avail_iter_next (planner_avail_iter_t *it)
+{
+    int64_t at = -1;
+    if (!it || !it->set) {
+        errno = EINVAL;
+        return -1;
+    }
+    it->req.checked = 0;
+    if (has_point_index (it->ctx))
+        at = index_avail_at (it->ctx, &(it->req));
+    else
+        at = scan_avail_at (it->ctx, &(it->req));
+    ITER_STAT (it, searches, 1);
+    ITER_STAT (it, candidates, it->req.checked);
+    return at;
+}
+
+int64_t planner_avail_time_common (planner_t **ctxs, size_t n,
+                                   int64_t on_or_after, uint64_t duration,
+                                   const uint64_t **resource_counts,
+                                   const size_t *lens)
+{
+    size_t i = 0, fit = 0;
+    int64_t at = INT64_MAX;
+    int64_t next = -1;
+    request_t *reqs = NULL;
+    int64_t *arrays = NULL;
+
+    if (!ctxs || n < 1 || duration < 1 || !resource_counts || !lens) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 0; i < n; ++i) {
+        planner_t *ctx = ctxs[i];
+        if (!ctx || on_or_after < ctx->plan_start
+            || on_or_after >= ctx->plan_end || !resource_counts[i]
+            || lens[i] > ctx->dimension) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    reqs = xzmalloc (n * sizeof (*reqs));
+    for (i = 0; i < n; ++i)
+        fit += ctxs[i]->stride;
+    arrays = xzmalloc (fit * sizeof (*arrays));
+    for (i = 0, fit = 0; i < n; ++i) {
+        planner_t *ctx = ctxs[i];
+        reqs[i].resources = arrays + fit;
+        fit += ctx->stride;
+        copy_req (ctx, &reqs[i], on_or_after, duration, resource_counts[i],
+                  lens[i]);
+        if (rescmp (reqs[i].resources, ctx->total_resources, lens[i]) > 0) {
+            errno = ERANGE;
+            at = -1;
+            goto done;
+        }
+        // start from the first state change at or after on_or_after
+        next = point_time_ceil (ctx, on_or_after);
+        if (next != -1 && next < at)
+            at = next;
+    }
+    if (at == INT64_MAX) {
+        at = -1;
+        goto done;
+    }
+
+    // Whenever a planner does not fit at the candidate time, none of the
+    // times up to its own next fit can work: jump there and check the others
+    // again, until they all fit at once.
+    for (i = 0, fit = 0; fit < n; i = (i + 1) % n) {
+        planner_t *ctx = ctxs[i];
+        if (at + (int64_t)duration > ctx->plan_end) {
+            at = -1;
+            break;
+        }
+        if (avail_during (ctx, at, duration, reqs[i].resources,
+                          reqs[i].dimension)) {
+            fit++;
+            continue;
+        }
+        reqs[i].on_or_after = at + 1;
+        next = has_point_index (ctx)
+                   ? index_avail_at (ctx, &reqs[i])
+                   : scan_avail_at (ctx, &reqs[i]);
+        if (next == -1) {
+            at = -1;
+            break;
+        }
+        at = next;
+        fit = 1;
+    }
+
+done:
+    free (arrays);
+    free (reqs);
+    return at;
 }
 
 int planner_avail_during (planner_t *ctx, int64_t start_time, uint64_t duration,
@@ -931,31 +2449,34 @@ int planner_avail_during (planner_t *ctx, int64_t start_time, uint64_t duration,
 {
     bool ok = false;
     int64_t result = -1;
-    if (!ctx || duration < 1 || !resource_counts|| len > ctx->dimension) {
+    if (!ctx || start_time < ctx->plan_start || duration < 1
+        || !resource_counts|| len > ctx->dimension) {
         errno = EINVAL;
         return -1;
     }
-    result = rescmp ((const int64_t *)resource_counts, ctx->total_resources, len);
+    int64_t counts[ctx->stride];
+    copy_counts (ctx, counts, resource_counts, len);
+    result = rescmp (counts, ctx->total_resources, len);
     if (result > 0) {
         errno = ERANGE;
         return -1;
     }
-    ok = avail_during (ctx, start_time, duration,
-                       (const int64_t *)resource_counts, len);
+    ok = avail_during (ctx, start_time, duration, counts, len);
     return ok? 0 : -1;
 }
 
 int64_t planner_avail_resources_during (planner_t *ctx, int64_t at,
                                         uint64_t duration, unsigned int i)
 {
-    scheduled_point_t *min_point = NULL;
-    if (!ctx || at > ctx->plan_end
-        || duration < 1 || i >= PLANNER_NUM_TYPES) {
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end
+        || duration < 1 || i >= ctx->dimension) {
         errno = EINVAL;
         return -1;
     }
-    min_point = avail_resources_during (ctx, at, duration);
-    return min_point->remaining[i];
+    int64_t remaining[ctx->stride];
+    if (avail_resources_during (ctx, at, duration, remaining) == -1)
+        return -1;
+    return remaining[i];
 }
 
 int64_t planner_avail_resources_during_by_type (planner_t *ctx, int64_t at,
@@ -963,8 +2484,8 @@ int64_t planner_avail_resources_during_by_type (planner_t *ctx, int64_t at,
                                                 const char *resource_type)
 {
     unsigned int i = 0;
-    scheduled_point_t *min_point = NULL;
-    if (!ctx || at > ctx->plan_end || duration < 1) {
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end
+        || duration < 1) {
         errno = EINVAL;
         return -1;
     }
@@ -972,45 +2493,45 @@ int64_t planner_avail_resources_during_by_type (planner_t *ctx, int64_t at,
         errno = EINVAL;
         return -1;
     }
-    min_point = avail_resources_during (ctx, at, duration);
-    return min_point->remaining[i];
+    int64_t remaining[ctx->stride];
+    if (avail_resources_during (ctx, at, duration, remaining) == -1)
+        return -1;
+    return remaining[i];
 }
 
 int planner_avail_resources_array_during (planner_t *ctx, int64_t at,
                                           uint64_t duration, int64_t *resources,
                                           size_t len)
 {
-    scheduled_point_t *min_point = NULL;
-    if (!ctx || at > ctx->plan_end || duration < 1
-        || !resources || len >= PLANNER_NUM_TYPES) {
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end
+        || duration < 1 || !resources || len > ctx->dimension) {
         errno = EINVAL;
         return -1;
     }
-    min_point = avail_resources_during (ctx, at, duration);
-    memcpy (resources, min_point->remaining, len * sizeof (*resources));
+    int64_t remaining[ctx->stride];
+    if (avail_resources_during (ctx, at, duration, remaining) == -1)
+        return -1;
+    memcpy (resources, remaining, len * sizeof (*resources));
     return 0;
 }
 
 int64_t planner_avail_resources_at (planner_t *ctx, int64_t at, unsigned int i)
 {
-    struct rb_root *spt = NULL;
-    scheduled_point_t *state = NULL;
-    if (!ctx || at > ctx->plan_end || i >= PLANNER_NUM_TYPES) {
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end
+        || i >= ctx->dimension) {
         errno = EINVAL;
         return -1;
     }
-    spt = &(ctx->sched_point_tree);
-    state = scheduled_point_state (at, spt);
-    return state->remaining[i];
+    int64_t remaining[ctx->stride];
+    avail_resources_at (ctx, at, remaining);
+    return remaining[i];
 }
 
 int64_t planner_avail_resources_at_by_type (planner_t *ctx, int64_t at,
                                             const char *resource_type)
 {
     unsigned int i = 0;
-    struct rb_root *spt = NULL;
-    scheduled_point_t *state = NULL;
-    if (!ctx || at > ctx->plan_end) {
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end) {
         errno = EINVAL;
         return -1;
     }
@@ -1018,24 +2539,22 @@ int64_t planner_avail_resources_at_by_type (planner_t *ctx, int64_t at,
         errno = EINVAL;
         return -1;
     }
-
-    spt = &(ctx->sched_point_tree);
-    state = scheduled_point_state (at, spt);
-    return state->remaining[i];
+    int64_t remaining[ctx->stride];
+    avail_resources_at (ctx, at, remaining);
+    return remaining[i];
 }
 
 int planner_avail_resources_array_at (planner_t *ctx, int64_t at,
                                       int64_t *resources, size_t len)
 {
-    struct rb_root *spt = NULL;
-    scheduled_point_t *state = NULL;
-    if (!ctx || at > ctx->plan_end || len > ctx->dimension) {
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end
+        || len > ctx->dimension) {
         errno = EINVAL;
         return -1;
     }
-    spt = &(ctx->sched_point_tree);
-    state = scheduled_point_state (at, spt);
-    memcpy (resources, state->remaining, len * sizeof (*resources));
+    int64_t remaining[ctx->stride];
+    avail_resources_at (ctx, at, remaining);
+    memcpy (resources, remaining, len * sizeof (*resources));
     return 0;
 }
 
@@ -1044,12 +2563,14 @@ int64_t planner_add_span (planner_t *ctx, int64_t start_time,
                           const uint64_t *resource_counts, size_t len)
 {
     span_t *span = NULL;
-    zlist_t *list = NULL;
-    scheduled_point_t *start_point = NULL;
-    scheduled_point_t *last_point = NULL;
 
-    if (!avail_during (ctx, start_time, duration,
-                       (const int64_t *)resource_counts, len)) {
+    if (!ctx || !resource_counts || len > ctx->dimension) {
+        errno = EINVAL;
+        return -1;
+    }
+    int64_t counts[ctx->stride];
+    copy_counts (ctx, counts, resource_counts, len);
+    if (!avail_during (ctx, start_time, duration, counts, len)) {
         errno = EINVAL;
         return -1;
     }
@@ -1057,75 +2578,111 @@ int64_t planner_add_span (planner_t *ctx, int64_t start_time,
         return -1;
 
     restore_track_points (ctx);
-    list = zlist_new ();
-    start_point = get_or_new_point (ctx, span->start);
-    start_point->ref_count++;
-    last_point = get_or_new_point (ctx, span->last);
-    last_point->ref_count++;
-
-    fetch_overlap_points (ctx, span->start, duration, list);
-    update_points_add_span (ctx, list, span);
+    span_insert (ctx, span, false);
+    OP_STAT (ctx, span_updates, 1);
+    ctx->avail_time_iter_set = 0;
+    return span->span_id;
+}
 
-    start_point->new_point = 0;
-    span->start_p = start_point;
-    last_point->new_point = 0;
-    span->last_p = last_point;
+int planner_add_spans (planner_t *ctx, size_t n, const int64_t *start_times,
+                       const uint64_t *durations,
+                       const uint64_t *resource_counts, size_t len,
+                       int64_t *span_ids, int *errors)
+{
+    size_t i = 0;
+    int added = 0;
+    batch_entry_t *order = NULL;
 
-    update_mintime_resource_tree (ctx, list);
+    if (!ctx || !start_times || !durations || !resource_counts
+        || !span_ids || len > ctx->dimension) {
+        errno = EINVAL;
+        return -1;
+    }
+    order = xzmalloc ((n? n : 1) * sizeof (*order));
+    for (i = 0; i < n; ++i) {
+        order[i].start = start_times[i];
+        order[i].index = i;
+    }
+    // Merge the new time points in time order: consecutive spans then touch
+    // neighboring scheduled points and the batch is deterministic.
+    qsort (order, n, sizeof (*order), batch_entry_cmp);
 
-    zlist_destroy (&list);
-    span->in_system = 1;
+    restore_track_points (ctx);
+    for (i = 0; i < n; ++i) {
+        size_t k = order[i].index;
+        span_t *span = NULL;
+        const uint64_t *req = resource_counts + k * len;
+        int64_t counts[ctx->stride];
+        span_ids[k] = -1;
+        if (span_input_check (ctx, start_times[k], durations[k],
+                              (const int64_t *)req, len) == -1)
+            goto next;
+        copy_counts (ctx, counts, req, len);
+        if (!avail_during (ctx, start_times[k], durations[k], counts, len)) {
+            errno = EINVAL;
+            goto next;
+        }
+        span = span_create (ctx, start_times[k], durations[k], req, len);
+        span_insert (ctx, span, true);
+        span_ids[k] = span->span_id;
+        added++;
+next:
+        if (errors)
+            errors[k] = (span_ids[k] == -1)? errno : 0;
+    }
+    restore_track_points (ctx);
+    OP_STAT (ctx, span_updates, added);
     ctx->avail_time_iter_set = 0;
+    free (order);
+    return added;
+}
 
-    return span->span_id;
+int planner_update_span (planner_t *ctx, int64_t span_id, int64_t start_time,
+                         uint64_t duration, const uint64_t *resource_counts,
+                         size_t len)
+{
+    span_t *span = NULL;
+
+    if (!ctx || !resource_counts || len > ctx->dimension
+        || !(span = span_table_lookup (&(ctx->span_lookup), span_id))) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (span_input_check (ctx, start_time, duration,
+                          (const int64_t *)resource_counts, len) == -1)
+        return -1;
+    int64_t counts[ctx->stride];
+    copy_counts (ctx, counts, resource_counts, len);
+    if (!span_update_ok (ctx, span, start_time, start_time + duration,
+                         counts)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    restore_track_points (ctx);
+    span_update (ctx, span, start_time, start_time + duration, counts, len);
+    OP_STAT (ctx, span_updates, 1);
+    ctx->avail_time_iter_set = 0;
+    return 0;
 }
 
 int planner_rem_span (planner_t *ctx, int64_t span_id)
 {
-    char key[32];
     int rc = -1;
     span_t *span = NULL;
-    zlist_t *list = NULL;
-    uint64_t duration = 0;
 
     if (!ctx) {
         errno = EINVAL;
         goto done;
     }
-    sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if ( !(span = span_table_lookup (&(ctx->span_lookup), span_id))) {
         errno = EINVAL;
         goto done;
     }
 
     restore_track_points (ctx);
-    list = zlist_new ();
-    duration = span->last - span->start;
-    span->start_p->ref_count--;
-    span->last_p->ref_count--;
-    fetch_overlap_points (ctx, span->start, duration, list);
-    update_points_subtract_span (ctx, list, span);
-    update_mintime_resource_tree (ctx, list);
-    span->in_system = 0;
-
-    if (span->start_p->ref_count == 0) {
-        struct rb_root *mtrt = &(ctx->mt_resource_tree);
-        scheduled_point_remove (span->start_p, &(ctx->sched_point_tree));
-        if (span->start_p->in_mt_resource_tree)
-            mintime_resource_remove (span->start_p, mtrt);
-        free (span->start_p);
-        span->start_p = NULL;
-    }
-    if (span->last_p->ref_count == 0) {
-        struct rb_root *mtrt = &(ctx->mt_resource_tree);
-        scheduled_point_remove (span->last_p, &(ctx->sched_point_tree));
-        if (span->last_p->in_mt_resource_tree)
-            mintime_resource_remove (span->last_p, mtrt);
-        free (span->last_p);
-        span->last_p = NULL;
-    }
-    zhashx_delete (ctx->span_lookup, key);
-    zlist_destroy (&list);
+    span_erase (ctx, span, false);
+    OP_STAT (ctx, span_updates, 1);
     ctx->avail_time_iter_set = 0;
     rc = 0;
 
@@ -1133,6 +2690,35 @@ done:
     return rc;
 }
 
+int planner_rem_spans (planner_t *ctx, size_t n, const int64_t *span_ids,
+                       int *errors)
+{
+    size_t i = 0;
+    int removed = 0;
+    span_t *span = NULL;
+
+    if (!ctx || !span_ids) {
+        errno = EINVAL;
+        return -1;
+    }
+    restore_track_points (ctx);
+    for (i = 0; i < n; ++i) {
+        if ( !(span = span_table_lookup (&(ctx->span_lookup), span_ids[i]))) {
+            if (errors)
+                errors[i] = EINVAL;
+            continue;
+        }
+        span_erase (ctx, span, true);
+        removed++;
+        if (errors)
+            errors[i] = 0;
+    }
+    restore_track_points (ctx);
+    OP_STAT (ctx, span_updates, removed);
+    ctx->avail_time_iter_set = 0;
+    return removed;
+}
+
 int64_t planner_span_first (planner_t *ctx)
 {
     int64_t rc = -1;
@@ -1141,7 +2727,7 @@ int64_t planner_span_first (planner_t *ctx)
         errno = EINVAL;
         goto done;
     }
-    if ( !(span = zhashx_first (ctx->span_lookup))) {
+    if ( !(span = span_table_first (&(ctx->span_lookup)))) {
         errno = EINVAL;
         goto done;
 
@@ -1159,7 +2745,7 @@ int64_t planner_span_next (planner_t *ctx)
         errno = EINVAL;
         goto done;
     }
-    if ( !(span = zhashx_next (ctx->span_lookup))) {
+    if ( !(span = span_table_next (&(ctx->span_lookup)))) {
         errno = EINVAL;
         goto done;
 
@@ -1175,21 +2761,87 @@ size_t planner_span_size (planner_t *ctx)
         errno = EINVAL;
         return 0;
     }
-    return zhashx_size (ctx->span_lookup);
+    return ctx->span_lookup.size;
 }
 
+int planner_alloc_counts (planner_t *ctx, uint64_t *objects, uint64_t *blocks)
+{
+    if (!ctx || !objects || !blocks) {
+        errno = EINVAL;
+        return -1;
+    }
+    *objects = ctx->point_pool.n_allocs + ctx->span_pool.n_allocs;
+    *blocks = ctx->point_pool.n_slabs + ctx->span_pool.n_slabs;
+    if (ctx->backend == PLANNER_BACKEND_DELTA) {
+        *objects += ctx->delta_tree.pool.n_allocs;
+        *blocks += ctx->delta_tree.pool.n_slabs;
+    } else if (ctx->backend == PLANNER_BACKEND_BTREE) {
+        *objects += ctx->point_btree.leaf_pool.n_allocs
+                    + ctx->point_btree.inner_pool.n_allocs;
+        *blocks += ctx->point_btree.leaf_pool.n_slabs
+                   + ctx->point_btree.inner_pool.n_slabs;
+    }
+    return 0;
+}
+
+
+int planner_stats (planner_t *ctx, planner_stats_t *stats)
+{
+    if (!ctx || !stats) {
+        errno = EINVAL;
+        return -1;
+    }
+    *stats = ctx->op_stats;
+    stats->searches += __atomic_load_n (&(ctx->iter_searches),
+                                        __ATOMIC_RELAXED);
+    stats->candidates += __atomic_load_n (&(ctx->iter_candidates),
+                                          __ATOMIC_RELAXED);
+    stats->spans = ctx->span_lookup.size;
+    // the types and totals live in the shared descriptor: not counted
+    stats->bytes = sizeof (*ctx) + sizeof (*ctx->current_request)
+                   + ctx->stride * sizeof (int64_t)
+                   + ctx->span_lookup.capacity * sizeof (void *)
+                   + ctx->point_pool.n_bytes + ctx->span_pool.n_bytes;
+    if (ctx->backend == PLANNER_BACKEND_DELTA) {
+        stats->points = delta_tree_size (&(ctx->delta_tree));
+        stats->point_tree_height = tree_height (ctx->delta_tree.root.rb_node);
+        stats->mt_tree_height = 0;
+        stats->bytes += ctx->delta_tree.pool.n_bytes;
+    } else if (ctx->backend == PLANNER_BACKEND_BTREE) {
+        stats->points = point_btree_size (&(ctx->point_btree));
+        stats->point_tree_height = ctx->point_btree.height;
+        stats->mt_tree_height = 0;
+        stats->bytes += ctx->point_btree.leaf_pool.n_bytes
+                        + ctx->point_btree.inner_pool.n_bytes;
+    } else {
+        stats->points = ctx->point_pool.n_live;
+        stats->point_tree_height = tree_height (ctx->sched_point_tree.rb_node);
+        stats->mt_tree_height = tree_height (ctx->mt_resource_tree.rb_node);
+    }
+    return 0;
+}
+
+int planner_stats_reset (planner_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset (&(ctx->op_stats), 0, sizeof (ctx->op_stats));
+    __atomic_store_n (&(ctx->iter_searches), 0, __ATOMIC_RELAXED);
+    __atomic_store_n (&(ctx->iter_candidates), 0, __ATOMIC_RELAXED);
+    return 0;
+}
 
 bool planner_is_active_span (planner_t *ctx, int64_t span_id)
 {
     bool rc = false;
-    char key[32];
     span_t *span = NULL;
     if (!ctx) {
         errno = EINVAL;
         goto done;
     }
-    sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if ( !(span = span_table_lookup (&(ctx->span_lookup), span_id))) {
         errno = EINVAL;
         goto done;
     }
@@ -1200,15 +2852,13 @@ done:
 
 int64_t planner_span_start_time (planner_t *ctx, int64_t span_id)
 {
-    char key[32];
     int64_t rc = -1;
     span_t *span = NULL;
     if (!ctx) {
         errno = EINVAL;
         goto done;
     }
-    sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if ( !(span = span_table_lookup (&(ctx->span_lookup), span_id))) {
         errno = EINVAL;
         goto done;
     }
@@ -1219,15 +2869,13 @@ done:
 
 int64_t planner_span_duration (planner_t *ctx, int64_t span_id)
 {
-    char key[32];
     int64_t rc = -1;
     span_t *span = NULL;
     if (!ctx) {
         errno = EINVAL;
         goto done;
     }
-    sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if ( !(span = span_table_lookup (&(ctx->span_lookup), span_id))) {
         errno = EINVAL;
         goto done;
     }
@@ -1239,15 +2887,13 @@ done:
 int64_t planner_span_resource_count_at (planner_t *ctx, int64_t span_id,
                                         unsigned int i)
 {
-    char key[32];
     int64_t rc = -1;
     span_t *span = NULL;
     if (!ctx) {
         errno = EINVAL;
         goto done;
     }
-    sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if ( !(span = span_table_lookup (&(ctx->span_lookup), span_id))) {
         errno = EINVAL;
         goto done;
     }
@@ -1259,7 +2905,6 @@ done:
 int64_t planner_span_resource_count_by_type (planner_t *ctx, int64_t span_id,
                                              const char *resource_type)
 {
-    char key[32];
     int64_t rc = -1;
     unsigned int i = 0;
     span_t *span = NULL;
@@ -1267,8 +2912,7 @@ int64_t planner_span_resource_count_by_type (planner_t *ctx, int64_t span_id,
         errno = EINVAL;
         goto done;
     }
-    sprintf (key, "%ju", (intmax_t)span_id);
-    if ( !(span = zhashx_lookup (ctx->span_lookup, key))) {
+    if ( !(span = span_table_lookup (&(ctx->span_lookup), span_id))) {
         errno = EINVAL;
         goto done;
     }
@@ -32,9 +32,30 @@
 extern "C" {
 #endif
 
-#define PLANNER_NUM_TYPES 5
-
 typedef struct planner planner_t;
+typedef struct planner_avail_iter planner_avail_iter_t;
+typedef struct planner_desc planner_desc_t;
+
+/*! Index structures a planner keeps its scheduled points in. All back the
+ *  same API and give the same answers.
+ *
+ *  PLANNER_BACKEND_RBTREE: scheduled point tree plus min-time resource tree.
+ *      Fast earliest-time search; a span add/remove costs O(k log n) for the
+ *      k scheduled points it overlaps. Window queries cost O(log n): each
+ *      point keeps the minimum remaining resources of its subtree.
+ *  PLANNER_BACKEND_DELTA: a single prefix-sum augmented tree of resource
+ *      deltas. A span add/remove and the minimum remaining resources over
+ *      any window cost O(log n) regardless of the schedule depth.
+ *  PLANNER_BACKEND_BTREE: a B+ tree whose leaves keep the times and the
+ *      resource states of their points in contiguous arrays. A span
+ *      add/remove costs O(k + log n) and walking the points of a window is a
+ *      linear scan, with few cache misses per point.
+ */
+typedef enum {
+    PLANNER_BACKEND_RBTREE = 0,
+    PLANNER_BACKEND_DELTA = 1,
+    PLANNER_BACKEND_BTREE = 2
+} planner_backend_t;
 
 /*! Construct a planner.
  *
@@ -45,14 +66,14 @@ typedef struct planner planner_t;
  *  \param resource_totals
  *                      64-bit unsigned integer array of size len where each
  *                      element contains the total count of available resources
- *                      of a single resource type. Up to PLANNER_NUM_TYPES types
- *                      are supported.
+ *                      of a single resource type. Any number of types is
+ *                      supported.
  *  \param resource_types
  *                      string array of size len where each element contains
  *                      the resource type corresponding to each corresponding
  *                      element in the resource_totals array.
  *  \param len          length of the resource_totals and resource_types arrays;
- *                      must not exceed PLANNER_NUM_TYPES.
+ *                      must be at least 1.
  *  \return             new planner context; NULL on an error with errno set
  *                      as follows:
  *                      0 on success; -1 on an error with errno set:
@@ -63,6 +84,89 @@ planner_t *planner_new (int64_t base_time, uint64_t duration,
                         const uint64_t *resource_totals,
                         const char **resource_types, size_t len);
 
+/*! Construct a planner that uses the given backend. planner_new is
+ *  equivalent to passing PLANNER_BACKEND_RBTREE.
+ *
+ *  \param backend      scheduled point index backend.
+ *  \return             same as planner_new.
+ */
+planner_t *planner_new_backend (int64_t base_time, uint64_t duration,
+                                const uint64_t *resource_totals,
+                                const char **resource_types, size_t len,
+                                planner_backend_t backend);
+
+/*! Return a reference to the immutable descriptor of the resource types and
+ *  totals in resource_types and resource_totals. Descriptors are interned:
+ *  the same types and totals in the same order always yield the same
+ *  descriptor, which every planner built with them shares instead of keeping
+ *  a copy. planner_new interns its types and totals the same way. The
+ *  intern table is safe to use from several threads.
+ *
+ *  \return             descriptor with a new reference; NULL on an error
+ *                      with errno set as planner_new does.
+ */
+planner_desc_t *planner_desc_new (const uint64_t *resource_totals,
+                                  const char **resource_types, size_t len);
+
+//! Take one more reference to the descriptor and return it.
+planner_desc_t *planner_desc_ref (planner_desc_t *desc);
+
+//! Drop a reference; the last one frees the descriptor. Sets *desc_p NULL.
+void planner_desc_unref (planner_desc_t **desc_p);
+
+/*! Construct a planner whose resource types and totals are those of desc.
+ *  The planner takes its own reference to desc, so the caller may drop its
+ *  own right after. Otherwise the same as planner_new_backend.
+ */
+planner_t *planner_new_with_desc (int64_t base_time, uint64_t duration,
+                                  planner_desc_t *desc,
+                                  planner_backend_t backend);
+
+//! Return the descriptor the planner refers to; the planner owns the reference.
+planner_desc_t *planner_desc_of (planner_t *ctx);
+
+/*! Construct a deep copy of the planner: same backend, time bound, resource
+ *  types and totals, and the same planned spans under the same span ids.
+ *  The scheduled point trees are copied node for node in O(n) without any
+ *  rebalancing, so the clone answers every query exactly as ctx does. The
+ *  clone and ctx are independent from then on; an avail time iteration in
+ *  progress on ctx is not carried over.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \return             new planner context; NULL on an error with errno set
+ *                      as follows:
+ *                          EINVAL: invalid argument.
+ */
+planner_t *planner_clone (planner_t *ctx);
+
+/*! Serialize the planner into a compact binary form: its time bound,
+ *  resource types and totals, scheduled points in time order and planned
+ *  spans. The form is in host byte order and is meant to be read back by
+ *  planner_deserialize on the same kind of host.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param buf          set to a newly allocated buffer holding the planner;
+ *                      the caller must free it.
+ *  \param size         set to the size of *buf in bytes.
+ *  \return             0 on success; -1 on an error with errno set as follows:
+ *                          EINVAL: invalid argument.
+ */
+int planner_serialize (planner_t *ctx, char **buf, size_t *size);
+
+/*! Construct a planner from the output of planner_serialize. Both scheduled
+ *  point trees are linked in O(n) straight from the sorted points, with no
+ *  tree insertion or rebalancing, so loading a planner costs about as much
+ *  as reading it. The planner has the same resource state and planned
+ *  spans, under the same span ids, as the one serialized.
+ *
+ *  \param buf          buffer filled by planner_serialize.
+ *  \param size         size of buf in bytes.
+ *  \return             new planner context; NULL on an error with errno set
+ *                      as follows:
+ *                          EINVAL: invalid argument or malformed buf.
+ */
+planner_t *planner_deserialize (const char *buf, size_t size);
+
 /*! Reset the planner with a new time bound. Destroy all existing planned spans.
  *
  *  \param ctx          opaque planner context returned from planner_new.
@@ -75,6 +179,23 @@ planner_t *planner_new (int64_t base_time, uint64_t duration,
  */
 int planner_reset (planner_t *ctx, int64_t base_time, uint64_t duration);
 
+/*! Move the base time of the planner forward to now and drop its history.
+ *  All scheduled points before now are folded into a single base time point
+ *  at now that keeps the resource state at now. Spans that end at or before
+ *  now are removed; spans still running at now are clipped to start at now.
+ *  The remaining spans keep their ids and the end time of the planner does
+ *  not change. Queries then only pay for the live part of the schedule.
+ *  Times before now are gone: the avail_during and avail_resources queries
+ *  reject them with EINVAL like times past the end of the planner.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param now          new base time; must lie within the current time
+ *                      bound of the planner.
+ *  \return             0 on success; -1 on an error with errno set as follows:
+ *                          EINVAL: invalid argument.
+ */
+int planner_advance_base_time (planner_t *ctx, int64_t now);
+
 /*! Destroy the planner.
  *
  *  \param ctx_p        pointer to a planner context pointer returned.
@@ -88,6 +209,7 @@ void planner_destroy (planner_t **ctx_p);
  *                         EINVAL: invalid argument.
  */
 int64_t planner_base_time (planner_t *ctx);
+planner_backend_t planner_backend (planner_t *ctx);
 int64_t planner_duration (planner_t *ctx);
 size_t planner_resources_len (planner_t *ctx);
 int64_t planner_resource_total_at (planner_t *ctx, unsigned int i);
@@ -115,7 +237,7 @@ const char *planner_resource_type_at (planner_t *ctx, unsigned int i);
  *                      64-bit unsigned integer array of size len specifying
  *                      the requested resource counts.
  *  \param len          length of resource_counts and resource_types arrays;
- *                      must not exceed PLANNER_NUM_TYPES.
+ *                      must not exceed planner_resources_len ().
  *  \return             earliest time at which the request can be satisfied;
  *                      -1 on an error with errno set as follows:
  *                          EINVAL: invalid argument.
@@ -137,6 +259,61 @@ int64_t planner_avail_time_first (planner_t *ctx, int64_t on_or_after,
  */
 int64_t planner_avail_time_next (planner_t *ctx);
 
+/*! Availability cursor: an earliest-time search that keeps its request and
+ *  position to itself instead of in the planner, and never modifies the
+ *  planner. Any number of cursors can search the same planner at once, even
+ *  from different threads, as long as no thread updates the planner in the
+ *  meantime. Spans added or removed between two calls are taken into
+ *  account from the cursor position on. A cursor must be destroyed before
+ *  its planner: the searches it ran are added to the planner's statistics
+ *  (see planner_stats) when it is.
+ *
+ *  \return             new cursor; NULL on an error with errno set as follows:
+ *                          EINVAL: invalid argument.
+ */
+planner_avail_iter_t *planner_avail_iter_new (planner_t *ctx);
+void planner_avail_iter_destroy (planner_avail_iter_t **it_p);
+
+/*! Find the earliest time on or after on_or_after at which the request can
+ *  be satisfied, and then each next one in time order. Parameters and
+ *  errors are those of planner_avail_time_first and planner_avail_time_next.
+ *  With one resource type, the times are also theirs. With several, the
+ *  cursor returns every scheduled point at which the request fits, in time
+ *  order, while those functions can skip some of them.
+ */
+int64_t planner_avail_iter_first (planner_avail_iter_t *it, int64_t on_or_after,
+                                  uint64_t duration,
+                                  const uint64_t *resource_counts, size_t len);
+int64_t planner_avail_iter_next (planner_avail_iter_t *it);
+
+/*! Find the earliest time at which n planners can all satisfy their own
+ *  request for the same duration, e.g., the subtree plans of several
+ *  resource vertices that a job needs at once. Same semantics as
+ *  planner_avail_time_first: the time returned is a scheduled point of at
+ *  least one of the planners. Whenever a planner cannot satisfy its request
+ *  at a candidate time, the search jumps straight to the next time at which
+ *  that planner alone can, so no time in between is ever tried. None of the
+ *  planners is modified.
+ *
+ *  \param ctxs         array of n planners.
+ *  \param n            number of planners; must be at least 1.
+ *  \param on_or_after  available on or after the specified time.
+ *  \param duration     requested duration; must be greater than or equal to 1.
+ *  \param resource_counts
+ *                      array of n resource count arrays, one per planner.
+ *  \param lens         array of the n lengths of resource_counts; each must
+ *                      not exceed planner_resources_len () of its planner.
+ *  \return             earliest time at which every request can be satisfied;
+ *                      -1 if there is none or on an error with errno set as
+ *                      follows:
+ *                          EINVAL: invalid argument.
+ *                          ERANGE: resource_counts contain an out-of-range value.
+ */
+int64_t planner_avail_time_common (planner_t **ctxs, size_t n,
+                                   int64_t on_or_after, uint64_t duration,
+                                   const uint64_t **resource_counts,
+                                   const size_t *lens);
+
 /*! Test if the given request can be satisfied at the start time.
  *  Note on semantics: Unlike planner_avail_time* functions, this function
  *  can be used to test an arbitrary time span.
@@ -149,7 +326,7 @@ int64_t planner_avail_time_next (planner_t *ctx);
  *                      64-bit unsigned integer array of size len specifying
  *                      the requested resource counts.
  *  \param len          length of resource_counts and resource_types arrays.
- *                      must not exceed PLANNER_NUM_TYPES.
+ *                      must not exceed planner_resources_len ().
  *  \return             0 if the request can be satisfied; -1 if it cannot
  *                      be satisfied or an error encountered (errno as follows):
  *                          EINVAL: invalid argument.
@@ -165,7 +342,7 @@ int planner_avail_during (planner_t *ctx, int64_t at, uint64_t duration,
  *  \param at           instant time for which this query is made.
  *  \param duration     requested duration; must be greater than or equal to 1.
  *  \param i            index of the resource type to queried; must be less than
- *                      PLANNER_NUM_TYPES.
+ *                      planner_resources_len ().
  *  \return             available resource count; -1 on an error with errno set
  *                      as follows:
  *                          EINVAL: invalid argument.
@@ -211,7 +388,7 @@ int planner_avail_resources_array_during (planner_t *ctx, int64_t at,
  *  \param ctx          opaque planner context returned from planner_new.
  *  \param at           instant time for which this query is made.
  *  \param i            index of the resource type to queried; must be less than
- *                      PLANNER_NUM_TYPES.
+ *                      planner_resources_len ().
  *  \return             available resource count; -1 on an error with errno set
  *                      as follows:
  *                          EINVAL: invalid argument.
@@ -260,7 +437,7 @@ int planner_avail_resources_array_at (planner_t *ctx, int64_t at,
  *                      64-bit unsigned integer array of size len specifying
  *                      the requested resource counts.
  *  \param len          length of resource_counts and resource_types array;
- *                      must not exceed PLANNER_NUM_TYPES.
+ *                      must not exceed planner_resources_len ().
  *
  *  \return             span id on success; -1 on an error with errno set as follows:
  *                          EINVAL: invalid argument.
@@ -271,6 +448,34 @@ int planner_avail_resources_array_at (planner_t *ctx, int64_t at,
 int64_t planner_add_span (planner_t *ctx, int64_t start_time, uint64_t duration,
                           const uint64_t *resource_counts, size_t len);
 
+/*! Move, resize or change the resource counts of an existing span in place:
+ *  same as removing it and adding it back with the new values, except that
+ *  the span keeps its id. Only the scheduled points that the old and new
+ *  spans do not share are updated, plus the shared ones if the counts change.
+ *  Reset the planner's iterator such that planner_avail_time_next will be
+ *  made to return the earliest schedulable point.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param span_id      span_id returned from planner_add_span.
+ *  \param start_time   new start time of the span.
+ *  \param duration     new duration of the span; must be greater than or
+ *                      equal to 1.
+ *  \param resource_counts
+ *                      64-bit unsigned integer array of size len specifying
+ *                      the new resource counts of the span.
+ *  \param len          length of resource_counts; must not exceed
+ *                      planner_resources_len ().
+ *  \return             0 on success; -1 on an error with errno set as follows
+ *                      (the span is then left as it was):
+ *                          EINVAL: invalid argument, unknown span id or the
+ *                                  updated span does not fit.
+ *                          ERANGE: resource_counts contain an out-of-range
+ *                                  value.
+ */
+int planner_update_span (planner_t *ctx, int64_t span_id, int64_t start_time,
+                         uint64_t duration, const uint64_t *resource_counts,
+                         size_t len);
+
 /*! Remove the existing span from the planner and update its resource/time state.
  *  Reset the planner's iterator such that planner_avail_time_next will be made
  *  to return the earliest schedulable point.
@@ -285,11 +490,105 @@ int64_t planner_add_span (planner_t *ctx, int64_t start_time, uint64_t duration,
  */
 int planner_rem_span (planner_t *ctx, int64_t span_id);
 
+/*! Add n spans in one batch. Spans are applied in ascending order of their
+ *  start times (ties in array order) and each is checked against the planner
+ *  state including the spans applied before it, so a batch that
+ *  oversubscribes a window rejects the later starting spans. Scheduled
+ *  points touched by the batch are re-indexed only once, at its end, which
+ *  makes this much faster than n planner_add_span calls for large or
+ *  overlapping batches.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param n            number of spans.
+ *  \param start_times  array of n start times.
+ *  \param durations    array of n durations.
+ *  \param resource_counts
+ *                      n x len row-major array of the requested resource
+ *                      counts of each span.
+ *  \param len          number of resource counts per span; must not exceed
+ *                      planner_resources_len ().
+ *  \param span_ids     array of n entries filled with the new span id of each
+ *                      span or -1 if it could not be added.
+ *  \param errors       optional array of n entries filled with 0 or the errno
+ *                      value planner_add_span would have set for each span.
+ *  \return             number of spans added; -1 on an invalid argument with
+ *                      errno set to EINVAL.
+ */
+int planner_add_spans (planner_t *ctx, size_t n, const int64_t *start_times,
+                       const uint64_t *durations,
+                       const uint64_t *resource_counts, size_t len,
+                       int64_t *span_ids, int *errors);
+
+/*! Remove n spans in one batch. Same as calling planner_rem_span for each,
+ *  but scheduled points are re-indexed or freed only once, at the end.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param n            number of spans.
+ *  \param span_ids     array of n span ids returned from planner_add_span(s).
+ *  \param errors       optional array of n entries filled with 0 or EINVAL
+ *                      for span ids that are not found.
+ *  \return             number of spans removed; -1 on an invalid argument with
+ *                      errno set to EINVAL.
+ */
+int planner_rem_spans (planner_t *ctx, size_t n, const int64_t *span_ids,
+                       int *errors);
+
 //! Span iterators -- there is no specific iteration order
 int64_t planner_span_first (planner_t *ctx);
 int64_t planner_span_next (planner_t *ctx);
 size_t planner_span_size (planner_t *ctx);
 
+/*! Return the allocation counters of the planner's internal object pools.
+ *  Scheduled points and spans are carved out of slabs, so the number of heap
+ *  blocks is far smaller than the number of objects the planner has used.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param objects      number of scheduled point and span objects allocated
+ *                      since the planner was created or last reset.
+ *  \param blocks       number of heap blocks (slabs) backing those objects.
+ *  \return             0 on success; -1 on an error with errno set as follows:
+ *                          EINVAL: invalid argument.
+ */
+int planner_alloc_counts (planner_t *ctx, uint64_t *objects, uint64_t *blocks);
+
+/*! Internal statistics of a planner (see planner_stats). */
+typedef struct planner_stats {
+    size_t points;               /* scheduled points */
+    size_t spans;                /* spans */
+    size_t point_tree_height;    /* height of the scheduled point tree */
+    size_t mt_tree_height;       /* height of the min-time resource tree */
+    size_t bytes;                /* heap bytes held by the planner, not
+                                    counting its shared descriptor */
+    uint64_t searches;           /* earliest-time searches */
+    uint64_t candidates;         /* candidate times checked by them */
+    uint64_t mt_visits;          /* min-time resource tree nodes visited */
+    uint64_t span_updates;       /* spans added, updated or removed */
+    uint64_t point_updates;      /* scheduled points updated by them */
+} planner_stats_t;
+
+/*! Fill stats with the state of the planner's internal data structures and
+ *  its per-operation counters. A degenerate schedule shows up as many points
+ *  or spans, or as searches that check far more candidates than they return.
+ *  With the delta and B+ tree backends, point_tree_height is that of their
+ *  single index and mt_tree_height and mt_visits stay 0. Searches count
+ *  planner_avail_time_first and planner_avail_time_next as well as each
+ *  first and next call of the availability cursors destroyed so far;
+ *  planner_avail_time_common is not counted.
+ *
+ *  The counters run from planner creation or the last planner_stats_reset.
+ *  They cost an increment per operation; building planner.c with
+ *  -DPLANNER_NO_OP_STATS compiles them out and leaves them at 0.
+ *
+ *  \param ctx          opaque planner context returned from planner_new.
+ *  \param stats        statistics to fill in.
+ *  \return             0 on success; -1 on an error with errno set as follows:
+ *                          EINVAL: invalid argument.
+ */
+int planner_stats (planner_t *ctx, planner_stats_t *stats);
+
+//! Zero the per-operation counters of the planner.
+int planner_stats_reset (planner_t *ctx);
+
 //! Return 0 if the span has been inserted and active in the planner
 bool planner_is_active_span (planner_t *ctx, int64_t span_id);
 
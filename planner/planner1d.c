@@ -0,0 +1,1097 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "rbtree.h"
+#include "rbtree_augmented.h"
+#include "xzmalloc.h"
+#include "slab.h"
+#include "span_table.h"
+#include "serial.h"
+#include "planner1d.h"
+
+/*! Scheduled point: a delta tree node with scalar aggregates. The scheduled
+ *  resources at a point are the prefix sum of the deltas up to it.
+ */
+typedef struct point1d {
+    struct rb_node rb;           /* BST node keyed by time */
+    int64_t at;                  /* resource-state changing time */
+    int64_t delta;               /* change of scheduled resources at */
+    int64_t sum;                 /* sum of deltas in the subtree */
+    int64_t max;                 /* max prefix sum within the subtree */
+    int64_t min;                 /* min prefix sum within the subtree */
+    int ref_count;               /* number of span end points at this time */
+} point1d_t;
+
+typedef struct span1d {
+    int64_t span_id;             /* unique span id */
+    int64_t start;               /* start time of the span */
+    int64_t last;                /* end time of the span */
+    int64_t planned;             /* required resources */
+} span1d_t;
+
+/*! Scheduled points and spans of a planner. Only materialized when the
+ *  first span is added: until then, the planner is idle and all of its
+ *  resources are available throughout. Clones share the state of their
+ *  source until either side updates it (see own_state).
+ */
+typedef struct planner1d_state {
+    int refs;                    /* number of planners sharing this state */
+    struct rb_root root;         /* scheduled point rb tree */
+    point1d_t p0;                /* never removed point at base time */
+    span_table_t span_lookup;    /* span lookup table by span id */
+    uint64_t span_counter;       /* current span counter */
+    slab_pool_t point_pool;      /* scheduled point allocator */
+    slab_pool_t span_pool;       /* span allocator */
+} planner1d_state_t;
+
+struct planner1d {
+    int64_t total;               /* total resources */
+    int64_t plan_start;          /* base time of the planner */
+    int64_t plan_end;            /* end time of the planner */
+    planner1d_state_t *s;        /* NULL while the planner is idle */
+    size_t span_iter;            /* span iteration cursor */
+    int64_t on_or_after;         /* avail time iteration cursor */
+    uint64_t duration;           /* requested duration of the iteration */
+    int64_t request;             /* requested resources of the iteration */
+    int avail_time_iter_set;     /* iterator set flag */
+};
+
+#define POINT_ENTRY(n) rb_entry ((n), point1d_t, rb)
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                        Subtree Prefix Sum Augmentation                      *
+ *                                                                             *
+ *******************************************************************************/
+
+static bool point_compute (point1d_t *p)
+{
+    point1d_t *l = p->rb.rb_left? POINT_ENTRY (p->rb.rb_left) : NULL;
+    point1d_t *r = p->rb.rb_right? POINT_ENTRY (p->rb.rb_right) : NULL;
+    int64_t pre = (l? l->sum : 0) + p->delta;
+    int64_t sum = pre + (r? r->sum : 0);
+    int64_t max = pre;
+    int64_t min = pre;
+    if (l && l->max > max)
+        max = l->max;
+    if (l && l->min < min)
+        min = l->min;
+    if (r && pre + r->max > max)
+        max = pre + r->max;
+    if (r && pre + r->min < min)
+        min = pre + r->min;
+    if (sum == p->sum && max == p->max && min == p->min)
+        return false;
+    p->sum = sum;
+    p->max = max;
+    p->min = min;
+    return true;
+}
+
+static void point_propagate (struct rb_node *n, struct rb_node *stop)
+{
+    while (n != stop) {
+        if (!point_compute (POINT_ENTRY (n)))
+            break;
+        n = rb_parent (n);
+    }
+}
+
+static void point_copy (struct rb_node *src, struct rb_node *dst)
+{
+    point1d_t *o = POINT_ENTRY (src);
+    point1d_t *n = POINT_ENTRY (dst);
+    n->sum = o->sum;
+    n->max = o->max;
+    n->min = o->min;
+}
+
+static void point_rotate (struct rb_node *src, struct rb_node *dst)
+{
+    point_copy (src, dst);
+    point_compute (POINT_ENTRY (src));
+}
+
+static const struct rb_augment_callbacks point_aug_cb = {
+    point_propagate, point_copy, point_rotate
+};
+
+static void point_refresh (struct rb_node *n)
+{
+    for (; n; n = rb_parent (n))
+        point_compute (POINT_ENTRY (n));
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                         Scheduled Point Management                          *
+ *                                                                             *
+ *******************************************************************************/
+
+static point1d_t *point_search (planner1d_state_t *s, int64_t at)
+{
+    struct rb_node *node = s->root.rb_node;
+    while (node) {
+        point1d_t *this_data = POINT_ENTRY (node);
+        if (at < this_data->at)
+            node = node->rb_left;
+        else if (at > this_data->at)
+            node = node->rb_right;
+        else
+            return this_data;
+    }
+    return NULL;
+}
+
+static void point_link (planner1d_state_t *s, point1d_t *point)
+{
+    struct rb_node **link = &(s->root.rb_node);
+    struct rb_node *parent = NULL;
+    while (*link) {
+        parent = *link;
+        if (point->at < POINT_ENTRY (*link)->at)
+            link = &((*link)->rb_left);
+        else
+            link = &((*link)->rb_right);
+    }
+    rb_link_node (&(point->rb), parent, link);
+    point_refresh (&(point->rb));
+    rb_insert_augmented (&(point->rb), &(s->root), &point_aug_cb);
+}
+
+static point1d_t *point_get_or_new (planner1d_state_t *s, int64_t at)
+{
+    point1d_t *point = NULL;
+    if ((point = point_search (s, at)))
+        return point;
+    point = slab_alloc (&(s->point_pool));
+    point->at = at;
+    point_link (s, point);
+    return point;
+}
+
+static void point_put (planner1d_state_t *s, point1d_t *point)
+{
+    // p0 holds a reference of its own and never drops to zero
+    if (--point->ref_count > 0)
+        return;
+    rb_erase_augmented (&(point->rb), &(s->root), &point_aug_cb);
+    slab_free (&(s->point_pool), point);
+}
+
+static int update_points (planner1d_state_t *s, span1d_t *span, int sign)
+{
+    point1d_t *start_p = NULL;
+    point1d_t *last_p = NULL;
+    if (sign > 0) {
+        start_p = point_get_or_new (s, span->start);
+        start_p->ref_count++;
+        last_p = point_get_or_new (s, span->last);
+        last_p->ref_count++;
+    } else if (!(start_p = point_search (s, span->start))
+               || !(last_p = point_search (s, span->last))) {
+        return -1;
+    }
+    start_p->delta += sign * span->planned;
+    last_p->delta -= sign * span->planned;
+    point_refresh (&(start_p->rb));
+    point_refresh (&(last_p->rb));
+    if (sign < 0) {
+        point_put (s, start_p);
+        point_put (s, last_p);
+    }
+    return 0;
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                      Window Queries: O(log n) Descents                      *
+ *                                                                             *
+ *******************************************************************************/
+
+/* Scalar versions of the delta tree descents: base is the prefix sum of
+ * everything left of the visited subtree; lo_in and hi_in tell whether the
+ * subtree lies entirely at or after lo and entirely before hi.
+ */
+
+static inline int64_t prefix_at (const point1d_t *p, int64_t base)
+{
+    return base + (p->rb.rb_left? POINT_ENTRY (p->rb.rb_left)->sum : 0)
+           + p->delta;
+}
+
+/*! Return the scheduled resources at time at and set *state_at to the time
+ *  of the point that represents that state (-1 if at precedes all points).
+ */
+static int64_t state (planner1d_t *ctx, int64_t at, int64_t *state_at)
+{
+    int64_t base = 0;
+    struct rb_node *node = ctx->s? ctx->s->root.rb_node : NULL;
+    *state_at = -1;
+    while (node) {
+        point1d_t *this_data = POINT_ENTRY (node);
+        if (at < this_data->at) {
+            node = node->rb_left;
+        } else {
+            base = prefix_at (this_data, base);
+            *state_at = this_data->at;
+            node = node->rb_right;
+        }
+    }
+    return base;
+}
+
+static int64_t window_max (struct rb_node *n, int64_t base,
+                           int64_t lo, int64_t hi, bool lo_in, bool hi_in,
+                           int64_t max)
+{
+    int64_t pre = 0;
+    point1d_t *p = NULL;
+    if (!n)
+        return max;
+    p = POINT_ENTRY (n);
+    if (lo_in && hi_in)
+        return (base + p->max > max)? base + p->max : max;
+    pre = prefix_at (p, base);
+    if (!lo_in && p->at < lo)
+        return window_max (n->rb_right, pre, lo, hi, lo_in, hi_in, max);
+    if (!hi_in && p->at >= hi)
+        return window_max (n->rb_left, base, lo, hi, lo_in, hi_in, max);
+    max = window_max (n->rb_left, base, lo, hi, lo_in, true, max);
+    if (pre > max)
+        max = pre;
+    return window_max (n->rb_right, pre, lo, hi, true, hi_in, max);
+}
+
+static point1d_t *window_first_over (struct rb_node *n, int64_t base,
+                                     int64_t lo, int64_t hi,
+                                     bool lo_in, bool hi_in, int64_t thresh)
+{
+    int64_t pre = 0;
+    point1d_t *p = NULL;
+    point1d_t *found = NULL;
+    if (!n)
+        return NULL;
+    p = POINT_ENTRY (n);
+    if (lo_in && hi_in && base + p->max <= thresh)
+        return NULL;
+    pre = prefix_at (p, base);
+    if (!lo_in && p->at < lo)
+        return window_first_over (n->rb_right, pre, lo, hi,
+                                  lo_in, hi_in, thresh);
+    if (!hi_in && p->at >= hi)
+        return window_first_over (n->rb_left, base, lo, hi,
+                                  lo_in, hi_in, thresh);
+    if ((found = window_first_over (n->rb_left, base, lo, hi,
+                                    lo_in, true, thresh)))
+        return found;
+    if (pre > thresh)
+        return p;
+    return window_first_over (n->rb_right, pre, lo, hi, true, hi_in, thresh);
+}
+
+static point1d_t *first_fit (struct rb_node *n, int64_t base,
+                             int64_t lo, bool lo_in, int64_t thresh)
+{
+    int64_t pre = 0;
+    point1d_t *p = NULL;
+    point1d_t *found = NULL;
+    if (!n)
+        return NULL;
+    p = POINT_ENTRY (n);
+    // With a single type, the subtree min is exact: prune only on a miss
+    if (lo_in && base + p->min > thresh)
+        return NULL;
+    pre = prefix_at (p, base);
+    if (!lo_in && p->at < lo)
+        return first_fit (n->rb_right, pre, lo, lo_in, thresh);
+    if ((found = first_fit (n->rb_left, base, lo, lo_in, thresh)))
+        return found;
+    if (pre <= thresh)
+        return p;
+    return first_fit (n->rb_right, pre, lo, true, thresh);
+}
+
+static int64_t avail_at (planner1d_t *ctx)
+{
+    int64_t at = ctx->on_or_after;
+    int64_t thresh = ctx->total - ctx->request;
+    point1d_t *p = NULL;
+    point1d_t *over = NULL;
+    if (!ctx->s) {
+        // an idle planner only has its base time point, which always fits
+        if (at > ctx->plan_start
+            || (ctx->plan_start + ctx->duration) > ctx->plan_end)
+            return -1;
+        ctx->on_or_after = ctx->plan_start + 1;
+        return ctx->plan_start;
+    }
+    while ((p = first_fit (ctx->s->root.rb_node, 0, at, false, thresh))) {
+        at = p->at;
+        if ((at + ctx->duration) > ctx->plan_end)
+            return -1;
+        over = window_first_over (ctx->s->root.rb_node, 0, at,
+                                  at + (int64_t)ctx->duration,
+                                  false, false, thresh);
+        if (!over) {
+            ctx->on_or_after = at + 1;
+            return at;
+        }
+        at = over->at + 1;
+    }
+    return -1;
+}
+
+static bool avail_during (planner1d_t *ctx, int64_t at, uint64_t duration,
+                          int64_t request)
+{
+    int64_t lo = -1;
+    if ((at + duration) > ctx->plan_end) {
+        errno = ERANGE;
+        return false;
+    } else if (!ctx->s) {
+        return true;
+    }
+    state (ctx, at, &lo);
+    if (lo == -1)
+        lo = at;
+    return !window_first_over (ctx->s->root.rb_node, 0, lo,
+                               at + (int64_t)duration, false, false,
+                               ctx->total - request);
+}
+
+/*! Check that the span still fits once moved to [start, last) with request.
+ *  Where the new interval overlaps the old one, the span already holds its
+ *  old request, so only the difference needs to be available there.
+ */
+static bool span_update_ok (planner1d_t *ctx, const span1d_t *span,
+                            int64_t start, int64_t last, int64_t request)
+{
+    int64_t lo = (span->start > start)? span->start : start;
+    int64_t hi = (span->last < last)? span->last : last;
+    if (lo >= hi)
+        return avail_during (ctx, start, last - start, request);
+    return (start >= lo || avail_during (ctx, start, lo - start, request))
+           && avail_during (ctx, lo, hi - lo, request - span->planned)
+           && (last <= hi || avail_during (ctx, hi, last - hi, request));
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                              Utilities                                      *
+ *                                                                             *
+ *******************************************************************************/
+
+/*! Copy the point subtree rooted at n into s with the same shape, colors
+ *  and aggregates. o is the state being copied, whose embedded p0 maps to
+ *  that of s.
+ */
+static struct rb_node *point_clone (planner1d_state_t *s,
+                                    const planner1d_state_t *o,
+                                    const struct rb_node *n,
+                                    struct rb_node *parent)
+{
+    const point1d_t *p = NULL;
+    point1d_t *c = NULL;
+    if (!n)
+        return NULL;
+    p = POINT_ENTRY (n);
+    c = (p == &(o->p0))? &(s->p0) : slab_alloc (&(s->point_pool));
+    *c = *p;
+    rb_set_parent_color (&(c->rb), parent, rb_color (n));
+    c->rb.rb_left = point_clone (s, o, n->rb_left, &(c->rb));
+    c->rb.rb_right = point_clone (s, o, n->rb_right, &(c->rb));
+    return &(c->rb);
+}
+
+static planner1d_state_t *state_new (void)
+{
+    planner1d_state_t *s = xzmalloc (sizeof (*s));
+    s->refs = 1;
+    s->root = RB_ROOT;
+    span_table_init (&(s->span_lookup), offsetof (span1d_t, span_id));
+    slab_pool_init (&(s->point_pool), sizeof (point1d_t));
+    slab_pool_init (&(s->span_pool), sizeof (span1d_t));
+    return s;
+}
+
+static planner1d_state_t *state_copy (const planner1d_state_t *o)
+{
+    size_t i = 0;
+    planner1d_state_t *s = state_new ();
+    s->root.rb_node = point_clone (s, o, o->root.rb_node, NULL);
+    span_table_reserve (&(s->span_lookup), o->span_lookup.size);
+    for (i = 0; i < o->span_lookup.capacity; ++i) {
+        span1d_t *span = NULL;
+        if (!o->span_lookup.slots[i])
+            continue;
+        span = slab_alloc (&(s->span_pool));
+        *span = *(span1d_t *)o->span_lookup.slots[i];
+        span_table_insert (&(s->span_lookup), span);
+    }
+    s->span_counter = o->span_counter;
+    return s;
+}
+
+static void state_put (planner1d_state_t *s)
+{
+    if (!s || --s->refs > 0)
+        return;
+    span_table_destroy (&(s->span_lookup));
+    slab_pool_release (&(s->point_pool));
+    slab_pool_release (&(s->span_pool));
+    free (s);
+}
+
+/*! Return the state of ctx ready to be updated: materialize it if the
+ *  planner is idle, and take a private copy first if it is shared with
+ *  clones.
+ */
+static planner1d_state_t *own_state (planner1d_t *ctx)
+{
+    planner1d_state_t *s = ctx->s;
+    if (!s) {
+        s = state_new ();
+        s->p0.at = ctx->plan_start;
+        s->p0.ref_count = 1;
+        point_link (s, &(s->p0));
+    } else if (s->refs > 1) {
+        s = state_copy (ctx->s);
+        state_put (ctx->s);
+    }
+    ctx->s = s;
+    return s;
+}
+
+/*! Binary form of a planner1d_t (see serial.h). All fields are int64_t:
+ *
+ *    magic, total, plan_start, plan_end, span_counter,
+ *    n_points, n_points x {at, ref_count, scheduled},
+ *    n_spans, n_spans x {span_id, start index, last index, planned}
+ *
+ *  Points are in time order and are referred to by their index. An idle
+ *  planner has no points.
+ */
+#define PLANNER1D_SERIAL_MAGIC 0x3144314cLL    /* "L1D1" */
+
+static int64_t time_index (const int64_t *times, size_t n, int64_t at)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (times[mid] < at)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < n && times[lo] == at)? (int64_t)lo : -1;
+}
+
+/*! Link the points, in time order, into the tree of s in O(n). */
+static void points_build (planner1d_state_t *s, point1d_t **points, size_t n)
+{
+    size_t i = 0;
+    struct rb_node *node = NULL;
+    struct rb_node **nodes = xzmalloc (n * sizeof (*nodes));
+    for (i = 0; i < n; ++i)
+        nodes[i] = &(points[i]->rb);
+    rb_build_sorted (nodes, n, &(s->root));
+    for (node = rb_first_postorder (&(s->root)); node;
+         node = rb_next_postorder (node))
+        point_compute (POINT_ENTRY (node));
+    free (nodes);
+}
+
+static void initialize (planner1d_t *ctx, int64_t base_time, uint64_t duration)
+{
+    ctx->plan_start = base_time;
+    ctx->plan_end = base_time + (int64_t)duration;
+    ctx->s = NULL;
+    ctx->avail_time_iter_set = 0;
+}
+
+static void erase (planner1d_t *ctx)
+{
+    state_put (ctx->s);
+    ctx->s = NULL;
+}
+
+/*! Number of nodes on the longest path from n down to a leaf. */
+static size_t tree_height (const struct rb_node *n)
+{
+    size_t l = 0, r = 0;
+    if (!n)
+        return 0;
+    l = tree_height (n->rb_left);
+    r = tree_height (n->rb_right);
+    return 1 + ((l > r)? l : r);
+}
+
+static span1d_t *span_lookup (planner1d_t *ctx, int64_t span_id)
+{
+    span1d_t *span = NULL;
+    if (!ctx || !ctx->s
+        || !(span = span_table_lookup (&(ctx->s->span_lookup), span_id))) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return span;
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                           PUBLIC PLANNER1D API                              *
+ *                                                                             *
+ *******************************************************************************/
+
+planner1d_t *planner1d_new (int64_t base_time, uint64_t duration,
+                            uint64_t total)
+{
+    planner1d_t *ctx = NULL;
+    if (duration < 1) {
+        errno = EINVAL;
+        return NULL;
+    } else if (total > INT64_MAX) {
+        errno = ERANGE;
+        return NULL;
+    }
+    ctx = xzmalloc (sizeof (*ctx));
+    ctx->total = (int64_t)total;
+    initialize (ctx, base_time, duration);
+    return ctx;
+}
+
+planner1d_t *planner1d_clone (planner1d_t *ctx)
+{
+    planner1d_t *clone = NULL;
+    if (!ctx) {
+        errno = EINVAL;
+        return NULL;
+    }
+    clone = xzmalloc (sizeof (*clone));
+    clone->total = ctx->total;
+    initialize (clone, ctx->plan_start, ctx->plan_end - ctx->plan_start);
+    if ((clone->s = ctx->s))
+        clone->s->refs++;
+    return clone;
+}
+
+int planner1d_serialize (planner1d_t *ctx, char **buf, size_t *size)
+{
+    size_t i = 0, n = 0;
+    int64_t sum = 0;
+    int64_t *times = NULL;
+    struct rb_node *node = NULL;
+    planner1d_state_t *s = NULL;
+    char *p = NULL;
+
+    if (!ctx || !buf || !size) {
+        errno = EINVAL;
+        return -1;
+    }
+    s = ctx->s;
+    n = (s)? s->point_pool.n_live + 1 : 0;     // p0 is not from the pool
+    *size = (7 + 3 * n) * sizeof (int64_t);
+    if (s)
+        *size += 4 * s->span_lookup.size * sizeof (int64_t);
+    *buf = p = xzmalloc (*size);
+    times = xzmalloc ((n + 1) * sizeof (*times));
+
+    serial_put (&p, PLANNER1D_SERIAL_MAGIC);
+    serial_put (&p, ctx->total);
+    serial_put (&p, ctx->plan_start);
+    serial_put (&p, ctx->plan_end);
+    serial_put (&p, (s)? s->span_counter : 0);
+    serial_put (&p, n);
+    for (node = (s)? rb_first (&(s->root)) : NULL; node; node = rb_next (node)) {
+        point1d_t *point = POINT_ENTRY (node);
+        sum += point->delta;
+        serial_put (&p, point->at);
+        serial_put (&p, point->ref_count);
+        serial_put (&p, sum);
+        times[i++] = point->at;
+    }
+    serial_put (&p, (s)? s->span_lookup.size : 0);
+    for (i = 0; s && i < s->span_lookup.capacity; ++i) {
+        span1d_t *span = s->span_lookup.slots[i];
+        if (!span)
+            continue;
+        serial_put (&p, span->span_id);
+        serial_put (&p, time_index (times, n, span->start));
+        serial_put (&p, time_index (times, n, span->last));
+        serial_put (&p, span->planned);
+    }
+    free (times);
+    return 0;
+}
+
+planner1d_t *planner1d_deserialize (const char *buf, size_t size)
+{
+    int64_t i = 0;
+    int64_t magic = 0, total = 0, start = 0, end = 0, counter = 0;
+    int64_t n = 0, n_spans = 0;
+    int64_t prev = 0;
+    const char *p = buf;
+    const char *e = buf + size;
+    point1d_t **points = NULL;
+    planner1d_state_t *s = NULL;
+    planner1d_t *ctx = NULL;
+
+    if (!buf || serial_get (&p, e, &magic) == -1
+        || magic != PLANNER1D_SERIAL_MAGIC
+        || serial_get (&p, e, &total) == -1
+        || serial_get (&p, e, &start) == -1
+        || serial_get (&p, e, &end) == -1
+        || serial_get (&p, e, &counter) == -1
+        || serial_get (&p, e, &n) == -1
+        || total < 0 || end <= start || counter < 0 || n < 0
+        || n > (e - p) / (int64_t)(3 * sizeof (int64_t))
+        || !(ctx = planner1d_new (start, end - start, total)))
+        goto error;
+
+    if (n > 0) {
+        // Points in time order: the first one is the base time point
+        s = ctx->s = state_new ();
+        points = xzmalloc (n * sizeof (*points));
+        for (i = 0; i < n; ++i) {
+            int64_t ref_count = 0, sum = 0;
+            points[i] = (i == 0)? &(s->p0) : slab_alloc (&(s->point_pool));
+            serial_get (&p, e, &(points[i]->at));
+            serial_get (&p, e, &ref_count);
+            serial_get (&p, e, &sum);
+            points[i]->ref_count = (int)ref_count;
+            points[i]->delta = sum - prev;
+            prev = sum;
+            if ((i == 0)? points[i]->at != start
+                        : points[i]->at <= points[i - 1]->at)
+                goto error;
+        }
+        points_build (s, points, n);
+        s->span_counter = counter;
+    }
+
+    if (serial_get (&p, e, &n_spans) == -1 || n_spans < 0
+        || n_spans > (e - p) / (int64_t)(4 * sizeof (int64_t))
+        || (n_spans > 0 && !s))
+        goto error;
+    for (i = 0; i < n_spans; ++i) {
+        int64_t si = 0, li = 0;
+        span1d_t *span = slab_alloc (&(s->span_pool));
+        serial_get (&p, e, &(span->span_id));
+        serial_get (&p, e, &si);
+        serial_get (&p, e, &li);
+        serial_get (&p, e, &(span->planned));
+        if (span->span_id < 1 || span->span_id > counter
+            || si < 0 || si >= li || li >= n
+            || span_table_insert (&(s->span_lookup), span) == -1)
+            goto error;
+        span->start = points[si]->at;
+        span->last = points[li]->at;
+    }
+    if (p != e)
+        goto error;
+    goto done;
+
+error:
+    planner1d_destroy (&ctx);
+    errno = EINVAL;
+done:
+    free (points);
+    return ctx;
+}
+
+int planner1d_reset (planner1d_t *ctx, int64_t base_time, uint64_t duration)
+{
+    if (!ctx || duration < 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    erase (ctx);
+    initialize (ctx, base_time, duration);
+    return 0;
+}
+
+int planner1d_advance_base_time (planner1d_t *ctx, int64_t now)
+{
+    size_t i = 0, n = 0;
+    int64_t at = 0;
+    int64_t scheduled = 0;
+    int ref_count = 1;
+    planner1d_state_t *s = NULL;
+    span1d_t **expired = NULL;
+    struct rb_node *next = NULL;
+
+    if (!ctx || now < ctx->plan_start || now >= ctx->plan_end) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (now == ctx->plan_start || !ctx->s)
+        goto done;
+
+    s = own_state (ctx);
+    expired = xzmalloc ((s->span_lookup.size + 1) * sizeof (*expired));
+    for (i = 0; i < s->span_lookup.capacity; ++i) {
+        span1d_t *span = s->span_lookup.slots[i];
+        if (!span)
+            continue;
+        if (span->last <= now) {
+            expired[n++] = span;
+        } else if (span->start <= now) {
+            span->start = now;
+            ref_count++;
+        }
+    }
+    for (i = 0; i < n; ++i) {
+        span_table_remove (&(s->span_lookup), expired[i]->span_id);
+        slab_free (&(s->span_pool), expired[i]);
+    }
+    free (expired);
+    if (s->span_lookup.size == 0) {
+        // nothing left in the schedule: go back to idle
+        erase (ctx);
+        goto done;
+    }
+
+    // p0 always comes first: drop the points up to now after it and move
+    // it to now with the whole state at now as its delta.
+    scheduled = state (ctx, now, &at);
+    while ((next = rb_next (&(s->p0.rb))) && POINT_ENTRY (next)->at <= now) {
+        rb_erase_augmented (next, &(s->root), &point_aug_cb);
+        slab_free (&(s->point_pool), POINT_ENTRY (next));
+    }
+    s->p0.at = now;
+    s->p0.delta = scheduled;
+    s->p0.ref_count = ref_count;
+    point_refresh (&(s->p0.rb));
+
+done:
+    ctx->plan_start = now;
+    ctx->avail_time_iter_set = 0;
+    return 0;
+}
+
+void planner1d_destroy (planner1d_t **ctx_p)
+{
+    if (ctx_p && *ctx_p) {
+        erase (*ctx_p);
+        free (*ctx_p);
+        *ctx_p = NULL;
+    }
+}
+
+int64_t planner1d_base_time (planner1d_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ctx->plan_start;
+}
+
+int64_t planner1d_duration (planner1d_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ctx->plan_end - ctx->plan_start;
+}
+
+int64_t planner1d_resource_total (planner1d_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ctx->total;
+}
+
+int64_t planner1d_avail_time_first (planner1d_t *ctx, int64_t on_or_after,
+                                    uint64_t duration, uint64_t request)
+{
+    if (!ctx || on_or_after < ctx->plan_start
+        || on_or_after >= ctx->plan_end || duration < 1) {
+        errno = EINVAL;
+        return -1;
+    } else if (request > (uint64_t)ctx->total) {
+        errno = ERANGE;
+        return -1;
+    }
+    ctx->on_or_after = on_or_after;
+    ctx->duration = duration;
+    ctx->request = (int64_t)request;
+    ctx->avail_time_iter_set = 1;
+    return avail_at (ctx);
+}
+
+int64_t planner1d_avail_time_next (planner1d_t *ctx)
+{
+    if (!ctx || !ctx->avail_time_iter_set) {
+        errno = EINVAL;
+        return -1;
+    }
+    return avail_at (ctx);
+}
+
+int planner1d_avail_during (planner1d_t *ctx, int64_t at, uint64_t duration,
+                            uint64_t request)
+{
+    if (!ctx || at < ctx->plan_start || duration < 1) {
+        errno = EINVAL;
+        return -1;
+    } else if (request > (uint64_t)ctx->total) {
+        errno = ERANGE;
+        return -1;
+    }
+    return avail_during (ctx, at, duration, (int64_t)request)? 0 : -1;
+}
+
+int64_t planner1d_avail_resources_at (planner1d_t *ctx, int64_t at)
+{
+    int64_t state_at = -1;
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ctx->total - state (ctx, at, &state_at);
+}
+
+int64_t planner1d_avail_resources_during (planner1d_t *ctx, int64_t at,
+                                          uint64_t duration)
+{
+    int64_t lo = -1;
+    int64_t max = 0;
+    if (!ctx || at < ctx->plan_start || at > ctx->plan_end
+        || duration < 1) {
+        errno = EINVAL;
+        return -1;
+    } else if ((at + duration) > ctx->plan_end) {
+        errno = ERANGE;
+        return -1;
+    }
+    if (!ctx->s)
+        return ctx->total;
+    max = state (ctx, at, &lo);
+    if (lo == -1)
+        lo = at;
+    max = window_max (ctx->s->root.rb_node, 0, lo, at + (int64_t)duration,
+                      false, false, max);
+    return ctx->total - max;
+}
+
+int64_t planner1d_add_span (planner1d_t *ctx, int64_t start_time,
+                            uint64_t duration, uint64_t request)
+{
+    span1d_t *span = NULL;
+    planner1d_state_t *s = NULL;
+    if (!ctx || start_time < ctx->plan_start || duration < 1
+        || (start_time + duration - 1) > ctx->plan_end) {
+        errno = EINVAL;
+        return -1;
+    } else if (request < 1 || request > (uint64_t)ctx->total) {
+        errno = ERANGE;
+        return -1;
+    } else if (!avail_during (ctx, start_time, duration, (int64_t)request)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    s = own_state (ctx);
+    span = slab_alloc (&(s->span_pool));
+    span->span_id = ++s->span_counter;
+    span->start = start_time;
+    span->last = start_time + duration;
+    span->planned = (int64_t)request;
+    span_table_insert (&(s->span_lookup), span);
+    update_points (s, span, 1);
+    ctx->avail_time_iter_set = 0;
+    return span->span_id;
+}
+
+int planner1d_update_span (planner1d_t *ctx, int64_t span_id,
+                           int64_t start_time, uint64_t duration,
+                           uint64_t request)
+{
+    span1d_t *span = NULL;
+    span1d_t moved;
+    planner1d_state_t *s = NULL;
+    int64_t last = start_time + (int64_t)duration;
+    if (!(span = span_lookup (ctx, span_id)))
+        return -1;
+    if (start_time < ctx->plan_start || duration < 1
+        || (start_time + duration - 1) > ctx->plan_end) {
+        errno = EINVAL;
+        return -1;
+    } else if (request < 1 || request > (uint64_t)ctx->total) {
+        errno = ERANGE;
+        return -1;
+    }
+    if (!span_update_ok (ctx, span, start_time, last, (int64_t)request)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    s = own_state (ctx);
+    span = span_table_lookup (&(s->span_lookup), span_id);
+    moved = *span;
+    moved.start = start_time;
+    moved.last = last;
+    moved.planned = (int64_t)request;
+    // add first so that shared end points are never freed on the way
+    update_points (s, &moved, 1);
+    update_points (s, span, -1);
+    *span = moved;
+    ctx->avail_time_iter_set = 0;
+    return 0;
+}
+
+int planner1d_rem_span (planner1d_t *ctx, int64_t span_id)
+{
+    span1d_t *span = NULL;
+    planner1d_state_t *s = NULL;
+    if (!span_lookup (ctx, span_id))
+        return -1;
+    s = own_state (ctx);
+    span = span_table_lookup (&(s->span_lookup), span_id);
+    if (update_points (s, span, -1) == -1) {
+        errno = EKEYREJECTED;
+        return -1;
+    }
+    span_table_remove (&(s->span_lookup), span_id);
+    slab_free (&(s->span_pool), span);
+    ctx->avail_time_iter_set = 0;
+    return 0;
+}
+
+/* The span table cursor lives in the planner rather than in the state, so
+ * planners sharing a state can iterate over it independently.
+ */
+int64_t planner1d_span_first (planner1d_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return -1;
+    }
+    ctx->span_iter = 0;
+    return planner1d_span_next (ctx);
+}
+
+int64_t planner1d_span_next (planner1d_t *ctx)
+{
+    span1d_t *span = NULL;
+    if (!ctx || !ctx->s) {
+        errno = EINVAL;
+        return -1;
+    }
+    ctx->s->span_lookup.iter = ctx->span_iter;
+    span = span_table_next (&(ctx->s->span_lookup));
+    ctx->span_iter = ctx->s->span_lookup.iter;
+    if (!span) {
+        errno = EINVAL;
+        return -1;
+    }
+    return span->span_id;
+}
+
+size_t planner1d_span_size (planner1d_t *ctx)
+{
+    if (!ctx) {
+        errno = EINVAL;
+        return 0;
+    }
+    return ctx->s? ctx->s->span_lookup.size : 0;
+}
+
+int planner1d_alloc_counts (planner1d_t *ctx, uint64_t *objects,
+                            uint64_t *blocks)
+{
+    if (!ctx || !objects || !blocks) {
+        errno = EINVAL;
+        return -1;
+    }
+    *objects = *blocks = 0;
+    if (ctx->s) {
+        *objects = ctx->s->point_pool.n_allocs + ctx->s->span_pool.n_allocs;
+        *blocks = ctx->s->point_pool.n_slabs + ctx->s->span_pool.n_slabs;
+    }
+    return 0;
+}
+
+int planner1d_stats (planner1d_t *ctx, planner_stats_t *stats)
+{
+    planner1d_state_t *s = NULL;
+    if (!ctx || !stats) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset (stats, 0, sizeof (*stats));
+    stats->bytes = sizeof (*ctx);
+    if ((s = ctx->s)) {
+        // p0 is embedded in the state rather than taken from the pool
+        stats->points = s->point_pool.n_live + 1;
+        stats->spans = s->span_lookup.size;
+        stats->point_tree_height = tree_height (s->root.rb_node);
+        stats->bytes += sizeof (*s) + s->span_lookup.capacity * sizeof (void *)
+                        + s->point_pool.n_bytes + s->span_pool.n_bytes;
+    }
+    return 0;
+}
+
+bool planner1d_is_active_span (planner1d_t *ctx, int64_t span_id)
+{
+    return span_lookup (ctx, span_id) != NULL;
+}
+
+int64_t planner1d_span_start_time (planner1d_t *ctx, int64_t span_id)
+{
+    span1d_t *span = span_lookup (ctx, span_id);
+    return span? span->start : -1;
+}
+
+int64_t planner1d_span_duration (planner1d_t *ctx, int64_t span_id)
+{
+    span1d_t *span = span_lookup (ctx, span_id);
+    return span? span->last - span->start : -1;
+}
+
+int64_t planner1d_span_resource_count (planner1d_t *ctx, int64_t span_id)
+{
+    span1d_t *span = span_lookup (ctx, span_id);
+    return span? span->planned : -1;
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,170 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef PLANNER1D_H
+#define PLANNER1D_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "planner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Compact planner for a single, unnamed resource type.
+ *
+ *  Same semantics as a one-dimensional planner_t, but the resource state is a
+ *  scalar and the scheduled points live in a single prefix-sum augmented
+ *  red-black tree (see PLANNER_BACKEND_DELTA), so a point is a fraction of
+ *  the size of a planner_t point. Meant for the many per-vertex planners of
+ *  a resource graph, most of which never see a span: the tree is only
+ *  materialized by the first planner1d_add_span, and until then (or after a
+ *  planner1d_reset) queries are answered from the total alone.
+ */
+typedef struct planner1d planner1d_t;
+
+/*! Construct a compact planner.
+ *
+ *  \param base_time    earliest schedulable point expressed in integer time.
+ *  \param duration     time span of this planner (i.e., all planned spans
+ *                      must end before base_time + duration).
+ *  \param total        total count of the available resources.
+ *  \return             new planner context; NULL on an error with errno set
+ *                      as follows:
+ *                          EINVAL: invalid argument.
+ *                          ERANGE: total is an out-of-range value.
+ */
+planner1d_t *planner1d_new (int64_t base_time, uint64_t duration,
+                            uint64_t total);
+
+/*! Construct a copy of the planner with the same time bound, total and
+ *  planned spans under the same span ids. The copy is O(1): the clone shares
+ *  the scheduled points and spans of ctx, and whichever of the two is
+ *  updated first takes a private copy of them (O(n), node for node). Planners
+ *  sharing a state must not be updated from different threads at once.
+ *
+ *  \return             new planner context; NULL on an error with errno set
+ *                      as follows:
+ *                          EINVAL: invalid argument.
+ */
+planner1d_t *planner1d_clone (planner1d_t *ctx);
+
+/*! Same as planner_serialize and planner_deserialize. An idle planner
+ *  serializes to a few words and loads back idle.
+ */
+int planner1d_serialize (planner1d_t *ctx, char **buf, size_t *size);
+planner1d_t *planner1d_deserialize (const char *buf, size_t size);
+
+/*! Move the base time of the planner forward to now and drop its history.
+ *  Same as planner_advance_base_time. A planner left without spans goes
+ *  back to idle.
+ */
+int planner1d_advance_base_time (planner1d_t *ctx, int64_t now);
+
+/*! Reset the planner with a new time bound. Destroy all existing planned spans.
+ *  Same as planner_reset.
+ */
+int planner1d_reset (planner1d_t *ctx, int64_t base_time, uint64_t duration);
+
+void planner1d_destroy (planner1d_t **ctx_p);
+
+/*! Getters:
+ *  \return             -1 on an error with errno set as follows:
+ *                         EINVAL: invalid argument.
+ */
+int64_t planner1d_base_time (planner1d_t *ctx);
+int64_t planner1d_duration (planner1d_t *ctx);
+int64_t planner1d_resource_total (planner1d_t *ctx);
+
+/*! Same as planner_avail_time_first with a single resource count. */
+int64_t planner1d_avail_time_first (planner1d_t *ctx, int64_t on_or_after,
+                                    uint64_t duration, uint64_t request);
+
+/*! Same as planner_avail_time_next. */
+int64_t planner1d_avail_time_next (planner1d_t *ctx);
+
+/*! Same as planner_avail_during with a single resource count. */
+int planner1d_avail_during (planner1d_t *ctx, int64_t at, uint64_t duration,
+                            uint64_t request);
+
+/*! Return how many resources are available at the given instant time;
+ *  -1 on an error with errno set to EINVAL.
+ */
+int64_t planner1d_avail_resources_at (planner1d_t *ctx, int64_t at);
+
+/*! Return how many resources are available for the duration starting from at;
+ *  -1 on an error with errno set to EINVAL or ERANGE.
+ */
+int64_t planner1d_avail_resources_during (planner1d_t *ctx, int64_t at,
+                                          uint64_t duration);
+
+/*! Same as planner_add_span with a single resource count. */
+int64_t planner1d_add_span (planner1d_t *ctx, int64_t start_time,
+                            uint64_t duration, uint64_t request);
+
+/*! Same as planner_update_span with a single resource count. Only the end
+ *  points of the old and new spans are touched.
+ */
+int planner1d_update_span (planner1d_t *ctx, int64_t span_id,
+                           int64_t start_time, uint64_t duration,
+                           uint64_t request);
+
+/*! Same as planner_rem_span. */
+int planner1d_rem_span (planner1d_t *ctx, int64_t span_id);
+
+//! Span iterators -- there is no specific iteration order
+int64_t planner1d_span_first (planner1d_t *ctx);
+int64_t planner1d_span_next (planner1d_t *ctx);
+size_t planner1d_span_size (planner1d_t *ctx);
+
+//! Same as planner_alloc_counts.
+int planner1d_alloc_counts (planner1d_t *ctx, uint64_t *objects,
+                            uint64_t *blocks);
+
+/*! Same as planner_stats, without any per-operation counters: they would
+ *  take up much of the size of a planner1d_t. The bytes of a state shared
+ *  with clones are reported by every planner sharing it.
+ */
+int planner1d_stats (planner1d_t *ctx, planner_stats_t *stats);
+
+//! Return true if the span has been inserted and active in the planner
+bool planner1d_is_active_span (planner1d_t *ctx, int64_t span_id);
+
+//! Getters for span. Return -1 on an error.
+int64_t planner1d_span_start_time (planner1d_t *ctx, int64_t span_id);
+int64_t planner1d_span_duration (planner1d_t *ctx, int64_t span_id);
+int64_t planner1d_span_resource_count (planner1d_t *ctx, int64_t span_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLANNER1D_H */
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
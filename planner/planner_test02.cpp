@@ -30,8 +30,11 @@
 #include <map>
 #include <vector>
 #include <sys/time.h>
+#include <malloc.h>
 #include "tap.h"
 #include "planner.h"
+#include "planner1d.h"
+#include "resvec.h"
 
 const int million = 1048576;
 
@@ -45,6 +48,18 @@ struct perf_t {
 
 std::map<std::string, std::vector<perf_t *> > exp_data;
 
+/* planner_test02 is linked with -Wl,--wrap=xzmalloc, which routes every
+ * xzmalloc call of the planner library through this counter.
+ */
+static uint64_t xzmalloc_calls = 0;
+
+extern "C" void *__real_xzmalloc (size_t size);
+extern "C" void *__wrap_xzmalloc (size_t size)
+{
+    xzmalloc_calls++;
+    return __real_xzmalloc (size);
+}
+
 static void to_stream (int64_t base_time, uint64_t duration, const uint64_t *cnts,
                       const char **types, size_t len, std::stringstream &ss)
 {
@@ -422,6 +437,571 @@ int test_add_perf_5d ()
     return 0;
 }
 
+int test_alloc_counts ()
+{
+    int i = 0, rc = 0;
+    int64_t at = 0, span = -1;
+    size_t len = 1;
+    bool bo = false;
+    uint64_t objects = 0, blocks = 0, calls = 0;
+    const uint64_t resource_totals[] = {10};
+    const uint64_t count = 1;
+    const char *resource_types[] = {"core"};
+    std::vector<int64_t> spans;
+    planner_t *ctx = NULL;
+
+    errno = 0;
+    xzmalloc_calls = 0;
+    ctx = planner_new (0, INT64_MAX, resource_totals, resource_types, len);
+    for (i = 0; i < million; ++i) {
+        at = (int64_t)(i/10 * 1000);
+        span = planner_add_span (ctx, at, 1000, &count, len);
+        spans.push_back (span);
+        bo = (bo || span == -1);
+    }
+    for (i = 0; i < million; i += 2) {
+        rc = planner_rem_span (ctx, spans[i]);
+        bo = (bo || rc == -1);
+    }
+    for (i = 0; i < million; i += 2) {
+        at = (int64_t)(i/10 * 1000);
+        span = planner_add_span (ctx, at, 1000, &count, len);
+        bo = (bo || span == -1);
+    }
+    calls = xzmalloc_calls;
+    rc = planner_alloc_counts (ctx, &objects, &blocks);
+    bo = (bo || rc == -1);
+
+    // Points and spans used to be one xzmalloc each, so the object count
+    // is what the unpooled planner would have called xzmalloc for them.
+    std::cout << "Experiment: Planner Allocation Counts" << std::endl;
+    std::cout << "Point and span objects allocated: " << objects << std::endl;
+    std::cout << "Heap allocations, one per object (before, estimated): "
+              << objects << std::endl;
+    std::cout << "Heap allocations, slab pooled (after, slabs): " << blocks
+              << std::endl;
+    std::cout << "xzmalloc calls of the whole workload (after, measured): "
+              << calls << std::endl;
+    ok (!bo && !errno && blocks < objects && calls < objects,
+        "slab pools cut heap allocations");
+
+    planner_destroy (&ctx);
+    return 0;
+}
+
+int test_overlap_perf ()
+{
+    int i = 0, rc = 0;
+    int64_t k = 0, span = -1;
+    size_t len = 1;
+    bool bo = false;
+    const int iters = 64;
+    const uint64_t resource_totals[] = {2};
+    const uint64_t count = 1;
+    const char *resource_types[] = {"core"};
+    struct timeval st, et;
+    planner_t *ctx = NULL;
+
+    errno = 0;
+    std::cout << "Experiment: Planner Overlapped Span Add/Remove" << std::endl;
+    for (k = 16; k <= 65536; k *= 4) {
+        double add = 0.0f, rem = 0.0f;
+        ctx = planner_new (0, INT64_MAX, resource_totals, resource_types, len);
+        for (i = 0; i < k; ++i) {
+            span = planner_add_span (ctx, i * 2, 1, &count, len);
+            bo = (bo || span == -1);
+        }
+        // One long span overlapping with all 2*k scheduled points
+        for (i = 0; i < iters; ++i) {
+            gettimeofday (&st, NULL);
+            span = planner_add_span (ctx, 0, k * 2, &count, len);
+            gettimeofday (&et, NULL);
+            add += elapse_time (st, et);
+            bo = (bo || span == -1);
+            gettimeofday (&st, NULL);
+            rc = planner_rem_span (ctx, span);
+            gettimeofday (&et, NULL);
+            rem += elapse_time (st, et);
+            bo = (bo || rc == -1);
+        }
+        std::cout << "Overlapped points: " << k * 2
+                  << " add (usec): " << add * 1000000.0f / iters
+                  << " remove (usec): " << rem * 1000000.0f / iters << std::endl;
+        planner_destroy (&ctx);
+    }
+    ok (!bo && !errno, "overlapped span add/remove works");
+    return 0;
+}
+
+int test_backend_perf ()
+{
+    int i = 0, b = 0;
+    int64_t k = 0, span = -1, avail = 0;
+    size_t len = 1;
+    bool bo = false;
+    const int iters = 64;
+    const uint64_t resource_totals[] = {4};
+    const uint64_t count = 1;
+    const char *resource_types[] = {"core"};
+    const planner_backend_t backends[] = {PLANNER_BACKEND_RBTREE,
+                                          PLANNER_BACKEND_DELTA,
+                                          PLANNER_BACKEND_BTREE};
+    const char *names[] = {"rbtree", "delta", "btree"};
+    struct timeval st, et;
+    planner_t *ctx = NULL;
+
+    errno = 0;
+    std::cout << "Experiment: Planner Backends on Deep Schedules" << std::endl;
+    for (k = 1024; k <= 65536; k *= 4) {
+        for (b = 0; b < 3; ++b) {
+            double add = 0.0f, during = 0.0f, res = 0.0f;
+            ctx = planner_new_backend (0, INT64_MAX, resource_totals,
+                                       resource_types, len, backends[b]);
+            for (i = 0; i < k; ++i) {
+                span = planner_add_span (ctx, i * 2, 1, &count, len);
+                bo = (bo || span == -1);
+            }
+            // Queries and spans over a window covering the whole schedule
+            for (i = 0; i < iters; ++i) {
+                gettimeofday (&st, NULL);
+                bo = (bo || planner_avail_during (ctx, 0, k * 2,
+                                                  &count, len) != 0);
+                gettimeofday (&et, NULL);
+                during += elapse_time (st, et);
+                gettimeofday (&st, NULL);
+                avail = planner_avail_resources_during (ctx, 0, k * 2, 0);
+                gettimeofday (&et, NULL);
+                res += elapse_time (st, et);
+                bo = (bo || avail != 3);
+                gettimeofday (&st, NULL);
+                span = planner_add_span (ctx, 0, k * 2, &count, len);
+                bo = (bo || planner_rem_span (ctx, span) != 0);
+                gettimeofday (&et, NULL);
+                add += elapse_time (st, et);
+            }
+            std::cout << names[b] << " points: " << k * 2
+                      << " avail_during (usec): " << during * 1000000.0f / iters
+                      << " avail_resources_during (usec): "
+                      << res * 1000000.0f / iters
+                      << " add+rem (usec): " << add * 1000000.0f / iters
+                      << std::endl;
+            planner_destroy (&ctx);
+        }
+    }
+    ok (!bo && !errno, "all backends answer deep schedule queries");
+    return 0;
+}
+
+int test_batch_perf ()
+{
+    int i = 0;
+    int64_t n = 0;
+    size_t len = 1;
+    bool bo = false;
+    const uint64_t resource_totals[] = {64};
+    const char *resource_types[] = {"core"};
+    struct timeval st, et;
+    planner_t *ctx = NULL;
+
+    errno = 0;
+    std::cout << "Experiment: Batch vs Single Span Add/Remove" << std::endl;
+    for (n = 4096; n <= 65536; n *= 4) {
+        double add1 = 0.0f, addn = 0.0f, rem1 = 0.0f, remn = 0.0f;
+        std::vector<int64_t> starts (n), ids (n);
+        std::vector<uint64_t> durations (n, 64), counts (n, 1);
+        // each span overlaps with the scheduled points of the next 32 ones
+        for (i = 0; i < n; ++i)
+            starts[i] = i * 2;
+
+        ctx = planner_new (0, INT64_MAX, resource_totals, resource_types, len);
+        gettimeofday (&st, NULL);
+        for (i = 0; i < n; ++i) {
+            ids[i] = planner_add_span (ctx, starts[i], durations[i],
+                                       &counts[i], len);
+            bo = (bo || ids[i] == -1);
+        }
+        gettimeofday (&et, NULL);
+        add1 = elapse_time (st, et);
+        gettimeofday (&st, NULL);
+        for (i = 0; i < n; ++i)
+            bo = (bo || planner_rem_span (ctx, ids[i]) == -1);
+        gettimeofday (&et, NULL);
+        rem1 = elapse_time (st, et);
+        planner_destroy (&ctx);
+
+        ctx = planner_new (0, INT64_MAX, resource_totals, resource_types, len);
+        gettimeofday (&st, NULL);
+        bo = (bo || planner_add_spans (ctx, n, &starts[0], &durations[0],
+                                       &counts[0], len, &ids[0], NULL) != n);
+        gettimeofday (&et, NULL);
+        addn = elapse_time (st, et);
+        gettimeofday (&st, NULL);
+        bo = (bo || planner_rem_spans (ctx, n, &ids[0], NULL) != n);
+        gettimeofday (&et, NULL);
+        remn = elapse_time (st, et);
+        planner_destroy (&ctx);
+
+        std::cout << "Spans: " << n
+                  << " add_span (msec): " << add1 * 1000.0f
+                  << " add_spans (msec): " << addn * 1000.0f
+                  << " rem_span (msec): " << rem1 * 1000.0f
+                  << " rem_spans (msec): " << remn * 1000.0f << std::endl;
+    }
+    ok (!bo && !errno, "batch span add/remove works");
+    return 0;
+}
+
+int test_clone_perf ()
+{
+    int i = 0;
+    int64_t n = 0;
+    size_t len = 1;
+    bool bo = false;
+    const uint64_t resource_totals[] = {64};
+    const char *resource_types[] = {"core"};
+    const uint64_t count = 1;
+    struct timeval st, et;
+
+    errno = 0;
+    std::cout << "Experiment: Clone vs Replay of a Planner" << std::endl;
+    for (n = 4096; n <= 65536; n *= 4) {
+        double replay = 0.0f, clone = 0.0f, clone1d = 0.0f, cow1d = 0.0f;
+        planner_t *ctx = planner_new (0, INT64_MAX, resource_totals,
+                                      resource_types, len);
+        planner_t *copy = NULL;
+        planner1d_t *ctx1d = planner1d_new (0, INT64_MAX, 64);
+        planner1d_t *copy1d = NULL;
+        gettimeofday (&st, NULL);
+        for (i = 0; i < n; ++i)
+            bo = (bo || planner_add_span (ctx, i * 2, 64, &count, len) == -1);
+        gettimeofday (&et, NULL);
+        replay = elapse_time (st, et);
+        for (i = 0; i < n; ++i)
+            bo = (bo || planner1d_add_span (ctx1d, i * 2, 64, 1) == -1);
+
+        gettimeofday (&st, NULL);
+        copy = planner_clone (ctx);
+        gettimeofday (&et, NULL);
+        clone = elapse_time (st, et);
+        gettimeofday (&st, NULL);
+        copy1d = planner1d_clone (ctx1d);
+        gettimeofday (&et, NULL);
+        clone1d = elapse_time (st, et);
+        // the first update of the clone pays for the copy
+        gettimeofday (&st, NULL);
+        bo = (bo || planner1d_rem_span (copy1d, 1) == -1);
+        gettimeofday (&et, NULL);
+        cow1d = elapse_time (st, et);
+        bo = (bo || planner_span_size (copy) != (size_t)n
+                 || planner1d_span_size (copy1d) != (size_t)n - 1);
+
+        std::cout << "Spans: " << n
+                  << " replay (msec): " << replay * 1000.0f
+                  << " planner_clone (msec): " << clone * 1000.0f
+                  << " planner1d_clone (msec): " << clone1d * 1000.0f
+                  << " first update (msec): " << cow1d * 1000.0f << std::endl;
+        planner_destroy (&ctx);
+        planner_destroy (&copy);
+        planner1d_destroy (&ctx1d);
+        planner1d_destroy (&copy1d);
+    }
+    ok (!bo && !errno, "planner clone works");
+    return 0;
+}
+
+int test_serialize_perf ()
+{
+    int i = 0;
+    int64_t n = 0;
+    size_t len = 1, size = 0;
+    bool bo = false;
+    char *buf = NULL;
+    const uint64_t resource_totals[] = {64};
+    const char *resource_types[] = {"core"};
+    const uint64_t count = 1;
+    struct timeval st, et;
+
+    errno = 0;
+    std::cout << "Experiment: Deserialize vs Replay of a Planner" << std::endl;
+    for (n = 4096; n <= 65536; n *= 4) {
+        double replay = 0.0f, save = 0.0f, load = 0.0f, load1d = 0.0f;
+        planner_t *ctx = planner_new (0, INT64_MAX, resource_totals,
+                                      resource_types, len);
+        planner_t *copy = NULL;
+        planner1d_t *ctx1d = planner1d_new (0, INT64_MAX, 64);
+        planner1d_t *copy1d = NULL;
+        gettimeofday (&st, NULL);
+        for (i = 0; i < n; ++i)
+            bo = (bo || planner_add_span (ctx, i * 2, 64, &count, len) == -1);
+        gettimeofday (&et, NULL);
+        replay = elapse_time (st, et);
+        for (i = 0; i < n; ++i)
+            bo = (bo || planner1d_add_span (ctx1d, i * 2, 64, 1) == -1);
+
+        gettimeofday (&st, NULL);
+        bo = (bo || planner_serialize (ctx, &buf, &size) == -1);
+        gettimeofday (&et, NULL);
+        save = elapse_time (st, et);
+        gettimeofday (&st, NULL);
+        copy = planner_deserialize (buf, size);
+        gettimeofday (&et, NULL);
+        load = elapse_time (st, et);
+        bo = (bo || !copy || planner_span_size (copy) != (size_t)n);
+        free (buf);
+
+        planner1d_serialize (ctx1d, &buf, &size);
+        gettimeofday (&st, NULL);
+        copy1d = planner1d_deserialize (buf, size);
+        gettimeofday (&et, NULL);
+        load1d = elapse_time (st, et);
+        bo = (bo || !copy1d || planner1d_span_size (copy1d) != (size_t)n);
+        free (buf);
+
+        std::cout << "Spans: " << n
+                  << " replay (msec): " << replay * 1000.0f
+                  << " serialize (msec): " << save * 1000.0f
+                  << " deserialize (msec): " << load * 1000.0f
+                  << " planner1d deserialize (msec): " << load1d * 1000.0f
+                  << std::endl;
+        planner_destroy (&ctx);
+        planner_destroy (&copy);
+        planner1d_destroy (&ctx1d);
+        planner1d_destroy (&copy1d);
+    }
+    ok (!bo && !errno, "planner serialization works");
+    return 0;
+}
+
+int test_advance_perf ()
+{
+    int i = 0;
+    int64_t n = 0, now = 0;
+    size_t len = 1;
+    bool bo = false;
+    const int nqueries = 10;
+    const uint64_t resource_totals[] = {64};
+    const char *resource_types[] = {"core"};
+    const uint64_t count = 1;
+    struct timeval st, et;
+
+    errno = 0;
+    std::cout << "Experiment: Earliest Time Queries after Advancing the Base"
+              << std::endl;
+    for (n = 4096; n <= 65536; n *= 4) {
+        double before = 0.0f, adv = 0.0f, after = 0.0f;
+        planner_t *ctx = planner_new (0, INT64_MAX, resource_totals,
+                                      resource_types, len);
+        for (i = 0; i < n; ++i)
+            bo = (bo || planner_add_span (ctx, i * 2, 64, &count, len) == -1);
+        // only the last 512 spans are still to come
+        now = (n - 512) * 2;
+
+        gettimeofday (&st, NULL);
+        for (i = 0; i < nqueries; ++i)
+            bo = (bo || planner_avail_time_first (ctx, now, 64, &count,
+                                                  len) != now);
+        gettimeofday (&et, NULL);
+        before = elapse_time (st, et);
+        gettimeofday (&st, NULL);
+        bo = (bo || planner_advance_base_time (ctx, now) == -1);
+        gettimeofday (&et, NULL);
+        adv = elapse_time (st, et);
+        gettimeofday (&st, NULL);
+        for (i = 0; i < nqueries; ++i)
+            bo = (bo || planner_avail_time_first (ctx, now, 64, &count,
+                                                  len) != now);
+        gettimeofday (&et, NULL);
+        after = elapse_time (st, et);
+
+        std::cout << "Spans: " << n
+                  << " queries before (msec): " << before * 1000.0f
+                  << " advance (msec): " << adv * 1000.0f
+                  << " queries after (msec): " << after * 1000.0f
+                  << " live spans: " << planner_span_size (ctx)
+                  << std::endl;
+        planner_destroy (&ctx);
+    }
+    ok (!bo && !errno, "planner_advance_base_time works");
+    return 0;
+}
+
+static size_t heap_in_use ()
+{
+    struct mallinfo2 mi = mallinfo2 ();
+    return mi.uordblks + mi.hblkhd;
+}
+
+int test_planner1d_perf ()
+{
+    int i = 0, j = 0;
+    bool bo = false;
+    const int nvertices = 100000;
+    const uint64_t size = 16, njobs = 0x40000000, count = 1;
+    const char *type = "core", *jobs = "jobs";
+    size_t before = 0, full = 0, compact = 0, full0 = 0, compact0 = 0;
+    int64_t avail = 0;
+    double q_full = 0.0f, q_compact = 0.0f, c_full = 0.0f, c_compact = 0.0f;
+    struct timeval st, et;
+    std::vector<planner_t *> plans, x_checkers;
+    std::vector<planner1d_t *> plans1d, x_checkers1d;
+
+    errno = 0;
+    std::cout << "Experiment: Per-Vertex Planners, " << nvertices
+              << " vertices" << std::endl;
+    // Mirror resource_gen: a size planner and an x_checker per vertex, each
+    // carrying a couple of spans, then a by_avail style query sweep.
+    before = heap_in_use ();
+    gettimeofday (&st, NULL);
+    for (i = 0; i < nvertices; ++i) {
+        plans.push_back (planner_new (0, INT64_MAX, &size, &type, 1));
+        x_checkers.push_back (planner_new (0, INT64_MAX, &njobs, &jobs, 1));
+    }
+    gettimeofday (&et, NULL);
+    c_full = elapse_time (st, et);
+    full0 = heap_in_use () - before;
+    for (i = 0; i < nvertices; ++i) {
+        for (j = 0; j < 2; ++j) {
+            bo = (bo || planner_add_span (plans[i], j * 100, 50,
+                                          &count, 1) == -1);
+            bo = (bo || planner_add_span (x_checkers[i], j * 100, 50,
+                                          &count, 1) == -1);
+        }
+    }
+    full = heap_in_use () - before;
+    gettimeofday (&st, NULL);
+    for (i = 0; i < nvertices; ++i)
+        avail += planner_avail_resources_during (plans[i], 0, 200, 0);
+    gettimeofday (&et, NULL);
+    q_full = elapse_time (st, et);
+    for (i = 0; i < nvertices; ++i) {
+        planner_destroy (&plans[i]);
+        planner_destroy (&x_checkers[i]);
+    }
+    // hand the freed heap back so that both runs start from fresh pages
+    malloc_trim (0);
+
+    before = heap_in_use ();
+    gettimeofday (&st, NULL);
+    for (i = 0; i < nvertices; ++i) {
+        plans1d.push_back (planner1d_new (0, INT64_MAX, size));
+        x_checkers1d.push_back (planner1d_new (0, INT64_MAX, njobs));
+    }
+    gettimeofday (&et, NULL);
+    c_compact = elapse_time (st, et);
+    compact0 = heap_in_use () - before;
+    for (i = 0; i < nvertices; ++i) {
+        for (j = 0; j < 2; ++j) {
+            bo = (bo || planner1d_add_span (plans1d[i], j * 100, 50,
+                                            count) == -1);
+            bo = (bo || planner1d_add_span (x_checkers1d[i], j * 100, 50,
+                                            count) == -1);
+        }
+    }
+    compact = heap_in_use () - before;
+    gettimeofday (&st, NULL);
+    for (i = 0; i < nvertices; ++i)
+        avail -= planner1d_avail_resources_during (plans1d[i], 0, 200);
+    gettimeofday (&et, NULL);
+    q_compact = elapse_time (st, et);
+    for (i = 0; i < nvertices; ++i) {
+        planner1d_destroy (&plans1d[i]);
+        planner1d_destroy (&x_checkers1d[i]);
+    }
+
+    std::cout << "planner_t create (msec): " << c_full * 1000.0f
+              << " heap (MB) empty: " << full0 / 1048576.0f
+              << " with spans: " << full / 1048576.0f
+              << " query sweep (msec): " << q_full * 1000.0f << std::endl;
+    std::cout << "planner1d_t create (msec): " << c_compact * 1000.0f
+              << " heap (MB) empty: " << compact0 / 1048576.0f
+              << " with spans: " << compact / 1048576.0f
+              << " query sweep (msec): " << q_compact * 1000.0f << std::endl;
+    ok (!bo && !errno && avail == 0 && compact0 < full0 && compact < full,
+        "planner1d cuts per-vertex planner memory");
+    return 0;
+}
+
+int test_resvec_perf ()
+{
+    const int nvecs = 1024;
+    const int iters = 2048;
+    const size_t width = RESVEC_PAD (8);
+    const resvec_isa_t isas[] = {RESVEC_SCALAR, RESVEC_SSE42, RESVEC_AVX2};
+    std::vector<int64_t> pool (nvecs * width, 0), total (width, 0);
+    std::vector<int64_t> sched (nvecs * width, 0), rem (nvecs * width, 0);
+    std::vector<int64_t> req (width, 0), acc (width, 0);
+    int64_t results[3][8];
+    bool bo = false;
+    struct timeval st, et;
+    resvec_isa_t best;
+
+    resvec_init ();
+    best = resvec->isa;
+    std::cout << "Experiment: Resource Vector Kernels (nsec per op)"
+              << std::endl;
+    srand (1);
+    for (size_t len = 1; len <= 8; ++len) {
+        for (int k = 0; k < nvecs; ++k)
+            for (size_t j = 0; j < len; ++j)
+                pool[k * width + j] = rand () % 64;
+        for (size_t j = 0; j < len; ++j) {
+            total[j] = 64;
+            req[j] = 4 + rand () % 8;
+        }
+        for (int a = 0; a < 3; ++a) {
+            int64_t sum = 0, bad = 0;
+            double cmp_t = 0.0f, upd_t = 0.0f, min_t = 0.0f;
+            if (resvec_select (isas[a]) == -1)
+                continue;
+            sched.assign (sched.size (), 0);
+            for (int k = 0; k < nvecs; ++k)
+                for (size_t j = 0; j < len; ++j)
+                    rem[k * width + j] = total[j];
+
+            gettimeofday (&st, NULL);
+            for (int i = 0; i < iters; ++i)
+                for (int k = 0; k < nvecs; ++k)
+                    sum += (resvec->cmp (&req[0], &pool[k * width], len) > 0);
+            gettimeofday (&et, NULL);
+            cmp_t = elapse_time (st, et);
+
+            gettimeofday (&st, NULL);
+            for (int i = 0; i < iters; ++i) {
+                for (int k = 0; k < nvecs; ++k) {
+                    bad += resvec->add (&sched[k * width], &rem[k * width],
+                                        &req[0], &total[0], len);
+                    bad += resvec->sub (&sched[k * width], &rem[k * width],
+                                        &req[0], &total[0], len);
+                }
+            }
+            gettimeofday (&et, NULL);
+            upd_t = elapse_time (st, et);
+
+            gettimeofday (&st, NULL);
+            for (int i = 0; i < iters; ++i) {
+                acc.assign (width, 0);
+                for (size_t j = 0; j < len; ++j)
+                    acc[j] = INT64_MAX;
+                for (int k = 0; k < nvecs; ++k)
+                    resvec->min (&acc[0], &pool[k * width], len);
+            }
+            gettimeofday (&et, NULL);
+            min_t = elapse_time (st, et);
+
+            results[a][len - 1] = sum + bad * 7 + acc[0] + acc[len - 1];
+            bo = (bo || results[a][len - 1] != results[0][len - 1]);
+            std::cout << "dim " << len << " " << resvec_isa_name (isas[a])
+                      << " cmp: " << cmp_t * 1e9 / (iters * nvecs)
+                      << " add+sub: " << upd_t * 1e9 / (iters * nvecs)
+                      << " min: " << min_t * 1e9 / (iters * nvecs)
+                      << std::endl;
+        }
+    }
+    resvec_select (best);
+    ok (!bo, "resource vector kernels agree across instruction sets");
+    return 0;
+}
+
 int test_add_performance ()
 {
     test_add_perf_1d ();
@@ -454,7 +1034,7 @@ int test_rem_performance ()
 
 int main (int argc, char *argv[])
 {
-    plan (10);
+    plan (11);
 
     //test_add_performance ();
 
@@ -464,6 +1044,24 @@ int main (int argc, char *argv[])
 
     test_avail_time_performance ();
 
+    test_alloc_counts ();
+
+    test_overlap_perf ();
+
+    test_backend_perf ();
+
+    test_batch_perf ();
+
+    test_clone_perf ();
+
+    test_serialize_perf ();
+
+    test_advance_perf ();
+
+    test_planner1d_perf ();
+
+    test_resvec_perf ();
+
     //test_rem_performance ();
 
     done_testing ();
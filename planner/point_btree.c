@@ -0,0 +1,688 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "xzmalloc.h"
+#include "point_btree.h"
+
+#define BTREE_ORDER 32           /* a node splits once it holds this many */
+#define BTREE_MIN   (BTREE_ORDER / 4)  /* fewest entries of a non-root node */
+#define BTREE_FILL  (BTREE_ORDER * 3 / 4)  /* entries per node on a build */
+
+/* Level 0 holds the leaves; the root is at level height - 1. */
+
+typedef struct bt_leaf bt_leaf_t;
+struct bt_leaf {
+    int n;                       /* number of points */
+    int ref_count[BTREE_ORDER];  /* number of span end points at each time */
+    bt_leaf_t *next;             /* next leaf in time order */
+    int64_t at[BTREE_ORDER];     /* times of the points, in increasing order */
+    int64_t scheduled[];         /* BTREE_ORDER rows of dimension counts */
+};
+
+typedef struct bt_inner {
+    int n;                       /* number of children */
+    int64_t at[BTREE_ORDER];     /* time of the first point of each child */
+    void *child[BTREE_ORDER];    /* nodes one level down */
+    int64_t range[];             /* per child: max row, then min row */
+} bt_inner_t;
+
+static inline int64_t *row (const point_btree_t *t, bt_leaf_t *l, int j)
+{
+    return l->scheduled + j * t->dimension;
+}
+
+static inline int64_t *max_row (const point_btree_t *t, bt_inner_t *in, int i)
+{
+    return in->range + 2 * i * t->dimension;
+}
+
+static inline int64_t *min_row (const point_btree_t *t, bt_inner_t *in, int i)
+{
+    return in->range + (2 * i + 1) * t->dimension;
+}
+
+static inline int *entries (void *node, int level)
+{
+    return level? &(((bt_inner_t *)node)->n) : &(((bt_leaf_t *)node)->n);
+}
+
+/*! Index of the last of the n times that is not after at; -1 if none is. */
+static inline int floor_index (const int64_t *times, int n, int64_t at)
+{
+    int j = 0;
+    while (j < n && times[j] <= at)
+        ++j;
+    return j - 1;
+}
+
+/*! Index of the child whose points cover at. */
+static inline int child_index (const bt_inner_t *in, int64_t at)
+{
+    int i = floor_index (in->at, in->n, at);
+    return (i < 0)? 0 : i;
+}
+
+static bool over (const int64_t *v, const int64_t *thresh, size_t len)
+{
+    int i = 0;
+    for (i = 0; i < len; ++i)
+        if (v[i] > thresh[i])
+            return true;
+    return false;
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                               Node Management                               *
+ *                                                                             *
+ *******************************************************************************/
+
+static void pools_init (point_btree_t *t, size_t dimension)
+{
+    t->dimension = dimension;
+    slab_pool_init (&(t->leaf_pool), sizeof (bt_leaf_t)
+                                     + BTREE_ORDER * dimension
+                                       * sizeof (int64_t));
+    slab_pool_init (&(t->inner_pool), sizeof (bt_inner_t)
+                                      + 2 * BTREE_ORDER * dimension
+                                        * sizeof (int64_t));
+}
+
+static inline void *node_new (point_btree_t *t, int level)
+{
+    return slab_alloc (level? &(t->inner_pool) : &(t->leaf_pool));
+}
+
+static inline void node_free (point_btree_t *t, void *node, int level)
+{
+    slab_free (level? &(t->inner_pool) : &(t->leaf_pool), node);
+}
+
+/*! Per-type max and min of the scheduled resources under node. */
+static void summarize (const point_btree_t *t, void *node, int level,
+                       int64_t *max, int64_t *min)
+{
+    int i = 0, k = 0;
+    const int64_t *hi = NULL;
+    const int64_t *lo = NULL;
+    int n = *entries (node, level);
+    for (i = 0; i < n; ++i) {
+        if (level) {
+            hi = max_row (t, node, i);
+            lo = min_row (t, node, i);
+        } else {
+            hi = lo = row (t, node, i);
+        }
+        for (k = 0; k < t->dimension; ++k) {
+            if (i == 0 || hi[k] > max[k])
+                max[k] = hi[k];
+            if (i == 0 || lo[k] < min[k])
+                min[k] = lo[k];
+        }
+    }
+}
+
+/*! Refresh the time and the range that in keeps for its i-th child, which
+ *  sits at level.
+ */
+static void refresh (const point_btree_t *t, bt_inner_t *in, int i, int level)
+{
+    void *c = in->child[i];
+    in->at[i] = level? ((bt_inner_t *)c)->at[0] : ((bt_leaf_t *)c)->at[0];
+    summarize (t, c, level, max_row (t, in, i), min_row (t, in, i));
+}
+
+/*! Move k entries from position si of src to position di of dst. Both nodes
+ *  are at level and may be the same node.
+ */
+static void move_entries (const point_btree_t *t, void *dst, int di,
+                          void *src, int si, int k, int level)
+{
+    size_t d = t->dimension;
+    if (k <= 0)
+        return;
+    if (level) {
+        bt_inner_t *o = dst, *s = src;
+        memmove (&(o->at[di]), &(s->at[si]), k * sizeof (*s->at));
+        memmove (&(o->child[di]), &(s->child[si]), k * sizeof (*s->child));
+        memmove (max_row (t, o, di), max_row (t, s, si),
+                 2 * k * d * sizeof (*s->range));
+    } else {
+        bt_leaf_t *o = dst, *s = src;
+        memmove (&(o->at[di]), &(s->at[si]), k * sizeof (*s->at));
+        memmove (&(o->ref_count[di]), &(s->ref_count[si]),
+                 k * sizeof (*s->ref_count));
+        memmove (row (t, o, di), row (t, s, si),
+                 k * d * sizeof (*s->scheduled));
+    }
+}
+
+/*! Move the upper half of node into a new right sibling and return it. */
+static void *split (point_btree_t *t, void *node, int level)
+{
+    int *n = entries (node, level);
+    int h = *n / 2;
+    void *right = node_new (t, level);
+    move_entries (t, right, 0, node, h, *n - h, level);
+    *entries (right, level) = *n - h;
+    *n = h;
+    if (!level) {
+        ((bt_leaf_t *)right)->next = ((bt_leaf_t *)node)->next;
+        ((bt_leaf_t *)node)->next = right;
+    }
+    return right;
+}
+
+/*! Children i and i + 1 of in, at level, hold too few entries between them:
+ *  merge them if they fit in one node, or even them out otherwise.
+ */
+static void rebalance (point_btree_t *t, bt_inner_t *in, int i, int level)
+{
+    void *l = in->child[i];
+    void *r = in->child[i + 1];
+    int *ln = entries (l, level);
+    int *rn = entries (r, level);
+    int total = *ln + *rn;
+    int k = 0;
+
+    if (total < BTREE_ORDER) {
+        move_entries (t, l, *ln, r, 0, *rn, level);
+        *ln = total;
+        if (!level)
+            ((bt_leaf_t *)l)->next = ((bt_leaf_t *)r)->next;
+        node_free (t, r, level);
+        move_entries (t, in, i + 1, in, i + 2, in->n - i - 2, level + 1);
+        in->n--;
+        refresh (t, in, i, level);
+        return;
+    }
+    if (*ln > total / 2) {
+        k = *ln - total / 2;
+        move_entries (t, r, k, r, 0, *rn, level);
+        move_entries (t, r, 0, l, total / 2, k, level);
+    } else {
+        k = total / 2 - *ln;
+        move_entries (t, l, *ln, r, 0, k, level);
+        move_entries (t, r, 0, r, k, *rn - k, level);
+        k = -k;
+    }
+    *ln -= k;
+    *rn += k;
+    refresh (t, in, i, level);
+    refresh (t, in, i + 1, level);
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                          Point Insertion and Removal                        *
+ *                                                                             *
+ *******************************************************************************/
+
+static bt_leaf_t *find_leaf (const point_btree_t *t, int64_t at)
+{
+    size_t level = 0;
+    void *node = t->root;
+    for (level = t->height - 1; level > 0; --level)
+        node = ((bt_inner_t *)node)->child[child_index (node, at)];
+    return node;
+}
+
+static bt_leaf_t *first_leaf (const point_btree_t *t)
+{
+    size_t level = 0;
+    void *node = t->root;
+    for (level = t->height - 1; level > 0; --level)
+        node = ((bt_inner_t *)node)->child[0];
+    return node;
+}
+
+/*! Insert a point at time at, which the subtree rooted at node does not
+ *  hold yet. The point starts out with the state of the point before it.
+ *  Return the new right sibling of node if node had to split.
+ */
+static void *insert (point_btree_t *t, void *node, int level, int64_t at)
+{
+    if (!level) {
+        bt_leaf_t *l = node;
+        int j = floor_index (l->at, l->n, at) + 1;
+        move_entries (t, l, j + 1, l, j, l->n - j, level);
+        l->at[j] = at;
+        l->ref_count[j] = 0;
+        if (j > 0)
+            memcpy (row (t, l, j), row (t, l, j - 1),
+                    t->dimension * sizeof (*l->scheduled));
+        else
+            memset (row (t, l, j), 0, t->dimension * sizeof (*l->scheduled));
+        l->n++;
+    } else {
+        bt_inner_t *in = node;
+        int i = child_index (in, at);
+        void *right = insert (t, in->child[i], level - 1, at);
+        refresh (t, in, i, level - 1);
+        if (right) {
+            move_entries (t, in, i + 2, in, i + 1, in->n - i - 1, level);
+            in->child[i + 1] = right;
+            in->n++;
+            refresh (t, in, i + 1, level - 1);
+        }
+    }
+    return (*entries (node, level) == BTREE_ORDER)? split (t, node, level)
+                                                   : NULL;
+}
+
+/*! Remove the point at time at from the subtree rooted at node. The caller
+ *  rebalances node if it is left with fewer than BTREE_MIN entries.
+ */
+static void remove_point (point_btree_t *t, void *node, int level, int64_t at)
+{
+    int i = 0;
+    void *c = NULL;
+    if (!level) {
+        bt_leaf_t *l = node;
+        int j = floor_index (l->at, l->n, at);
+        move_entries (t, l, j, l, j + 1, l->n - j - 1, level);
+        l->n--;
+        return;
+    }
+    bt_inner_t *in = node;
+    i = child_index (in, at);
+    c = in->child[i];
+    remove_point (t, c, level - 1, at);
+    if (*entries (c, level - 1) >= BTREE_MIN)
+        refresh (t, in, i, level - 1);
+    else
+        rebalance (t, in, (i + 1 < in->n)? i : i - 1, level - 1);
+}
+
+static void root_insert (point_btree_t *t, int64_t at)
+{
+    int level = t->height - 1;
+    void *right = insert (t, t->root, level, at);
+    if (right) {
+        bt_inner_t *root = node_new (t, level + 1);
+        root->n = 2;
+        root->child[0] = t->root;
+        root->child[1] = right;
+        refresh (t, root, 0, level);
+        refresh (t, root, 1, level);
+        t->root = root;
+        t->height++;
+    }
+    t->n_points++;
+}
+
+static void root_remove (point_btree_t *t, int64_t at)
+{
+    int level = t->height - 1;
+    bt_inner_t *root = t->root;
+    remove_point (t, t->root, level, at);
+    if (level && root->n == 1) {
+        t->root = root->child[0];
+        node_free (t, root, level);
+        t->height--;
+    }
+    t->n_points--;
+}
+
+/*! Return the leaf that holds the point at time at and its index in *j,
+ *  inserting the point first if need be.
+ */
+static bt_leaf_t *get_or_new (point_btree_t *t, int64_t at, int *j)
+{
+    bt_leaf_t *l = find_leaf (t, at);
+    *j = floor_index (l->at, l->n, at);
+    if (*j < 0 || l->at[*j] != at) {
+        root_insert (t, at);
+        l = find_leaf (t, at);
+        *j = floor_index (l->at, l->n, at);
+    }
+    return l;
+}
+
+static bt_leaf_t *search (point_btree_t *t, int64_t at, int *j)
+{
+    bt_leaf_t *l = find_leaf (t, at);
+    *j = floor_index (l->at, l->n, at);
+    return (*j >= 0 && l->at[*j] == at)? l : NULL;
+}
+
+static void put (point_btree_t *t, int64_t at)
+{
+    int j = 0;
+    bt_leaf_t *l = search (t, at, &j);
+    if (--l->ref_count[j] == 0)
+        root_remove (t, at);
+}
+
+/*! Add sign * counts to the scheduled resources of the points in [lo, hi)
+ *  under node and return how many there are.
+ */
+static int64_t range_add (point_btree_t *t, void *node, int level,
+                          int64_t lo, int64_t hi, const int64_t *counts,
+                          int sign)
+{
+    int i = 0, k = 0;
+    int64_t n = 0;
+    if (!level) {
+        bt_leaf_t *l = node;
+        for (i = floor_index (l->at, l->n, lo - 1) + 1;
+             i < l->n && l->at[i] < hi; ++i, ++n) {
+            int64_t *r = row (t, l, i);
+            for (k = 0; k < t->dimension; ++k)
+                r[k] += sign * counts[k];
+        }
+        return n;
+    }
+    bt_inner_t *in = node;
+    for (i = child_index (in, lo); i < in->n && in->at[i] < hi; ++i) {
+        n += range_add (t, in->child[i], level - 1, lo, hi, counts, sign);
+        refresh (t, in, i, level - 1);
+    }
+    return n;
+}
+
+void point_btree_init (point_btree_t *t, int64_t base_time, size_t dimension)
+{
+    bt_leaf_t *l = NULL;
+    pools_init (t, dimension);
+    l = node_new (t, 0);
+    l->n = 1;
+    l->at[0] = base_time;
+    l->ref_count[0] = 1;
+    t->root = l;
+    t->height = 1;
+    t->n_points = 1;
+}
+
+void point_btree_release (point_btree_t *t)
+{
+    t->root = NULL;
+    t->height = 0;
+    t->n_points = 0;
+    slab_pool_release (&(t->leaf_pool));
+    slab_pool_release (&(t->inner_pool));
+}
+
+/*! Copy the subtree rooted at node as is and chain its leaves after *prev.
+ */
+static void *clone_node (point_btree_t *t, void *node, int level,
+                         bt_leaf_t **prev)
+{
+    int i = 0;
+    void *c = node_new (t, level);
+    if (level) {
+        bt_inner_t *in = c;
+        memcpy (c, node, t->inner_pool.obj_size);
+        for (i = 0; i < in->n; ++i)
+            in->child[i] = clone_node (t, in->child[i], level - 1, prev);
+    } else {
+        memcpy (c, node, t->leaf_pool.obj_size);
+        ((bt_leaf_t *)c)->next = NULL;
+        if (*prev)
+            (*prev)->next = c;
+        *prev = c;
+    }
+    return c;
+}
+
+void point_btree_clone (point_btree_t *dst, const point_btree_t *src)
+{
+    bt_leaf_t *prev = NULL;
+    pools_init (dst, src->dimension);
+    dst->height = src->height;
+    dst->n_points = src->n_points;
+    dst->root = clone_node (dst, src->root, src->height - 1, &prev);
+}
+
+size_t point_btree_size (point_btree_t *t)
+{
+    return t->n_points;
+}
+
+void point_btree_walk (point_btree_t *t, point_btree_walk_f cb, void *arg)
+{
+    int j = 0;
+    bt_leaf_t *l = NULL;
+    for (l = first_leaf (t); l; l = l->next)
+        for (j = 0; j < l->n; ++j)
+            cb (l->at[j], l->ref_count[j], row (t, l, j), arg);
+}
+
+void point_btree_build (point_btree_t *t, size_t dimension, size_t n,
+                        const int64_t *at, const int64_t *ref_count,
+                        const int64_t *scheduled)
+{
+    size_t i = 0, k = 0, m = 0;
+    size_t count = (n + BTREE_FILL - 1) / BTREE_FILL;
+    void **nodes = xzmalloc (count * sizeof (*nodes));
+    bt_leaf_t *prev = NULL;
+
+    // Spread the points evenly over the leaves, then the leaves over the
+    // nodes of the level above and so on up to a single root.
+    pools_init (t, dimension);
+    for (k = 0; k < count; ++k) {
+        bt_leaf_t *l = node_new (t, 0);
+        for (; i < n * (k + 1) / count; ++i, ++l->n) {
+            l->at[l->n] = at[i];
+            l->ref_count[l->n] = (int)ref_count[i];
+            memcpy (row (t, l, l->n), scheduled + i * dimension,
+                    dimension * sizeof (*scheduled));
+        }
+        if (prev)
+            prev->next = l;
+        prev = l;
+        nodes[k] = l;
+    }
+    t->height = 1;
+    t->n_points = n;
+    while (count > 1) {
+        m = (count + BTREE_FILL - 1) / BTREE_FILL;
+        for (k = 0, i = 0; k < m; ++k) {
+            bt_inner_t *in = node_new (t, t->height);
+            for (; i < count * (k + 1) / m; ++i, ++in->n) {
+                in->child[in->n] = nodes[i];
+                refresh (t, in, in->n, t->height - 1);
+            }
+            nodes[k] = in;
+        }
+        count = m;
+        t->height++;
+    }
+    t->root = nodes[0];
+    free (nodes);
+}
+
+int64_t point_btree_update (point_btree_t *t, int64_t start, int64_t last,
+                            const int64_t *counts, int sign)
+{
+    int j = 0;
+    int64_t n = 0;
+    bt_leaf_t *l = NULL;
+    if (sign > 0) {
+        l = get_or_new (t, start, &j);
+        l->ref_count[j]++;
+        l = get_or_new (t, last, &j);
+        l->ref_count[j]++;
+    } else if (!search (t, start, &j) || !search (t, last, &j)) {
+        return -1;
+    }
+    n = range_add (t, t->root, t->height - 1, start, last, counts, sign);
+    if (sign < 0) {
+        put (t, start);
+        put (t, last);
+    }
+    return n;
+}
+
+void point_btree_advance (point_btree_t *t, int64_t now, int ref_count)
+{
+    int j = 0;
+    bt_leaf_t *l = NULL;
+    get_or_new (t, now, &j);
+    while ((l = first_leaf (t))->at[0] < now)
+        root_remove (t, l->at[0]);
+    l->ref_count[0] = ref_count;
+}
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                   Window Queries: Scans Pruned by Child Ranges              *
+ *                                                                             *
+ *******************************************************************************/
+
+/* An inner node's child i holds the points in [at[i], at[i + 1]). Children
+ * that lie entirely in the window are answered from their ranges; the
+ * others are scanned or pruned.
+ */
+
+static void window_max (const point_btree_t *t, void *node, int level,
+                        int64_t lo, int64_t hi, int64_t *max)
+{
+    int i = 0, k = 0;
+    if (!level) {
+        bt_leaf_t *l = node;
+        for (i = floor_index (l->at, l->n, lo - 1) + 1;
+             i < l->n && l->at[i] < hi; ++i) {
+            const int64_t *r = row (t, l, i);
+            for (k = 0; k < t->dimension; ++k)
+                if (r[k] > max[k])
+                    max[k] = r[k];
+        }
+        return;
+    }
+    bt_inner_t *in = node;
+    for (i = child_index (in, lo); i < in->n && in->at[i] < hi; ++i) {
+        if (in->at[i] >= lo && i + 1 < in->n && in->at[i + 1] <= hi) {
+            const int64_t *r = max_row (t, in, i);
+            for (k = 0; k < t->dimension; ++k)
+                if (r[k] > max[k])
+                    max[k] = r[k];
+        } else {
+            window_max (t, in->child[i], level - 1, lo, hi, max);
+        }
+    }
+}
+
+static int64_t window_first_over (const point_btree_t *t, void *node,
+                                  int level, int64_t lo, int64_t hi,
+                                  const int64_t *thresh, size_t len)
+{
+    int i = 0;
+    int64_t found = -1;
+    if (!level) {
+        bt_leaf_t *l = node;
+        for (i = floor_index (l->at, l->n, lo - 1) + 1;
+             i < l->n && l->at[i] < hi; ++i)
+            if (over (row (t, l, i), thresh, len))
+                return l->at[i];
+        return -1;
+    }
+    bt_inner_t *in = node;
+    for (i = child_index (in, lo); i < in->n && in->at[i] < hi; ++i) {
+        // no point under this child can exceed thresh: prune it
+        if (!over (max_row (t, in, i), thresh, len))
+            continue;
+        if ((found = window_first_over (t, in->child[i], level - 1, lo, hi,
+                                        thresh, len)) != -1)
+            return found;
+    }
+    return -1;
+}
+
+static int64_t first_fit (const point_btree_t *t, void *node, int level,
+                          int64_t lo, const int64_t *thresh, size_t len)
+{
+    int i = 0;
+    int64_t found = -1;
+    if (!level) {
+        bt_leaf_t *l = node;
+        for (i = floor_index (l->at, l->n, lo - 1) + 1; i < l->n; ++i)
+            if (!over (row (t, l, i), thresh, len))
+                return l->at[i];
+        return -1;
+    }
+    bt_inner_t *in = node;
+    for (i = child_index (in, lo); i < in->n; ++i) {
+        // Some type is over thresh at every point under this child: prune
+        // it. As with the delta tree, a child that survives may still hold
+        // no fit when there is more than one type.
+        if (over (min_row (t, in, i), thresh, len))
+            continue;
+        if ((found = first_fit (t, in->child[i], level - 1, lo, thresh,
+                                len)) != -1)
+            return found;
+    }
+    return -1;
+}
+
+int64_t point_btree_state (point_btree_t *t, int64_t at, int64_t *scheduled)
+{
+    bt_leaf_t *l = find_leaf (t, at);
+    int j = floor_index (l->at, l->n, at);
+    if (j < 0) {
+        memset (scheduled, 0, t->dimension * sizeof (*scheduled));
+        return -1;
+    }
+    memcpy (scheduled, row (t, l, j), t->dimension * sizeof (*scheduled));
+    return l->at[j];
+}
+
+void point_btree_max (point_btree_t *t, int64_t lo, int64_t hi, int64_t *max)
+{
+    window_max (t, t->root, t->height - 1, lo, hi, max);
+}
+
+int64_t point_btree_first_over (point_btree_t *t, int64_t lo, int64_t hi,
+                                const int64_t *thresh, size_t len)
+{
+    return window_first_over (t, t->root, t->height - 1, lo, hi, thresh, len);
+}
+
+int64_t point_btree_ceil (point_btree_t *t, int64_t at)
+{
+    bt_leaf_t *l = find_leaf (t, at);
+    int j = floor_index (l->at, l->n, at);
+    if (j >= 0 && l->at[j] == at)
+        return at;
+    if (++j < l->n)
+        return l->at[j];
+    return l->next? l->next->at[0] : -1;
+}
+
+int64_t point_btree_first_fit (point_btree_t *t, int64_t lo,
+                               const int64_t *thresh, size_t len)
+{
+    return first_fit (t, t->root, t->height - 1, lo, thresh, len);
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
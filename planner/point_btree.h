@@ -0,0 +1,122 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef POINT_BTREE_H
+#define POINT_BTREE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "slab.h"
+
+/*! Point B+ tree: time-ordered B+ tree of scheduled points. Each leaf keeps
+ *  the times of up to BTREE_ORDER points in one array and their scheduled
+ *  resources in another, row after row, and links to the next leaf. Walking
+ *  the points of a time window is therefore a linear scan over contiguous
+ *  memory rather than a pointer chase. Each inner node keeps, for each of
+ *  its children, the time of the child's first point and the per-type max
+ *  and min of the scheduled resources under it. Window queries skip whole
+ *  children from those, and only scan the leaves at the window's edges.
+ *
+ *  Adding or removing a span updates the points it overlaps in place:
+ *  O(k + log n) for k such points, a scan of the leaves that hold them.
+ */
+typedef struct point_btree {
+    void *root;                  /* root node: a leaf when height is 1 */
+    size_t height;               /* number of levels, leaves included */
+    size_t dimension;            /* number of resource types */
+    size_t n_points;             /* number of points */
+    slab_pool_t leaf_pool;       /* leaf allocator */
+    slab_pool_t inner_pool;      /* inner node allocator */
+} point_btree_t;
+
+/*! Initialize the tree with a single, never removed point at base_time. */
+void point_btree_init (point_btree_t *t, int64_t base_time, size_t dimension);
+void point_btree_release (point_btree_t *t);
+
+/*! Initialize dst as a deep copy of src in O(n). */
+void point_btree_clone (point_btree_t *dst, const point_btree_t *src);
+
+typedef void (*point_btree_walk_f) (int64_t at, int ref_count,
+                                    const int64_t *scheduled, void *arg);
+
+/*! Number of points in the tree. */
+size_t point_btree_size (point_btree_t *t);
+
+/*! Call cb on each point in time order with the scheduled resources at it. */
+void point_btree_walk (point_btree_t *t, point_btree_walk_f cb, void *arg);
+
+/*! Initialize t with n points in strictly increasing time order in O(n):
+ *  the inverse of point_btree_walk. scheduled holds dimension counts per
+ *  point.
+ */
+void point_btree_build (point_btree_t *t, size_t dimension, size_t n,
+                        const int64_t *at, const int64_t *ref_count,
+                        const int64_t *scheduled);
+
+/*! Add (sign = 1) or subtract (sign = -1) resource counts over [start, last).
+ *  The end points are created on add and freed on subtract once no span
+ *  refers to them anymore. Return the number of points updated; -1 when
+ *  subtracting and either end point does not exist.
+ */
+int64_t point_btree_update (point_btree_t *t, int64_t start, int64_t last,
+                            const int64_t *counts, int sign);
+
+/*! Fold all points before now into a single first point at now that holds
+ *  the scheduled resources at now and ref_count references. The points
+ *  after now are left as they are.
+ */
+void point_btree_advance (point_btree_t *t, int64_t now, int ref_count);
+
+/*! Copy the scheduled resources at time at into scheduled and return the time
+ *  of the point that represents that state; -1 if at precedes all points.
+ */
+int64_t point_btree_state (point_btree_t *t, int64_t at, int64_t *scheduled);
+
+/*! Fold the per-type max of the scheduled resources of all points in
+ *  [lo, hi) into max.
+ */
+void point_btree_max (point_btree_t *t, int64_t lo, int64_t hi, int64_t *max);
+
+/*! Return the time of the first point in [lo, hi) whose scheduled resources
+ *  exceed thresh for any of the first len types; -1 if there is none.
+ */
+int64_t point_btree_first_over (point_btree_t *t, int64_t lo, int64_t hi,
+                                const int64_t *thresh, size_t len);
+
+/*! Return the time of the first point at or after at; -1 if there is none. */
+int64_t point_btree_ceil (point_btree_t *t, int64_t at);
+
+/*! Return the time of the first point at or after lo whose scheduled
+ *  resources are within thresh for all of the first len types; -1 if there
+ *  is none.
+ */
+int64_t point_btree_first_fit (point_btree_t *t, int64_t lo,
+                               const int64_t *thresh, size_t len);
+
+#endif /* POINT_BTREE_H */
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -510,6 +510,40 @@ void rb_replace_node(struct rb_node *victim, struct rb_node *new,
 	*new = *victim;
 }
 
+static struct rb_node *__rb_build_sorted(struct rb_node **nodes, size_t lo,
+					 size_t hi, struct rb_node *parent,
+					 int depth, int red_depth)
+{
+	size_t mid;
+	struct rb_node *node;
+
+	if (lo >= hi)
+		return NULL;
+	mid = lo + (hi - lo) / 2;
+	node = nodes[mid];
+	rb_set_parent_color(node, parent,
+			    (depth == red_depth) ? RB_RED : RB_BLACK);
+	node->rb_left = __rb_build_sorted(nodes, lo, mid, node, depth + 1,
+					  red_depth);
+	node->rb_right = __rb_build_sorted(nodes, mid + 1, hi, node, depth + 1,
+					   red_depth);
+	return node;
+}
+
+/*
+ * Splitting at the median fills every level but the deepest one, so all of
+ * the paths have the same number of black nodes once the deepest level is
+ * colored red. Augmented callers recompute their data in postorder.
+ */
+void rb_build_sorted(struct rb_node **nodes, size_t n, struct rb_root *root)
+{
+	int full_levels = 0;
+
+	while (((size_t)2 << full_levels) - 1 <= n)
+		full_levels++;
+	root->rb_node = __rb_build_sorted(nodes, 0, n, NULL, 0, full_levels);
+}
+
 static struct rb_node *rb_left_deepest_node(const struct rb_node *node)
 {
 	for (;;) {
@@ -72,6 +72,10 @@ extern struct rb_node *rb_last(const struct rb_root *);
 extern struct rb_node *rb_first_postorder(const struct rb_root *);
 extern struct rb_node *rb_next_postorder(const struct rb_node *);
 
+/* Link n nodes given in key order into a balanced tree in O(n) */
+extern void rb_build_sorted(struct rb_node **nodes, size_t n,
+			    struct rb_root *root);
+
 /* Fast replacement of a single node without remove/rebalance/add/rebalance */
 extern void rb_replace_node(struct rb_node *victim, struct rb_node *new, 
 			    struct rb_root *root);
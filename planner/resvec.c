@@ -0,0 +1,365 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "resvec.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RESVEC_X86 1
+#include <immintrin.h>
+#endif
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                              Scalar Kernels                                 *
+ *                                                                             *
+ *******************************************************************************/
+
+static int64_t cmp_scalar (const int64_t *s1, const int64_t *s2, size_t len)
+{
+    int i = 0;
+    int64_t less = 0;
+    int64_t r = 0;
+    for (i = 0; i < len; ++i) {
+        if ( (r = s1[i] - s2[i]) > 0)
+            break;
+        less += r;
+    }
+    return (r > 0)? r : less;
+}
+
+static int add_scalar (int64_t *scheduled, int64_t *remaining,
+                       const int64_t *planned, const int64_t *total, size_t len)
+{
+    int i = 0;
+    int rc = 0;
+    for (i = 0; i < len; ++i) {
+        scheduled[i] += planned[i];
+        remaining[i] -= planned[i];
+        if (scheduled[i] > total[i] || remaining[i] < 0)
+            rc = -1;
+    }
+    return rc;
+}
+
+static int sub_scalar (int64_t *scheduled, int64_t *remaining,
+                       const int64_t *planned, const int64_t *total, size_t len)
+{
+    int i = 0;
+    int rc = 0;
+    for (i = 0; i < len; ++i) {
+        scheduled[i] -= planned[i];
+        remaining[i] += planned[i];
+        if (scheduled[i] < 0 || remaining[i] > total[i])
+            rc = -1;
+    }
+    return rc;
+}
+
+static void min_scalar (int64_t *acc, const int64_t *v, size_t len)
+{
+    int i = 0;
+    for (i = 0; i < len; ++i)
+        if (v[i] < acc[i])
+            acc[i] = v[i];
+}
+
+static const resvec_ops_t resvec_scalar = {
+    RESVEC_SCALAR, cmp_scalar, add_scalar, sub_scalar, min_scalar
+};
+
+
+#ifdef RESVEC_X86
+/*******************************************************************************
+ *                                                                             *
+ *                     SSE4.2 Kernels: 2 Lanes per Vector                      *
+ *                                                                             *
+ *******************************************************************************/
+
+/* Loads are unaligned: resource arrays live inside slab objects and planner
+ * contexts that are only guaranteed 16-byte alignment. Single-type vectors
+ * take the scalar path in all of the vector kernels.
+ */
+#define LD128(p) _mm_loadu_si128 ((const __m128i *)(p))
+#define ST128(p, v) _mm_storeu_si128 ((__m128i *)(p), (v))
+
+__attribute__ ((target ("sse4.2")))
+static int64_t cmp_sse42 (const int64_t *s1, const int64_t *s2, size_t len)
+{
+    // the scalar loop exits early and wins for one or two types
+    if (len <= 2)
+        return cmp_scalar (s1, s2, len);
+    size_t i = 0;
+    size_t n = (len + 1) & ~(size_t)1;
+    __m128i less = _mm_setzero_si128 ();
+    for (i = 0; i < n; i += 2) {
+        __m128i d = _mm_sub_epi64 (LD128 (s1 + i), LD128 (s2 + i));
+        int m = _mm_movemask_pd (_mm_castsi128_pd (
+                    _mm_cmpgt_epi64 (d, _mm_setzero_si128 ())));
+        if (m)
+            return s1[i + __builtin_ctz (m)] - s2[i + __builtin_ctz (m)];
+        less = _mm_add_epi64 (less, d);
+    }
+    return _mm_extract_epi64 (less, 0) + _mm_extract_epi64 (less, 1);
+}
+
+__attribute__ ((target ("sse4.2")))
+static int add_sse42 (int64_t *scheduled, int64_t *remaining,
+                      const int64_t *planned, const int64_t *total, size_t len)
+{
+    size_t i = 0;
+    size_t n = (len + 1) & ~(size_t)1;
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i bad = zero;
+    if (len == 1)
+        return add_scalar (scheduled, remaining, planned, total, 1);
+    for (i = 0; i < n; i += 2) {
+        __m128i p = LD128 (planned + i);
+        __m128i s = _mm_add_epi64 (LD128 (scheduled + i), p);
+        __m128i r = _mm_sub_epi64 (LD128 (remaining + i), p);
+        ST128 (scheduled + i, s);
+        ST128 (remaining + i, r);
+        bad = _mm_or_si128 (bad, _mm_cmpgt_epi64 (s, LD128 (total + i)));
+        bad = _mm_or_si128 (bad, _mm_cmpgt_epi64 (zero, r));
+    }
+    return _mm_testz_si128 (bad, bad)? 0 : -1;
+}
+
+__attribute__ ((target ("sse4.2")))
+static int sub_sse42 (int64_t *scheduled, int64_t *remaining,
+                      const int64_t *planned, const int64_t *total, size_t len)
+{
+    size_t i = 0;
+    size_t n = (len + 1) & ~(size_t)1;
+    __m128i zero = _mm_setzero_si128 ();
+    __m128i bad = zero;
+    if (len == 1)
+        return sub_scalar (scheduled, remaining, planned, total, 1);
+    for (i = 0; i < n; i += 2) {
+        __m128i p = LD128 (planned + i);
+        __m128i s = _mm_sub_epi64 (LD128 (scheduled + i), p);
+        __m128i r = _mm_add_epi64 (LD128 (remaining + i), p);
+        ST128 (scheduled + i, s);
+        ST128 (remaining + i, r);
+        bad = _mm_or_si128 (bad, _mm_cmpgt_epi64 (zero, s));
+        bad = _mm_or_si128 (bad, _mm_cmpgt_epi64 (r, LD128 (total + i)));
+    }
+    return _mm_testz_si128 (bad, bad)? 0 : -1;
+}
+
+__attribute__ ((target ("sse4.2")))
+static void min_sse42 (int64_t *acc, const int64_t *v, size_t len)
+{
+    size_t i = 0;
+    size_t n = (len + 1) & ~(size_t)1;
+    if (len == 1) {
+        min_scalar (acc, v, len);
+        return;
+    }
+    for (i = 0; i < n; i += 2) {
+        __m128i a = LD128 (acc + i);
+        __m128i b = LD128 (v + i);
+        ST128 (acc + i, _mm_blendv_epi8 (a, b, _mm_cmpgt_epi64 (a, b)));
+    }
+}
+
+static const resvec_ops_t resvec_sse42 = {
+    RESVEC_SSE42, cmp_sse42, add_sse42, sub_sse42, min_sse42
+};
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                      AVX2 Kernels: 4 Lanes per Vector                       *
+ *                                                                             *
+ *******************************************************************************/
+
+#define LD256(p) _mm256_loadu_si256 ((const __m256i *)(p))
+#define ST256(p, v) _mm256_storeu_si256 ((__m256i *)(p), (v))
+
+__attribute__ ((target ("avx2")))
+static int64_t cmp_avx2 (const int64_t *s1, const int64_t *s2, size_t len)
+{
+    // the scalar loop exits early and wins for one or two types
+    if (len <= 2)
+        return cmp_scalar (s1, s2, len);
+    size_t i = 0;
+    size_t n = RESVEC_PAD (len);
+    __m256i less = _mm256_setzero_si256 ();
+    __m128i sum;
+    for (i = 0; i < n; i += 4) {
+        __m256i d = _mm256_sub_epi64 (LD256 (s1 + i), LD256 (s2 + i));
+        int m = _mm256_movemask_pd (_mm256_castsi256_pd (
+                    _mm256_cmpgt_epi64 (d, _mm256_setzero_si256 ())));
+        if (m)
+            return s1[i + __builtin_ctz (m)] - s2[i + __builtin_ctz (m)];
+        less = _mm256_add_epi64 (less, d);
+    }
+    sum = _mm_add_epi64 (_mm256_castsi256_si128 (less),
+                         _mm256_extracti128_si256 (less, 1));
+    return _mm_extract_epi64 (sum, 0) + _mm_extract_epi64 (sum, 1);
+}
+
+__attribute__ ((target ("avx2")))
+static int add_avx2 (int64_t *scheduled, int64_t *remaining,
+                     const int64_t *planned, const int64_t *total, size_t len)
+{
+    size_t i = 0;
+    size_t n = RESVEC_PAD (len);
+    __m256i zero = _mm256_setzero_si256 ();
+    __m256i bad = zero;
+    if (len == 1)
+        return add_scalar (scheduled, remaining, planned, total, 1);
+    for (i = 0; i < n; i += 4) {
+        __m256i p = LD256 (planned + i);
+        __m256i s = _mm256_add_epi64 (LD256 (scheduled + i), p);
+        __m256i r = _mm256_sub_epi64 (LD256 (remaining + i), p);
+        ST256 (scheduled + i, s);
+        ST256 (remaining + i, r);
+        bad = _mm256_or_si256 (bad, _mm256_cmpgt_epi64 (s, LD256 (total + i)));
+        bad = _mm256_or_si256 (bad, _mm256_cmpgt_epi64 (zero, r));
+    }
+    return _mm256_testz_si256 (bad, bad)? 0 : -1;
+}
+
+__attribute__ ((target ("avx2")))
+static int sub_avx2 (int64_t *scheduled, int64_t *remaining,
+                     const int64_t *planned, const int64_t *total, size_t len)
+{
+    size_t i = 0;
+    size_t n = RESVEC_PAD (len);
+    __m256i zero = _mm256_setzero_si256 ();
+    __m256i bad = zero;
+    if (len == 1)
+        return sub_scalar (scheduled, remaining, planned, total, 1);
+    for (i = 0; i < n; i += 4) {
+        __m256i p = LD256 (planned + i);
+        __m256i s = _mm256_sub_epi64 (LD256 (scheduled + i), p);
+        __m256i r = _mm256_add_epi64 (LD256 (remaining + i), p);
+        ST256 (scheduled + i, s);
+        ST256 (remaining + i, r);
+        bad = _mm256_or_si256 (bad, _mm256_cmpgt_epi64 (zero, s));
+        bad = _mm256_or_si256 (bad, _mm256_cmpgt_epi64 (r, LD256 (total + i)));
+    }
+    return _mm256_testz_si256 (bad, bad)? 0 : -1;
+}
+
+__attribute__ ((target ("avx2")))
+static void min_avx2 (int64_t *acc, const int64_t *v, size_t len)
+{
+    size_t i = 0;
+    size_t n = RESVEC_PAD (len);
+    if (len == 1) {
+        min_scalar (acc, v, len);
+        return;
+    }
+    for (i = 0; i < n; i += 4) {
+        __m256i a = LD256 (acc + i);
+        __m256i b = LD256 (v + i);
+        ST256 (acc + i, _mm256_blendv_epi8 (a, b, _mm256_cmpgt_epi64 (a, b)));
+    }
+}
+
+static const resvec_ops_t resvec_avx2 = {
+    RESVEC_AVX2, cmp_avx2, add_avx2, sub_avx2, min_avx2
+};
+#endif /* RESVEC_X86 */
+
+
+/*******************************************************************************
+ *                                                                             *
+ *                           Runtime Kernel Dispatch                           *
+ *                                                                             *
+ *******************************************************************************/
+
+const resvec_ops_t *resvec = &resvec_scalar;
+
+static bool isa_supported (resvec_isa_t isa)
+{
+#ifdef RESVEC_X86
+    __builtin_cpu_init ();
+    switch (isa) {
+    case RESVEC_AVX2:
+        return __builtin_cpu_supports ("avx2");
+    case RESVEC_SSE42:
+        return __builtin_cpu_supports ("sse4.2");
+    default:
+        break;
+    }
+#endif
+    return isa == RESVEC_SCALAR;
+}
+
+int resvec_select (resvec_isa_t isa)
+{
+    if (!isa_supported (isa))
+        return -1;
+    switch (isa) {
+#ifdef RESVEC_X86
+    case RESVEC_AVX2:
+        resvec = &resvec_avx2;
+        break;
+    case RESVEC_SSE42:
+        resvec = &resvec_sse42;
+        break;
+#endif
+    default:
+        resvec = &resvec_scalar;
+        break;
+    }
+    return 0;
+}
+
+static pthread_once_t resvec_once = PTHREAD_ONCE_INIT;
+
+static void resvec_select_best (void)
+{
+    if (resvec_select (RESVEC_AVX2) == -1 && resvec_select (RESVEC_SSE42) == -1)
+        resvec_select (RESVEC_SCALAR);
+}
+
+void resvec_init (void)
+{
+    // Threads creating their first planners at once select only once
+    pthread_once (&resvec_once, resvec_select_best);
+}
+
+const char *resvec_isa_name (resvec_isa_t isa)
+{
+    switch (isa) {
+    case RESVEC_AVX2:
+        return "avx2";
+    case RESVEC_SSE42:
+        return "sse4.2";
+    default:
+        return "scalar";
+    }
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,92 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef RESVEC_H
+#define RESVEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Resource vector kernels: compare, update-with-range-check and min-reduce
+ *  int64_t resource arrays. Arrays passed to these kernels must be padded to
+ *  RESVEC_PAD (len) elements and the padding must be zero, which all kernels
+ *  treat as a no-op, so the vector code never needs a tail loop. The best
+ *  kernel set the CPU supports is chosen at runtime by resvec_init.
+ */
+#define RESVEC_LANES 4
+#define RESVEC_PAD(n) \
+    (((n) + RESVEC_LANES - 1) & ~((size_t)RESVEC_LANES - 1))
+
+typedef enum {
+    RESVEC_SCALAR = 0,
+    RESVEC_SSE42 = 1,
+    RESVEC_AVX2 = 2
+} resvec_isa_t;
+
+typedef struct resvec_ops {
+    resvec_isa_t isa;
+
+    /*! Return the first positive s1[i] - s2[i] if there is one (s1 does not
+     *  fit into s2); otherwise the sum of all s1[i] - s2[i] (<= 0).
+     */
+    int64_t (*cmp) (const int64_t *s1, const int64_t *s2, size_t len);
+
+    /*! Move planned from remaining to scheduled (add) or back (sub). Return
+     *  -1 if any element of scheduled or remaining leaves [0, total].
+     */
+    int (*add) (int64_t *scheduled, int64_t *remaining, const int64_t *planned,
+                const int64_t *total, size_t len);
+    int (*sub) (int64_t *scheduled, int64_t *remaining, const int64_t *planned,
+                const int64_t *total, size_t len);
+
+    //! acc[i] = min (acc[i], v[i])
+    void (*min) (int64_t *acc, const int64_t *v, size_t len);
+} resvec_ops_t;
+
+//! Currently selected kernels; scalar until resvec_init is called
+extern const resvec_ops_t *resvec;
+
+//! Select the best kernels supported by this CPU; idempotent and thread-safe
+void resvec_init (void);
+
+/*! Select a specific kernel set. Return -1 if the CPU does not support it.
+ *  Not synchronized: only call it while no other thread uses a planner.
+ */
+int resvec_select (resvec_isa_t isa);
+
+const char *resvec_isa_name (resvec_isa_t isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RESVEC_H */
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,82 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*! Cursor helpers for the binary form of planners (see planner_serialize).
+ *  Every field is an int64_t in host byte order and a string is its length
+ *  followed by its bytes. Writers are handed a buffer of the exact size;
+ *  readers check every field against the end of the buffer and return -1
+ *  on a short read.
+ */
+
+static inline void serial_put (char **p, int64_t v)
+{
+    memcpy (*p, &v, sizeof (v));
+    *p += sizeof (v);
+}
+
+static inline void serial_put_str (char **p, const char *s)
+{
+    size_t len = strlen (s);
+    serial_put (p, (int64_t)len);
+    memcpy (*p, s, len);
+    *p += len;
+}
+
+static inline size_t serial_str_size (const char *s)
+{
+    return sizeof (int64_t) + strlen (s);
+}
+
+static inline int serial_get (const char **p, const char *end, int64_t *v)
+{
+    if ((size_t)(end - *p) < sizeof (*v))
+        return -1;
+    memcpy (v, *p, sizeof (*v));
+    *p += sizeof (*v);
+    return 0;
+}
+
+/*! Point *s at a string of *len bytes within the buffer (not terminated). */
+static inline int serial_get_str (const char **p, const char *end,
+                                  const char **s, int64_t *len)
+{
+    if (serial_get (p, end, len) == -1 || *len < 0 || *len > end - *p)
+        return -1;
+    *s = *p;
+    *p += *len;
+    return 0;
+}
+
+#endif /* SERIAL_H */
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,116 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xzmalloc.h"
+#include "slab.h"
+
+#define SLAB_ALIGN       16
+#define SLAB_MIN_OBJS    4
+#define SLAB_MAX_OBJS    1024
+
+struct slab {
+    slab_t *next;                /* next slab in the pool */
+    size_t count;                /* number of objects in this slab */
+};
+
+/* Offset of the first object; keeps objects SLAB_ALIGN-aligned */
+#define SLAB_HDR_SIZE \
+    ((sizeof (slab_t) + SLAB_ALIGN - 1) & ~((size_t)SLAB_ALIGN - 1))
+
+void slab_pool_init (slab_pool_t *pool, size_t obj_size)
+{
+    memset (pool, 0, sizeof (*pool));
+    if (obj_size < sizeof (void *))
+        obj_size = sizeof (void *);
+    pool->obj_size = (obj_size + SLAB_ALIGN - 1) & ~((size_t)SLAB_ALIGN - 1);
+    // Start small: most planners only ever hold a handful of objects
+    pool->next_count = SLAB_MIN_OBJS;
+}
+
+static void slab_grow (slab_pool_t *pool)
+{
+    size_t count = pool->next_count;
+    slab_t *slab = xzmalloc (SLAB_HDR_SIZE + count * pool->obj_size);
+    slab->count = count;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    pool->cursor = (char *)slab + SLAB_HDR_SIZE;
+    pool->end = pool->cursor + count * pool->obj_size;
+    pool->n_slabs++;
+    pool->n_bytes += SLAB_HDR_SIZE + count * pool->obj_size;
+    if (pool->next_count < SLAB_MAX_OBJS)
+        pool->next_count <<= 1;
+}
+
+void *slab_alloc (slab_pool_t *pool)
+{
+    void *obj = NULL;
+    if (pool->free_list) {
+        obj = pool->free_list;
+        pool->free_list = *(void **)obj;
+    } else {
+        if (pool->cursor == pool->end)
+            slab_grow (pool);
+        obj = pool->cursor;
+        pool->cursor += pool->obj_size;
+    }
+    memset (obj, 0, pool->obj_size);
+    pool->n_allocs++;
+    pool->n_live++;
+    return obj;
+}
+
+void slab_free (slab_pool_t *pool, void *obj)
+{
+    if (!obj)
+        return;
+    *(void **)obj = pool->free_list;
+    pool->free_list = obj;
+    pool->n_live--;
+}
+
+void slab_pool_release (slab_pool_t *pool)
+{
+    slab_t *slab = pool->slabs;
+    while (slab) {
+        slab_t *next = slab->next;
+        free (slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->free_list = NULL;
+    pool->cursor = pool->end = NULL;
+    pool->n_allocs = 0;
+    pool->n_slabs = 0;
+    pool->n_live = 0;
+    pool->n_bytes = 0;
+    pool->next_count = SLAB_MIN_OBJS;
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
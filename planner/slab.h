@@ -0,0 +1,59 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! Fixed-size object pool. Objects are carved out of progressively larger
+ *  slabs and recycled through a free list; individual objects are never
+ *  returned to the heap. slab_pool_release frees all of the slabs at once.
+ */
+typedef struct slab slab_t;
+
+typedef struct slab_pool {
+    size_t obj_size;             /* aligned size of each object */
+    size_t next_count;           /* number of objects in the next slab */
+    slab_t *slabs;               /* singly linked list of slabs */
+    void *free_list;             /* recycled objects */
+    char *cursor;                /* next never-used object in current slab */
+    char *end;                   /* end of the current slab */
+    uint64_t n_allocs;           /* objects handed out so far */
+    uint64_t n_slabs;            /* slabs allocated from the heap so far */
+    uint64_t n_live;             /* objects currently in use */
+    uint64_t n_bytes;            /* heap bytes held in slabs */
+} slab_pool_t;
+
+void slab_pool_init (slab_pool_t *pool, size_t obj_size);
+void *slab_alloc (slab_pool_t *pool);
+void slab_free (slab_pool_t *pool, void *obj);
+void slab_pool_release (slab_pool_t *pool);
+
+#endif /* SLAB_H */
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
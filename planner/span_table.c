@@ -0,0 +1,168 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xzmalloc.h"
+#include "span_table.h"
+
+static inline int64_t span_table_key (const span_table_t *table,
+                                      const void *obj)
+{
+    return *(const int64_t *)((const char *)obj + table->key_offset);
+}
+
+static inline size_t span_table_hash (int64_t span_id, size_t capacity)
+{
+    // Fibonacci hashing spreads the sequentially assigned span ids
+    uint64_t h = (uint64_t)span_id * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> 32) & (capacity - 1);
+}
+
+static void span_table_place (span_table_t *table, void **slots,
+                              size_t capacity, void *obj)
+{
+    size_t i = span_table_hash (span_table_key (table, obj), capacity);
+    while (slots[i])
+        i = (i + 1) & (capacity - 1);
+    slots[i] = obj;
+}
+
+static void span_table_resize (span_table_t *table, size_t capacity)
+{
+    size_t i = 0;
+    void **slots = xzmalloc (capacity * sizeof (*slots));
+    for (i = 0; i < table->capacity; ++i) {
+        if (table->slots[i])
+            span_table_place (table, slots, capacity, table->slots[i]);
+    }
+    free (table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+}
+
+void span_table_init (span_table_t *table, size_t key_offset)
+{
+    memset (table, 0, sizeof (*table));
+    table->key_offset = key_offset;
+}
+
+void *span_table_lookup (span_table_t *table, int64_t span_id)
+{
+    size_t i = 0;
+    size_t mask = table->capacity - 1;
+    if (table->capacity == 0)
+        return NULL;
+    for (i = span_table_hash (span_id, table->capacity);
+         table->slots[i]; i = (i + 1) & mask) {
+        if (span_table_key (table, table->slots[i]) == span_id)
+            return table->slots[i];
+    }
+    return NULL;
+}
+
+static void span_table_grow (span_table_t *table)
+{
+    span_table_resize (table, (table->capacity)? table->capacity << 1 : 8);
+}
+
+void span_table_reserve (span_table_t *table, size_t n)
+{
+    size_t capacity = (table->capacity)? table->capacity : 8;
+    while (n * 2 > capacity)
+        capacity <<= 1;
+    if (capacity > table->capacity)
+        span_table_resize (table, capacity);
+}
+
+int span_table_insert (span_table_t *table, void *obj)
+{
+    if (span_table_lookup (table, span_table_key (table, obj)))
+        return -1;
+    // keep the load factor at or below 1/2 so that probe chains stay short
+    if ((table->size + 1) * 2 > table->capacity)
+        span_table_grow (table);
+    span_table_place (table, table->slots, table->capacity, obj);
+    table->size++;
+    return 0;
+}
+
+void *span_table_remove (span_table_t *table, int64_t span_id)
+{
+    size_t i = 0, j = 0, k = 0;
+    void *obj = NULL;
+    size_t mask = table->capacity - 1;
+    if (table->capacity == 0)
+        return NULL;
+    for (i = span_table_hash (span_id, table->capacity);
+         table->slots[i]; i = (i + 1) & mask) {
+        if (span_table_key (table, table->slots[i]) == span_id)
+            break;
+    }
+    if ( !(obj = table->slots[i]))
+        return NULL;
+
+    // Backward-shift deletion: move each displaced entry of the probe chain
+    // into the hole unless its home slot lies cyclically within (i, j].
+    table->slots[i] = NULL;
+    for (j = (i + 1) & mask; table->slots[j]; j = (j + 1) & mask) {
+        k = span_table_hash (span_table_key (table, table->slots[j]),
+                             table->capacity);
+        if ((i <= j)? ((i < k) && (k <= j)) : ((i < k) || (k <= j)))
+            continue;
+        table->slots[i] = table->slots[j];
+        table->slots[j] = NULL;
+        i = j;
+    }
+    table->size--;
+    return obj;
+}
+
+void *span_table_next (span_table_t *table)
+{
+    while (table->iter < table->capacity) {
+        void *obj = table->slots[table->iter++];
+        if (obj)
+            return obj;
+    }
+    return NULL;
+}
+
+void *span_table_first (span_table_t *table)
+{
+    table->iter = 0;
+    return span_table_next (table);
+}
+
+void span_table_destroy (span_table_t *table)
+{
+    size_t key_offset = table->key_offset;
+    free (table->slots);
+    span_table_init (table, key_offset);
+}
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
@@ -0,0 +1,62 @@
+/*****************************************************************************\
+ *  Copyright (c) 2014 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef SPAN_TABLE_H
+#define SPAN_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! Span lookup table: open-addressing hash table keyed by an integer span id
+ *  embedded in each stored object at key_offset (e.g., offsetof (span_t,
+ *  span_id)). The table only holds pointers; the objects are owned by the
+ *  caller.
+ */
+typedef struct span_table {
+    void **slots;                /* linear-probing slots; NULL when empty */
+    size_t capacity;             /* slot count: zero or a power of two */
+    size_t size;                 /* number of objects in the table */
+    size_t iter;                 /* slot cursor for iteration */
+    size_t key_offset;           /* offset of the int64_t span id */
+} span_table_t;
+
+void span_table_init (span_table_t *table, size_t key_offset);
+void *span_table_lookup (span_table_t *table, int64_t span_id);
+int span_table_insert (span_table_t *table, void *obj);
+/*! Grow the table to hold n objects without further growth. Filling a
+ *  table in the slot order of another one is only fast if both have
+ *  the same capacity: a smaller table would pile the objects up into
+ *  long probe chains.
+ */
+void span_table_reserve (span_table_t *table, size_t n);
+void *span_table_remove (span_table_t *table, int64_t span_id);
+void *span_table_first (span_table_t *table);
+void *span_table_next (span_table_t *table);
+void span_table_destroy (span_table_t *table);
+
+#endif /* SPAN_TABLE_H */
+
+/*
+ * vi: ts=4 sw=4 expandtab
+ */
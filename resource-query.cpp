@@ -46,7 +46,7 @@ using namespace std;
 using namespace boost;
 using namespace Flux::resource_model;
 
-#define OPTIONS "G:S:P:g:o:t:e:h"
+#define OPTIONS "G:S:P:g:o:t:j:d:z:e:h"
 static const struct option longopts[] = {
     {"grug",             required_argument,  0, 'G'},
     {"match-subsystems", required_argument,  0, 'S'},
@@ -54,6 +54,9 @@ static const struct option longopts[] = {
     {"graph-format",     required_argument,  0, 'g'},
     {"graph-output",     required_argument,  0, 'o'},
     {"test-output",      required_argument,  0, 't'},
+    {"threads",          required_argument,  0, 'j'},
+    {"parallel-depth",   required_argument,  0, 'd'},
+    {"parallel-size",    required_argument,  0, 'z'},
     {"elapse",           required_argument,  0, 'v'},
     {"help",             no_argument,        0, 'h'},
     { 0, 0, 0, 0 },
@@ -144,6 +147,21 @@ static void usage (int code)
 "    -t, --test-output=<filename>\n"
 "            Set the output filename where allocated or reserved resource\n"
 "            information is stored into.\n"
+"\n"
+"    -j, --threads=<n>\n"
+"            Walk the subtrees of the dominant subsystem in parallel\n"
+"            on n threads. The selected resources are the same as\n"
+"            with the serial walk. The dominant subsystem must be a\n"
+"            tree; otherwise, the serial walk is used\n"
+"            (default=0: serial walk).\n"
+"\n"
+"    -d, --parallel-depth=<depth>\n"
+"            Only walk the children of the vertices less than depth\n"
+"            below the root in parallel (default=2).\n"
+"\n"
+"    -z, --parallel-size=<size>\n"
+"            Only walk the children of the vertices whose subtrees have\n"
+"            at least size vertices in parallel (default=0: any size).\n"
 "\n";
     exit (code);
 }
@@ -170,6 +188,9 @@ static void set_default_params (test_params_t &params)
     params.o_fext = "dot";
     params.o_format = emit_format_t::GRAPHVIZ_DOT;
     params.elapse_time = false;
+    params.n_threads = 0;
+    params.par_depth = 2;
+    params.par_min_size = 0;
 }
 
 static int string_to_graph_format (string st, emit_format_t &format)
@@ -279,6 +300,9 @@ static int set_subsystems_use (resource_context_t *ctx, string n)
     } else {
         rc = -1;
     }
+    // Mark the vertices and edges the matcher selects once, up front
+    if (rc == 0 && (ctx->view = ctx->db.add_view (matcher.subsystemsS ())) < 0)
+        rc = -1;
     return rc;
 }
 
@@ -403,12 +427,12 @@ static void control_loop (resource_context_t *ctx)
     }
 }
 
-static void subtree_plan_types (set<string> &aut)
+static void subtree_plan_types (dfu_match_cb_t *matcher, const subsystem_t &s)
 {
     // scheduler-driven aggregate-updates optimization is configured with
     // the following resource types.
     // TODO: we can only support one resource type for this scheme for now
-    aut.insert ("core");
+    matcher->add_sdau_resource_type (s, "core");
 }
 
 int main (int argc, char *argv[])
@@ -447,6 +471,17 @@ int main (int argc, char *argv[])
             case 't': /* --test-output */
                 ctx->params.r_fname = optarg;
                 break;
+            case 'j': /* --threads */
+                ctx->params.n_threads = (unsigned)std::strtoul (optarg,
+                                                                NULL, 10);
+                break;
+            case 'd': /* --parallel-depth */
+                ctx->params.par_depth = (unsigned)std::strtoul (optarg,
+                                                                NULL, 10);
+                break;
+            case 'z': /* --parallel-size */
+                ctx->params.par_min_size = std::strtoull (optarg, NULL, 10);
+                break;
             case 'e': /* --elapse-time */
                 ctx->params.elapse_time = true;
                 break;
@@ -483,15 +518,14 @@ int main (int argc, char *argv[])
     }
     vtx_infra_map_t vmap = get (&resource_pool_t::idata, g);
     edg_infra_map_t emap = get (&resource_relation_t::idata, g);
-    const multi_subsystemsS &filter = ctx->matcher->subsystemsS ();
 
-    subsystem_selector_t<vtx_t, f_vtx_infra_map_t> vtxsel (vmap, filter);
-    subsystem_selector_t<edg_t, f_edg_infra_map_t> edgsel (emap, filter);
+    subsystem_selector_t<vtx_t, f_vtx_infra_map_t> vtxsel (vmap, ctx->view);
+    subsystem_selector_t<edg_t, f_edg_infra_map_t> edgsel (emap, ctx->view);
     f_resource_graph_t *fg = new f_resource_graph_t (g, edgsel, vtxsel);
     ctx->resource_graph_views[ctx->params.matcher_name] = fg;
     ctx->jobid_counter = 1;
     const string &dom = ctx->matcher->dom_subsystem ();
-    subtree_plan_types (ctx->matcher->sdau_resource_types[dom]);
+    subtree_plan_types (ctx->matcher, dom);
 
     // please refactor
     if (ctx->params.r_fname != "") {
@@ -501,6 +535,12 @@ int main (int argc, char *argv[])
     }
 
     ctx->traverser.initialize (fg, &(ctx->db.roots), ctx->matcher);
+    if (ctx->traverser.set_parallel (ctx->params.n_threads,
+                                     ctx->params.par_depth,
+                                     ctx->params.par_min_size) != 0) {
+        cerr << "WARNING: can't walk in parallel: " << strerror (errno);
+        cerr << "; walking serially" << endl;
+    }
 
     // Command line begins
     control_loop (ctx);
@@ -28,7 +28,11 @@
 #include <cstring>
 #include <map>
 #include <set>
+#include <vector>
+#include <algorithm>
+#include "intern.hpp"
 #include "planner/planner.h"
+#include "planner/planner1d.h"
 
 namespace Flux {
 namespace resource_model {
@@ -38,9 +42,12 @@ namespace resource_model {
 // job allocation/reservation -- subtract 1 from x_checker planner for the
 // scheduled span. Any vertex with less than X_CHECKER_NJOBS available in its
 // x_checker cannot be exclusively allocated or reserved.
-const char * const X_CHECKER_JOBS_STR = "jobs";
 const int64_t X_CHECKER_NJOBS = 0x40000000;
 
+// Subsystem ids below this have a bit in infra_base_t::member_mask, and up
+// to this many graph views can select entities (see infra_base_t::view_mask).
+const int MASK_BITS = 64;
+
 typedef std::string subsystem_t;
 typedef std::map<subsystem_t, std::string> multi_subsystems_t;
 typedef std::map<subsystem_t, std::set<std::string> > multi_subsystemsS;
@@ -88,52 +95,13 @@ struct schedule_t {
     schedule_t () { }
     schedule_t (const schedule_t &o)
     {
-        int64_t base_time = 0;
-        uint64_t duration = 0;
-        size_t len = 0;
-
-        // copy constructor does not copy the contents
-        // of the schedule tables and of the planner objects.
-        if (o.plans) {
-            base_time = planner_base_time (o.plans);
-            duration = planner_duration (o.plans);
-            len = planner_resources_len (o.plans);
-            plans = planner_new (base_time, duration,
-                                 planner_resource_totals (o.plans),
-                                 planner_resource_types (o.plans), len);
-        }
-        if (o.x_checker) {
-            base_time = planner_base_time (o.x_checker);
-            duration = planner_duration (o.x_checker);
-            len = planner_resources_len (o.x_checker);
-            x_checker = planner_new (base_time, duration,
-                                     planner_resource_totals (o.x_checker),
-                                     planner_resource_types (o.x_checker), len);
-        }
+        copy (o);
     }
     schedule_t &operator= (const schedule_t &o)
     {
-        int64_t base_time = 0;
-        uint64_t duration = 0;
-        size_t len = 0;
-
-        // assign operator does not copy the contents
-        // of the schedule tables and of the planner objects.
-        if (o.plans) {
-            base_time = planner_base_time (o.plans);
-            duration = planner_duration (o.plans);
-            len = planner_resources_len (o.plans);
-            plans = planner_new (base_time, duration,
-                                 planner_resource_totals (o.plans),
-                                 planner_resource_types (o.plans), len);
-        }
-        if (o.x_checker) {
-            base_time = planner_base_time (o.x_checker);
-            duration = planner_duration (o.x_checker);
-            len = planner_resources_len (o.x_checker);
-            x_checker = planner_new (base_time, duration,
-                                     planner_resource_totals (o.x_checker),
-                                     planner_resource_types (o.x_checker), len);
+        if (this != &o) {
+            destroy ();
+            copy (o);
         }
         return *this;
     }
@@ -143,18 +111,35 @@ struct schedule_t {
         allocations.clear ();
         reservations.clear ();
         x_spans.clear ();
-        if (plans)
-            planner_destroy (&plans);
-        if (x_checker)
-            planner_destroy (&x_checker);
+        destroy ();
     }
 
     std::map<int64_t, int64_t> tags;
     std::map<int64_t, int64_t> allocations;
     std::map<int64_t, int64_t> reservations;
     std::map<int64_t, int64_t> x_spans;
-    planner_t *plans = NULL;
-    planner_t *x_checker = NULL;
+    planner1d_t *plans = NULL;
+    planner1d_t *x_checker = NULL;
+
+private:
+    // Copies share the planned spans of the planners until either side
+    // is updated (see planner1d_clone), so copying a schedule is cheap.
+    void copy (const schedule_t &o)
+    {
+        tags = o.tags;
+        allocations = o.allocations;
+        reservations = o.reservations;
+        x_spans = o.x_spans;
+        plans = (o.plans)? planner1d_clone (o.plans) : NULL;
+        x_checker = (o.x_checker)? planner1d_clone (o.x_checker) : NULL;
+    }
+    void destroy ()
+    {
+        if (plans)
+            planner1d_destroy (&plans);
+        if (x_checker)
+            planner1d_destroy (&x_checker);
+    }
 };
 
 /*! Base type to organize the data supporting scheduling infrastructure's
@@ -165,53 +150,62 @@ struct infra_base_t {
     infra_base_t (const infra_base_t &o)
     {
         member_of = o.member_of;
+        member_ids = o.member_ids;
+        member_mask = o.member_mask;
+        view_mask = o.view_mask;
     }
     infra_base_t &operator= (const infra_base_t &o)
     {
         member_of = o.member_of;
+        member_ids = o.member_ids;
+        member_mask = o.member_mask;
+        view_mask = o.view_mask;
         return *this;
     }
     virtual ~infra_base_t () { }
     virtual void scrub () = 0;
 
+    //! Make this a member of subsystem s with relation r (* for any).
+    void add_member_of (const subsystem_t &s, const std::string &r)
+    {
+        intern_id_t id = subsystem_ids ().intern (s);
+        member_of[s] = r;
+        if (std::find (member_ids.begin (), member_ids.end (), id)
+            == member_ids.end ())
+            member_ids.push_back (id);
+        if (id < MASK_BITS)
+            member_mask |= (uint64_t)1 << id;
+    }
+    bool in_subsystem (intern_id_t s) const
+    {
+        if (s >= 0 && s < MASK_BITS)
+            return (member_mask >> s) & 1;
+        return std::find (member_ids.begin (), member_ids.end (), s)
+                   != member_ids.end ();
+    }
+    bool in_view (int view) const
+    {
+        return (view_mask >> view) & 1;
+    }
+
     multi_subsystems_t member_of;
+    std::vector<intern_id_t> member_ids; //!< interned keys of member_of
+    uint64_t member_mask = 0;            //!< bit per member_ids below 64
+    uint64_t view_mask = 0;              //!< bit per graph view selecting it
 };
 
 struct pool_infra_t : public infra_base_t {
     pool_infra_t () { }
     pool_infra_t (const pool_infra_t &o): infra_base_t (o)
     {
-        // don't copy the content of infrastructure tables and subtree
-        // planner objects.
-        colors = o.colors;
-        for (auto &kv : o.subplans) {
-            planner_t *p = kv.second;
-            if (!p)
-                continue;
-            int64_t base_time = planner_base_time (p);
-            uint64_t duration = planner_duration (p);
-            size_t len = planner_resources_len (p);
-            subplans[kv.first] = planner_new (base_time, duration,
-                                     planner_resource_totals (p),
-                                     planner_resource_types (p), len);
-        }
+        copy (o);
     }
     pool_infra_t &operator= (const pool_infra_t &o)
     {
-        // don't copy the content of infrastructure tables and subtree
-        // planner objects.
-        infra_base_t::operator= (o);
-        colors = o.colors;
-        for (auto &kv : o.subplans) {
-            planner_t *p = kv.second;
-            if (!p)
-                continue;
-            int64_t base_time = planner_base_time (p);
-            uint64_t duration = planner_duration (p);
-            size_t len = planner_resources_len (p);
-            subplans[kv.first] = planner_new (base_time, duration,
-                                     planner_resource_totals (p),
-                                     planner_resource_types (p), len);
+        if (this != &o) {
+            infra_base_t::operator= (o);
+            scrub ();
+            copy (o);
         }
         return *this;
     }
@@ -220,51 +214,50 @@ struct pool_infra_t : public infra_base_t {
         job2span.clear ();
         for (auto &kv : subplans)
             planner_destroy (&(kv.second));
-        colors.clear ();
     }
     virtual void scrub ()
     {
         job2span.clear ();
         for (auto &kv : subplans)
             planner_destroy (&(kv.second));
-        colors.clear ();
+        subplans.clear ();
+    }
+    //! Take copies of the scheduling data of o only: the subsystems and
+    //! graph views this is a member of stay as they are.
+    void assign_plans (const pool_infra_t &o)
+    {
+        if (this != &o) {
+            scrub ();
+            copy (o);
+        }
     }
 
     std::map<int64_t, int64_t> job2span;
-    std::map<subsystem_t, planner_t *> subplans;
-    std::map<subsystem_t, uint64_t> colors;
+    std::map<intern_id_t, planner_t *> subplans; //!< keyed by subsystem id
+
+private:
+    // Subtree planners are deep copies (see planner_clone).
+    void copy (const pool_infra_t &o)
+    {
+        job2span = o.job2span;
+        for (auto &kv : o.subplans)
+            subplans[kv.first] = (kv.second)? planner_clone (kv.second) : NULL;
+    }
 };
 
 struct relation_infra_t : public infra_base_t {
     relation_infra_t () { }
-    relation_infra_t (const relation_infra_t &o): infra_base_t (o)
-    {
-        needs = o.needs;
-        best_k_cnt = o.best_k_cnt;
-        exclusive = o.exclusive;
-    }
+    relation_infra_t (const relation_infra_t &o): infra_base_t (o) { }
     relation_infra_t &operator= (const relation_infra_t &o)
     {
         infra_base_t::operator= (o);
-        needs = o.needs;
-        best_k_cnt = o.best_k_cnt;
-        exclusive = o.exclusive;
         return *this;
     }
     virtual ~relation_infra_t ()
     {
 
     }
-    virtual void scrub ()
-    {
-        needs = 0;
-        best_k_cnt = 0;
-        exclusive = 0;
-    }
-
-    uint64_t needs = 0;
-    uint64_t best_k_cnt = 0;
-    int exclusive = 0;
+    virtual void scrub () { }
 };
 
 //! Resource pool data type
@@ -273,6 +266,7 @@ struct resource_pool_t {
     resource_pool_t (const resource_pool_t &o)
     {
         type = o.type;
+        type_id = o.type_id;
         paths = o.paths;
         basename = o.basename;
         name = o.name;
@@ -287,6 +281,7 @@ struct resource_pool_t {
     resource_pool_t &operator= (const resource_pool_t &o)
     {
         type = o.type;
+        type_id = o.type_id;
         paths = o.paths;
         basename = o.basename;
         name = o.name;
@@ -307,6 +302,7 @@ struct resource_pool_t {
 
     // Resource pool data
     std::string type;
+    intern_id_t type_id = INTERN_NONE; //!< type interned in resource_type_ids
     std::map<std::string, std::string> paths;
     std::string basename;
     std::string name;
@@ -331,17 +327,20 @@ struct resource_relation_t {
     resource_relation_t (const resource_relation_t &o)
     {
         name = o.name;
+        idx = o.idx;
         idata = o.idata;
     }
     resource_relation_t &operator= (const resource_relation_t &o)
     {
         name = o.name;
+        idx = o.idx;
         idata = o.idata;
         return *this;
     }
     ~resource_relation_t () { }
 
     std::string name;
+    int64_t idx = -1;       //!< dense index of the edge in its graph
     relation_infra_t idata; //!< scheduling infrastructure data
 };
 
@@ -28,7 +28,7 @@
 #include <cstdint>
 #include <boost/algorithm/string.hpp>
 #include "resource_gen.hpp"
-#include "planner/planner.h"
+#include "planner/planner1d.h"
 
 extern "C" {
 #if HAVE_CONFIG_H
@@ -147,6 +147,8 @@ edg_t dfs_emitter_t::raw_edge (vtx_t src_v, vtx_t tgt_v)
                         + db.resource_graph[src_v].name
                         + " -> "
                         + db.resource_graph[tgt_v].name;
+    } else {
+        db.resource_graph[e].idx = db.n_edges++;
     }
     return e;
 }
@@ -158,15 +160,15 @@ void dfs_emitter_t::emit_edges (gge_t ge, const gg_t &recipe,
     edg_t e = raw_edge (src_v, tgt_v);
     if (m_err_msg != "")
         return;
-    db.resource_graph[e].idata.member_of[recipe[ge].e_subsystem]
-        = recipe[ge].relation;
+    db.resource_graph[e].idata.add_member_of (recipe[ge].e_subsystem,
+                                              recipe[ge].relation);
     db.resource_graph[e].name += ":" + recipe[ge].e_subsystem
                                      + "." + recipe[ge].relation;
     e = raw_edge (tgt_v, src_v);
     if (m_err_msg != "")
         return;
-    db.resource_graph[e].idata.member_of[recipe[ge].e_subsystem]
-        = recipe[ge].rrelation;
+    db.resource_graph[e].idata.add_member_of (recipe[ge].e_subsystem,
+                                              recipe[ge].rrelation);
     db.resource_graph[e].name += ":" + recipe[ge].e_subsystem
                                      + "." + recipe[ge].rrelation;
 }
@@ -196,22 +198,18 @@ vtx_t dfs_emitter_t::emit_vertex (ggv_t u, gge_t e, const gg_t &recipe,
 
     string istr = (id != -1)? to_string (id) : "";
     db.resource_graph[v].type = recipe[u].type;
+    db.resource_graph[v].type_id
+        = Flux::resource_type_ids ().intern (recipe[u].type);
     db.resource_graph[v].basename = recipe[u].basename;
     db.resource_graph[v].size = recipe[u].size;
-    const char *res_types[1];
-    res_types[0] = recipe[u].type.c_str ();
-    const uint64_t avail = recipe[u].size;
-    planner_t *plans = planner_new (0, INT64_MAX, &avail, res_types, 1);
+    planner1d_t *plans = planner1d_new (0, INT64_MAX, recipe[u].size);
     db.resource_graph[v].schedule.plans = plans;
-
-    const char *jobs = X_CHECKER_JOBS_STR;
-    const uint64_t njobs = X_CHECKER_NJOBS;
-    planner_t *x_checker = planner_new (0, INT64_MAX, &njobs, &jobs, 1);
+    planner1d_t *x_checker = planner1d_new (0, INT64_MAX, X_CHECKER_NJOBS);
     db.resource_graph[v].schedule.x_checker = x_checker;
     db.resource_graph[v].id = id;
     db.resource_graph[v].name = recipe[u].basename + istr;
     db.resource_graph[v].paths[ssys] = pref + "/" + db.resource_graph[v].name;
-    db.resource_graph[v].idata.member_of[ssys] = "*";
+    db.resource_graph[v].idata.add_member_of (ssys, "*");
 
     //
     // Indexing for fast look-up...
@@ -317,8 +315,8 @@ void dfs_emitter_t::tree_edge (gge_t e, const gg_t &recipe)
                 db.resource_graph[tgt_vtx].paths[recipe[e].e_subsystem]
                     = db.resource_graph[src_vtx].paths[recipe[e].e_subsystem]
                           + "/" + db.resource_graph[tgt_vtx].name;
-                db.resource_graph[tgt_vtx].idata.member_of[recipe[e].e_subsystem]
-                    = "*";
+                db.resource_graph[tgt_vtx].idata.add_member_of (
+                    recipe[e].e_subsystem, "*");
                 emit_edges (e, recipe, src_vtx, tgt_vtx);
                 m_gen_src_vtx[tgt_ggv].push_back (tgt_vtx);
             }
@@ -346,8 +344,8 @@ void dfs_emitter_t::tree_edge (gge_t e, const gg_t &recipe)
                 db.resource_graph[tgt_vtx].paths[recipe[e].e_subsystem]
                     = db.resource_graph[src_vtx].paths[recipe[e].e_subsystem]
                           + "/" + db.resource_graph[tgt_vtx].name;
-                db.resource_graph[tgt_vtx].idata.member_of[recipe[e].e_subsystem]
-                    = "*";
+                db.resource_graph[tgt_vtx].idata.add_member_of (
+                    recipe[e].e_subsystem, "*");
                 emit_edges (e, recipe, src_vtx, tgt_vtx);
                 m_gen_src_vtx[tgt_ggv].push_back (tgt_vtx);
             }
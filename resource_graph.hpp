@@ -25,6 +25,8 @@
 #ifndef RESOURCE_GRAPH_HPP
 #define RESOURCE_GRAPH_HPP
 
+#include <cerrno>
+#include <vector>
 #include <boost/config.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/filtered_graph.hpp>
@@ -56,37 +58,45 @@ typedef adjacency_list<vecS, vecS, directedS, resource_pool_t,
  *  can also self-select. If its member_of[subsystem] has been
  *  annotated with '*', it is selected.
  */
+inline bool subsystem_selects (const infra_base_t &inf,
+                               const multi_subsystemsS &selector)
+{
+    for (auto &kv : inf.member_of) {
+        multi_subsystemsS::const_iterator i;
+        i = selector.find (kv.first);
+        if (i != selector.end ()) {
+            if (kv.second == "*")
+                return true;
+            else if (i->second.find (kv.second) != i->second.end ()
+                     || i->second.find ("*") != i->second.end ())
+                return true;
+        }
+    }
+    return false;
+}
+
+/*! Filter of a graph view: selects the vertices or edges whose view_mask
+ *  has the bit of the view. The bit is set once per entity when the view
+ *  is added (see resource_graph_db_t::add_view), so filtering an out-edge
+ *  walk costs a bit test per entity rather than evaluating the selector.
+ */
 template <typename graph_entity, typename inframap>
 class subsystem_selector_t {
 public:
     subsystem_selector_t () {}
     ~subsystem_selector_t () {}
-    subsystem_selector_t (inframap &im, const multi_subsystemsS &sel)
+    subsystem_selector_t (inframap &im, int view)
     {
         // must be lightweight -- e.g., bundled property map.
         m_imap = im;
-        m_selector = sel;
+        m_view = view;
     }
     bool operator () (const graph_entity &ent) const {
-        typedef typename property_traits<inframap>::value_type infra_type;
-        const infra_type &inf = get (m_imap, ent);
-        const multi_subsystems_t &subsystems = inf.member_of;
-        for (auto &kv : subsystems) {
-            multi_subsystemsS::const_iterator i;
-            i = m_selector.find (kv.first);
-            if (i != m_selector.end ()) {
-                if (kv.second == "*")
-                    return true;
-                else if (i->second.find (kv.second) != i->second.end ()
-                         || i->second.find ("*") != i->second.end ())
-                    return true;
-            }
-        }
-        return false;
+        return get (m_imap, ent).in_view (m_view);
     }
 
 private:
-    multi_subsystemsS m_selector;
+    int m_view = 0;
     inframap m_imap;
 };
 
@@ -118,6 +128,94 @@ struct resource_graph_db_t {
     std::map<std::string, std::vector <vtx_t> > by_type;
     std::map<std::string, std::vector <vtx_t> > by_name;
     std::map<std::string, std::vector <vtx_t> > by_path;
+    int64_t n_edges = 0;    //!< edges added so far: the next edge index
+    int n_views = 0;
+
+    /*! Add a graph view that selects the vertices and edges of
+     *  resource_graph that selector selects (see subsystem_selects), and
+     *  mark them with the bit of the view.
+     *
+     *  \param selector subsystems and relation types to select, e.g.,
+     *                   matcher_data_t::subsystemsS ().
+     *  \return         the view to pass to subsystem_selector_t; -1 with
+     *                   errno set to ENOSPC if there are already MASK_BITS
+     *                   views.
+     */
+    int add_view (const multi_subsystemsS &selector)
+    {
+        vtx_iterator vi, v_end;
+        edg_iterator ei, e_end;
+        if (n_views >= MASK_BITS) {
+            errno = ENOSPC;
+            return -1;
+        }
+        uint64_t bit = (uint64_t)1 << n_views;
+        for (tie (vi, v_end) = vertices (resource_graph); vi != v_end; ++vi) {
+            infra_base_t &inf = resource_graph[*vi].idata;
+            if (subsystem_selects (inf, selector))
+                inf.view_mask |= bit;
+        }
+        for (tie (ei, e_end) = edges (resource_graph); ei != e_end; ++ei) {
+            infra_base_t &inf = resource_graph[*ei].idata;
+            if (subsystem_selects (inf, selector))
+                inf.view_mask |= bit;
+        }
+        return n_views++;
+    }
+};
+
+/*! Snapshot of the scheduling state of all of the vertices of a resource
+ *  graph: their schedules (vertex and exclusivity planners along with the
+ *  span tables) and scheduling infrastructure data (subtree planners).
+ *  Taking or restoring a snapshot only copies the planners (planner1d_clone
+ *  shares the planned spans of a vertex planner until either copy changes),
+ *  so it is far cheaper than regenerating the graph. This allows what-if
+ *  matches and rollbacks without replaying the jobs.
+ */
+class resource_graph_snapshot_t {
+public:
+    void take (const resource_graph_t &g)
+    {
+        vtx_iterator vi, v_end;
+        m_schedules.clear ();
+        m_idata.clear ();
+        m_schedules.reserve (num_vertices (g));
+        m_idata.reserve (num_vertices (g));
+        for (tie (vi, v_end) = vertices (g); vi != v_end; ++vi) {
+            m_schedules.push_back (g[*vi].schedule);
+            m_idata.push_back (g[*vi].idata);
+        }
+    }
+
+    /*! Roll the vertices of g back to the snapshot. Only scheduling state
+     *  goes back: graph views added since the snapshot was taken keep their
+     *  selection. The snapshot remains valid and can be restored again.
+     *
+     *  \return         0 on success; -1 with errno set to EINVAL if g does
+     *                  not have the vertices the snapshot was taken from.
+     */
+    int restore (resource_graph_t &g) const
+    {
+        vtx_iterator vi, v_end;
+        if (num_vertices (g) != m_schedules.size ()) {
+            errno = EINVAL;
+            return -1;
+        }
+        for (tie (vi, v_end) = vertices (g); vi != v_end; ++vi) {
+            g[*vi].schedule = m_schedules[*vi];
+            g[*vi].idata.assign_plans (m_idata[*vi]);
+        }
+        return 0;
+    }
+
+    size_t size () const
+    {
+        return m_schedules.size ();
+    }
+
+private:
+    std::vector<schedule_t> m_schedules;
+    std::vector<pool_infra_t> m_idata;
 };
 
 template<class name_map, class graph_entity>
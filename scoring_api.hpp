@@ -86,9 +86,9 @@ namespace detail {
 class evals_t {
 public:
     evals_t () { }
-    evals_t (int64_t cutline, const std::string &res_type)
+    evals_t (int64_t cutline, intern_id_t res_type)
         : m_resrc_type (res_type), m_cutline (cutline) { }
-    evals_t (const std::string &res_type)
+    evals_t (intern_id_t res_type)
         : m_resrc_type (res_type) { }
     evals_t (const evals_t &o)
     {
@@ -232,7 +232,7 @@ public:
 
 private:
     std::vector<eval_egroup_t> m_eval_egroups;
-    std::string m_resrc_type;
+    intern_id_t m_resrc_type = INTERN_NONE;
     int64_t m_cutline = 0;
     unsigned int m_qual_count = 0;
     unsigned int m_total_count = 0;
@@ -288,18 +288,22 @@ inline boost::icl::interval_set<int64_t>::interval_type to_interval (
 }
 } // namespace fold
 
+/*! Scoring API. Evaluations are kept per subsystem and resource type, both
+ *  keyed by their interned ids (see intern.hpp). Each method also comes in
+ *  a form that takes the names instead, which interns them first.
+ */
 class scoring_api_t {
 public:
     scoring_api_t () {}
     scoring_api_t (const scoring_api_t &o)
     {
         for (auto &p : o.m_ssys_map) {
-            const subsystem_t &s = p.first;
-            auto o = new std::map<const std::string, detail::evals_t *>();
+            intern_id_t s = p.first;
+            auto o = new std::map<intern_id_t, detail::evals_t *>();
             m_ssys_map.insert (std::make_pair (s, o));
             auto &tmap = *(p.second);
             for (auto &p2 : tmap) {
-                const std::string &res_type = p2.first;
+                intern_id_t res_type = p2.first;
                 detail::evals_t *ne = new detail::evals_t ();
                 *ne = *(p2.second);
                 (*m_ssys_map[s]).insert (std::make_pair (res_type, ne));
@@ -309,12 +313,12 @@ public:
     const scoring_api_t &operator= (const scoring_api_t &o)
     {
         for (auto &p : o.m_ssys_map) {
-            const subsystem_t &s = p.first;
-            auto o = new std::map<const std::string, detail::evals_t *>();
+            intern_id_t s = p.first;
+            auto o = new std::map<intern_id_t, detail::evals_t *>();
             m_ssys_map.insert (std::make_pair (s, o));
             auto &tmap = *(p.second);
             for (auto &p2 : tmap) {
-                const std::string &res_type = p2.first;
+                intern_id_t res_type = p2.first;
                 detail::evals_t *ne = new detail::evals_t ();
                 *ne = *(p2.second);
                 (*m_ssys_map[s]).insert (std::make_pair (res_type, ne));
@@ -338,97 +342,122 @@ public:
         }
     }
 
+    int64_t cutline (intern_id_t s, intern_id_t r)
+    {
+        return evals (s, r)->cutline ();
+    }
     int64_t cutline (const subsystem_t &s, const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->cutline ();
+        return cutline (ssys_id (s), type_id (r));
     }
 
+    int64_t set_cutline (intern_id_t s, intern_id_t r, int64_t c)
+    {
+        return evals (s, r)->set_cutline (c);
+    }
     int64_t set_cutline (const subsystem_t &s, const std::string &r,
                 int64_t c)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->set_cutline (c);
+        return set_cutline (ssys_id (s), type_id (r), c);
     }
 
+    void rewind_iter_cur (intern_id_t s, intern_id_t r)
+    {
+        return evals (s, r)->rewind_iter_cur ();
+    }
     void rewind_iter_cur (const subsystem_t &s, const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->rewind_iter_cur ();
+        return rewind_iter_cur (ssys_id (s), type_id (r));
     }
 
+    std::vector<eval_egroup_t>::iterator iter_cur (intern_id_t s,
+                                                   intern_id_t r)
+    {
+        return evals (s, r)->iter_cur;
+    }
     std::vector<eval_egroup_t>::iterator iter_cur (const subsystem_t &s,
                                                    const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->iter_cur;
+        return iter_cur (ssys_id (s), type_id (r));
     }
 
+    void incr_iter_cur (intern_id_t s, intern_id_t r)
+    {
+        evals (s, r)->iter_cur++;
+    }
     void incr_iter_cur (const subsystem_t &s, const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        res_evals->iter_cur++;
+        incr_iter_cur (ssys_id (s), type_id (r));
     }
 
+    int add (intern_id_t s, intern_id_t r, const eval_egroup_t &eg)
+    {
+        return evals (s, r)->add (eg);
+    }
     int add (const subsystem_t &s, const std::string &r, const eval_egroup_t &eg)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->add (eg);
+        return add (ssys_id (s), type_id (r), eg);
     }
 
     //! Can throw an out_of_range exception
+    const eval_egroup_t &at (intern_id_t s, intern_id_t r, unsigned int i)
+    {
+        return evals (s, r)->at(i);
+    }
     const eval_egroup_t &at (const subsystem_t &s, const std::string &r,
               unsigned int i)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->at(i);
+        return at (ssys_id (s), type_id (r), i);
     }
 
+    unsigned int qualified_count (intern_id_t s, intern_id_t r)
+    {
+        return evals (s, r)->qualified_count ();
+    }
     unsigned int qualified_count (const subsystem_t &s, const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->qualified_count ();
+        return qualified_count (ssys_id (s), type_id (r));
     }
 
+    unsigned int total_count (intern_id_t s, intern_id_t r)
+    {
+        return evals (s, r)->total_count ();
+    }
     unsigned int total_count (const subsystem_t &s, const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->total_count ();
+        return total_count (ssys_id (s), type_id (r));
     }
 
     template<class compare_op = fold::greater, class binary_op = fold::plus>
-    int64_t choose_accum_best_k (const subsystem_t &s, const std::string &r,
+    int64_t choose_accum_best_k (intern_id_t s, intern_id_t r,
                 unsigned int k,
                 compare_op comp = fold::greater(),
                 binary_op accum = fold::plus ())
     {
         int64_t rc;
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
+        auto res_evals = evals (s, r);
         if ( (rc = res_evals->choose_best_k<compare_op> (k, comp)) != -1) {
             m_hier_constrain_now = true;
             rc = res_evals->accum_best_k<binary_op> (accum);
         }
         return rc;
     }
+    template<class compare_op = fold::greater, class binary_op = fold::plus>
+    int64_t choose_accum_best_k (const subsystem_t &s, const std::string &r,
+                unsigned int k,
+                compare_op comp = fold::greater(),
+                binary_op accum = fold::plus ())
+    {
+        return choose_accum_best_k (ssys_id (s), type_id (r), k, comp, accum);
+    }
 
     template<class compare_op = fold::greater, class binary_op = fold::plus>
-    int64_t choose_accum_all (const subsystem_t &s, const std::string &r,
+    int64_t choose_accum_all (intern_id_t s, intern_id_t r,
                 compare_op comp = fold::greater (),
                 binary_op accum = fold::plus ())
     {
         int64_t rc;
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
+        auto res_evals = evals (s, r);
         unsigned int k = res_evals->qualified_count ();
         if ( (rc = res_evals->choose_best_k<compare_op> (k, comp)) != -1) {
             m_hier_constrain_now = true;
@@ -436,28 +465,43 @@ public:
         }
         return rc;
     }
+    template<class compare_op = fold::greater, class binary_op = fold::plus>
+    int64_t choose_accum_all (const subsystem_t &s, const std::string &r,
+                compare_op comp = fold::greater (),
+                binary_op accum = fold::plus ())
+    {
+        return choose_accum_all (ssys_id (s), type_id (r), comp, accum);
+    }
 
+    template<class output_it, class unary_op>
+    output_it transform (intern_id_t s, intern_id_t r,
+                  output_it o_it, unary_op uop)
+    {
+        return evals (s, r)->transform<output_it, unary_op> (o_it, uop);
+    }
     template<class output_it, class unary_op>
     output_it transform (const subsystem_t &s, const std::string &r,
                   output_it o_it, unary_op uop)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->transform<output_it, unary_op> (o_it, uop);
+        return transform (ssys_id (s), type_id (r), o_it, uop);
     }
 
+    unsigned int best_k (intern_id_t s, intern_id_t r)
+    {
+        return evals (s, r)->best_k ();
+    }
     unsigned int best_k (const subsystem_t &s, const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->best_k ();
+        return best_k (ssys_id (s), type_id (r));
     }
 
+    unsigned int best_i (intern_id_t s, intern_id_t r)
+    {
+        return evals (s, r)->best_i ();
+    }
     unsigned int best_i (const subsystem_t &s, const std::string &r)
     {
-        handle_new_keys (s, r);
-        auto res_evals = (*m_ssys_map[s])[r];
-        return res_evals->best_i ();
+        return best_i (ssys_id (s), type_id (r));
     }
 
     bool hier_constrain_now ()
@@ -468,24 +512,29 @@ public:
     void merge (const scoring_api_t &o)
     {
         for (auto &kv : o.m_ssys_map) {
-            const subsystem_t &s = kv.first;
+            intern_id_t s = kv.first;
             auto &tmap = *(kv.second);
             for (auto &kv2 : tmap) {
-                const std::string &r = kv2.first;
+                intern_id_t r = kv2.first;
                 auto &ev = *(kv2.second);
-                handle_new_keys (s, r);
-                auto res_evals = (*m_ssys_map[s])[r];
-                res_evals->merge (ev);
+                evals (s, r)->merge (ev);
             }
         }
     }
 
-    void resrc_types (const subsystem_t &s, std::vector<std::string> &v)
+    void resrc_types (intern_id_t s, std::vector<intern_id_t> &v)
     {
         handle_new_subsystem (s);
         for (auto &kv : *(m_ssys_map[s]))
             v.push_back (kv.first);
     }
+    void resrc_types (const subsystem_t &s, std::vector<std::string> &v)
+    {
+        intern_id_t sid = ssys_id (s);
+        handle_new_subsystem (sid);
+        for (auto &kv : *(m_ssys_map[sid]))
+            v.push_back (resource_type_ids ().name (kv.first));
+    }
 
     // overall_score and avail are temporary space such that
     // a child vertex visitor can pass the info to the parent vertex
@@ -510,30 +559,38 @@ public:
     }
 
 private:
-    void handle_new_keys (const subsystem_t &s, const std::string &r)
+    static intern_id_t ssys_id (const subsystem_t &s)
     {
-        handle_new_subsystem (s);
-        handle_new_resrc_type (s, r);
+        return subsystem_ids ().intern (s);
     }
 
-    void handle_new_subsystem (const subsystem_t &s)
+    static intern_id_t type_id (const std::string &r)
     {
-        if (m_ssys_map.find (s) == m_ssys_map.end ()) {
-            auto o = new std::map<const std::string, detail::evals_t *>();
-            m_ssys_map.insert (std::make_pair (s, o));
-        }
+        return resource_type_ids ().intern (r);
+    }
+
+    detail::evals_t *evals (intern_id_t s, intern_id_t r)
+    {
+        auto tmap = handle_new_subsystem (s);
+        auto i = tmap->find (r);
+        if (i == tmap->end ())
+            i = tmap->insert (std::make_pair (r, new detail::evals_t (r))).first;
+        return i->second;
     }
 
-    void handle_new_resrc_type (const subsystem_t &s, const std::string &r)
+    std::map<intern_id_t, detail::evals_t *> *handle_new_subsystem (
+                                                 intern_id_t s)
     {
-        if (m_ssys_map[s]->find (r) == m_ssys_map[s]->end ()) {
-            auto e = new detail::evals_t (r);
-            m_ssys_map[s]->insert (std::make_pair (r, e));
+        auto i = m_ssys_map.find (s);
+        if (i == m_ssys_map.end ()) {
+            auto o = new std::map<intern_id_t, detail::evals_t *>();
+            i = m_ssys_map.insert (std::make_pair (s, o)).first;
         }
+        return i->second;
     }
 
-    std::map<const subsystem_t,
-             std::map<const std::string, detail::evals_t *> *> m_ssys_map;
+    std::map<intern_id_t,
+             std::map<intern_id_t, detail::evals_t *> *> m_ssys_map;
     bool m_hier_constrain_now = false;
     int64_t m_overall_score = -1;
     unsigned int m_avail = 0;
@@ -0,0 +1,58 @@
+#!/bin/sh
+
+test_description='Test parallel subtree walks against the serial results'
+
+. $(dirname $0)/sharness.sh
+
+cmd_dir="${SHARNESS_TEST_SRCDIR}/data/commands"
+exp_dir="${SHARNESS_TEST_SRCDIR}/data/expected"
+grug_dir="${SHARNESS_TEST_SRCDIR}/data/grugs"
+query="${SHARNESS_TEST_SRCDIR}/../resource-query"
+
+#
+# The parallel walk (-j) must select exactly the resources the serial
+# walk does, so its output is compared against the expected output of
+# the serial tests.
+#
+
+cmds001="${cmd_dir}/exclusive/test004.rack-exclusive.cmds"
+test001_desc="match allocate with rack exclusives on 4 threads (pol=hi)"
+test_expect_success "${test001_desc}" '
+    ${query} -G ${grug_dir}/medium.graphml -S CA -P high -j 4 \
+        -t 001.R.out < ${cmds001} &&
+    test_cmp 001.R.out ${exp_dir}/exclusive/003.R.out
+'
+
+cmds002="${cmd_dir}/exclusive/test004.rack-exclusive.cmds"
+test002_desc="match allocate with rack exclusives on 4 threads (pol=low)"
+test_expect_success "${test002_desc}" '
+    ${query} -G ${grug_dir}/medium.graphml -S CA -P low -j 4 \
+        -t 002.R.out < ${cmds002} &&
+    test_cmp 002.R.out ${exp_dir}/exclusive/010.R.out
+'
+
+cmds003="${cmd_dir}/many_jobs/test009.manyjobs.cmds"
+test003_desc="match allocate/reserve many jobs on 4 threads (pol=hi)"
+test_expect_success "${test003_desc}" '
+    ${query} -G ${grug_dir}/resv_test.graphml -S CA -P high -j 4 \
+        -t 003.R.out < ${cmds003} &&
+    test_cmp 003.R.out ${exp_dir}/many_jobs/001.R.out
+'
+
+cmds004="${cmd_dir}/advanced/test007.advanced.cmds"
+test004_desc="match allocate with BB on 8 threads at every depth (pol=low)"
+test_expect_success "${test004_desc}" '
+    ${query} -G ${grug_dir}/advanced_test.graphml -S CA -P low -j 8 -d 16 \
+        -t 004.R.out < ${cmds004} &&
+    test_cmp 004.R.out ${exp_dir}/advanced/002.R.out
+'
+
+cmds005="${cmd_dir}/exclusive/test004.rack-exclusive.cmds"
+test005_desc="match allocate on 4 threads skipping small subtrees (pol=hi)"
+test_expect_success "${test005_desc}" '
+    ${query} -G ${grug_dir}/medium.graphml -S CA -P high -j 4 -d 16 -z 64 \
+        -t 005.R.out < ${cmds005} &&
+    test_cmp 005.R.out ${exp_dir}/exclusive/003.R.out
+'
+
+test_done
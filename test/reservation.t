@@ -35,4 +35,25 @@ test_expect_success "${test002_desc}" '
     test_cmp 002.R.out ${exp_dir}/002.R.out
 '
 
+#
+# Auxiliary subsystem -- Containment and Power-Aware (-S C+PA)
+#     Only the dominant subsystem's root plan picks the reservation times,
+#     so adding the power subsystem must not change them
+#
+
+pgrugs="${SHARNESS_TEST_SRCDIR}/data/grugs/power.graphml"
+cmds003="${cmd_dir}/test005.aux.cmds"
+test003_desc="allocate or reserve 6 full racks (pol=hi)"
+test_expect_success "${test003_desc}" '
+    ${query} -G ${pgrugs} -S CA -P high -t 003.R.out < ${cmds003} &&
+    test_cmp 003.R.out ${exp_dir}/003.R.out
+'
+
+cmds004="${cmd_dir}/test005.aux.cmds"
+test004_desc="allocate or reserve 6 full racks with power aux (pol=hi)"
+test_expect_success "${test004_desc}" '
+    ${query} -G ${pgrugs} -S C+PA -P high -t 004.R.out < ${cmds004} &&
+    test_cmp 004.R.out ${exp_dir}/003.R.out
+'
+
 test_done
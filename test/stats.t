@@ -0,0 +1,46 @@
+#!/bin/sh
+
+test_description='Test planner statistics On Tiny Machine Configuration'
+
+. $(dirname $0)/sharness.sh
+
+cmd_dir="${SHARNESS_TEST_SRCDIR}/data/commands/stats"
+exp_dir="${SHARNESS_TEST_SRCDIR}/data/expected/stats"
+grugs="${SHARNESS_TEST_SRCDIR}/data/grugs/tiny.graphml"
+query="${SHARNESS_TEST_SRCDIR}/../resource-query"
+counts="^INFO: (vertex planners|exclusivity checkers|subtree planners): [0-9]"
+
+#
+# stats prints, for each kind of planner, how many there are and how many
+# scheduled points and spans they hold in total. Only those counts are
+# compared: the byte counts depend on the platform's structure sizes.
+#
+
+cmds001="${cmd_dir}/test001.4x.cancel2.cmds"
+test001_desc="stats before and after 4 allocations and 2 cancels (pol=hi)"
+test_expect_success "${test001_desc}" '
+    ${query} -G ${grugs} -S CA -P high < ${cmds001} > 001.stdout &&
+    grep -E "${counts}" 001.stdout | sed -e "s/, bytes: [0-9]*//" \
+        > 001.stats.out &&
+    test_cmp 001.stats.out ${exp_dir}/001.stats.out
+'
+
+#
+# Reservations search the root subtree plan with an availability cursor:
+# the number of searches stays put while jobs are allocated now and goes
+# up once a job has to be reserved.
+#
+
+cmds002="${cmd_dir}/test002.8x.reserve1.cmds"
+test002_desc="stats counts the searches of a reservation (pol=hi)"
+test_expect_success "${test002_desc}" '
+    ${query} -G ${grugs} -S CA -P high < ${cmds002} > 002.stdout &&
+    grep "SCHEDULED AT=7200" 002.stdout &&
+    grep "^INFO: subtree planners: searches: " 002.stdout | \
+        sed -e "s/.*searches: \([0-9]*\),.*/\1/" > 002.searches &&
+    test $(wc -l < 002.searches) -eq 3 &&
+    test $(sed -n 2p 002.searches) -eq $(sed -n 1p 002.searches) &&
+    test $(sed -n 3p 002.searches) -gt $(sed -n 2p 002.searches)
+'
+
+test_done
@@ -0,0 +1,16 @@
+#!/bin/sh
+
+test_description='Test the traverser API directly on the tiny machine'
+
+. $(dirname $0)/sharness.sh
+
+grugs="${SHARNESS_TEST_SRCDIR}/data/grugs/tiny.graphml"
+jobspec_dir="${SHARNESS_TEST_SRCDIR}/data/jobspecs/basics"
+traverser_test01="${SHARNESS_TEST_SRCDIR}/../traverser_test01"
+
+test_expect_success 'traverser_test01 passes all of its checks' '
+    ${traverser_test01} ${grugs} ${jobspec_dir} > traverser_test01.out &&
+    ! grep "^not ok" traverser_test01.out
+'
+
+test_done
@@ -0,0 +1,319 @@
+/*****************************************************************************\
+ *  Copyright (c) 2017 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+/*
+ * Usage: traverser_test01 <tiny.graphml> <basics jobspec dir>
+ */
+
+#include <cstdlib>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include "resource_gen.hpp"
+#include "dfu_traverse.hpp"
+#include "dfu_match_id_based.hpp"
+// Last: its ok/is/skip macros would clash with the boost headers
+#include "planner/tap.h"
+
+using namespace std;
+using namespace Flux::resource_model;
+using namespace Flux::Jobspec;
+
+static string jobspec_dir;
+
+struct context_t {
+    resource_graph_db_t db;
+    high_first_t matcher;
+    f_resource_graph_t *fg = NULL;
+    dfu_traverser_t traverser;
+    ~context_t () { delete fg; }
+};
+
+/* Load the graph and initialize the traverser the way resource-query
+ * does with -S CA -P high.
+ */
+static int setup (context_t &ctx, const string &grug)
+{
+    int view = -1;
+    resource_generator_t rgen;
+    if (rgen.read_graphml (grug, ctx.db) != 0)
+        return -1;
+    ctx.matcher.set_matcher_name ("CA");
+    if (ctx.matcher.add_subsystem ("containment", "*") != 0)
+        return -1;
+    if ((view = ctx.db.add_view (ctx.matcher.subsystemsS ())) < 0)
+        return -1;
+    resource_graph_t &g = ctx.db.resource_graph;
+    vtx_infra_map_t vmap = get (&resource_pool_t::idata, g);
+    edg_infra_map_t emap = get (&resource_relation_t::idata, g);
+    subsystem_selector_t<vtx_t, f_vtx_infra_map_t> vtxsel (vmap, view);
+    subsystem_selector_t<edg_t, f_edg_infra_map_t> edgsel (emap, view);
+    ctx.fg = new f_resource_graph_t (g, edgsel, vtxsel);
+    ctx.matcher.add_sdau_resource_type (ctx.matcher.dom_subsystem (), "core");
+    return ctx.traverser.initialize (ctx.fg, &(ctx.db.roots), &(ctx.matcher));
+}
+
+static Jobspec load (const string &name)
+{
+    ifstream in;
+    in.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+    in.open (jobspec_dir + "/" + name);
+    return Jobspec (in);
+}
+
+static int allocate (dfu_traverser_t &traverser, const string &name,
+                     int64_t jobid, int64_t at)
+{
+    stringstream ss;
+    Jobspec job = load (name);
+    return traverser.run (job, match_op_t::MATCH_ALLOCATE, jobid, &at, ss);
+}
+
+static const vector<string> basics = {
+    "test001.cluster1.rack1.node1.slot1.socket1.core1.yaml",
+    "test002.node1.slot1.socket2.core5-gpu1-memory6.yaml",
+    "test003.slot2.node1.socket2.core5-gpu1-memory8.yaml",
+    "test004.slot1.core8-memory2.yaml",
+    "test005.slot4.node1.socket2.core18-gpu1-memory32.yaml",
+    "test006.cluster1.rack1.node1.slot1.socket1.core36.yaml",
+    "test007.cluster1.rack1.node1.slot1.socket1.core37.yaml"
+};
+
+static const vector<int64_t> times = {0, 1800, 3600, 7200};
+
+/* Test every basics jobspec at every time, starting from the (first + k)th
+ * jobspec so that threads walk the queries in different orders.
+ */
+static vector<int> satisfy_all (dfu_traverser_t &traverser, size_t first)
+{
+    vector<Jobspec> jobs;
+    vector<int> results (basics.size () * times.size (), 0);
+    for (auto &name : basics)
+        jobs.push_back (load (name));
+    for (size_t k = 0; k < basics.size (); ++k) {
+        size_t j = (first + k) % basics.size ();
+        for (size_t i = 0; i < times.size (); ++i)
+            results[j * times.size () + i]
+                = traverser.satisfiable (jobs[j], times[i]);
+    }
+    return results;
+}
+
+static int test_satisfiable (const string &grug)
+{
+    const unsigned n_threads = 8;
+    const unsigned rounds = 4;
+    context_t ctx;
+    ok ((setup (ctx, grug) == 0), "traverser initialized on %s",
+        grug.c_str ());
+
+    // Three of the four sockets are taken until 3600
+    bool alloc = true;
+    for (int64_t jobid = 1; jobid <= 3; ++jobid)
+        alloc = alloc && (allocate (ctx.traverser, basics[5], jobid, 0) == 0);
+    ok (alloc, "three socket-exclusive jobs allocated at 0");
+
+    vector<int> serial = satisfy_all (ctx.traverser, 0);
+    size_t n_met = 0;
+    for (auto rc : serial)
+        n_met += (rc == 0)? 1 : 0;
+    ok ((n_met > 0 && n_met < serial.size ()),
+        "serial run finds %zu of %zu queries satisfiable", n_met,
+        serial.size ());
+    // Query i of jobspec j is at [j * times.size () + i]
+    ok ((serial[5 * times.size ()] == 0 && serial[1 * times.size ()] != 0
+         && serial[1 * times.size () + 1] != 0
+         && serial[1 * times.size () + 2] == 0),
+        "a socket is satisfiable at 0, a node's two sockets only at 3600");
+
+    // Each thread has a traverser and match callback of its own, and all of
+    // them read the one graph at once
+    vector<vector<int> > results (n_threads);
+    vector<thread> threads;
+    for (unsigned t = 0; t < n_threads; ++t) {
+        threads.emplace_back ([&, t] () {
+            high_first_t matcher (ctx.matcher);
+            dfu_traverser_t traverser (ctx.fg, &matcher, &(ctx.db.roots));
+            vector<int> r;
+            for (unsigned n = 0; n < rounds; ++n) {
+                vector<int> one = satisfy_all (traverser, t + n);
+                r.insert (r.end (), one.begin (), one.end ());
+            }
+            results[t] = r;
+        });
+    }
+    for (auto &th : threads)
+        th.join ();
+
+    vector<int> expected;
+    for (unsigned n = 0; n < rounds; ++n)
+        expected.insert (expected.end (), serial.begin (), serial.end ());
+    bool same = true;
+    for (auto &r : results)
+        same = same && (r == expected);
+    ok (same, "%u threads on one graph agree with the serial run", n_threads);
+    ok ((satisfy_all (ctx.traverser, 0) == serial),
+        "the graph is unchanged by the concurrent queries");
+
+    // Without a match callback, satisfiable must fail before using it
+    Jobspec job = load (basics[0]);
+    dfu_traverser_t no_match (ctx.fg, NULL, &(ctx.db.roots));
+    errno = 0;
+    ok ((no_match.satisfiable (job, 0) == -1 && errno == EINVAL),
+        "satisfiable without a match callback fails with EINVAL");
+    dfu_traverser_t no_graph;
+    errno = 0;
+    ok ((no_graph.satisfiable (job, 0) == -1 && errno == EINVAL),
+        "satisfiable without a graph fails with EINVAL");
+    return 0;
+}
+
+/* Number of vertices that still hold any schedule record of jobid.
+ */
+static size_t count_job (context_t &ctx, int64_t jobid)
+{
+    size_t n = 0;
+    vtx_iterator vi, v_end;
+    resource_graph_t &g = ctx.db.resource_graph;
+    for (tie (vi, v_end) = vertices (g); vi != v_end; ++vi) {
+        const schedule_t &sched = g[*vi].schedule;
+        if (sched.tags.count (jobid) || sched.allocations.count (jobid)
+            || sched.reservations.count (jobid) || sched.x_spans.count (jobid)
+            || g[*vi].idata.job2span.count (jobid))
+            n++;
+    }
+    return n;
+}
+
+static int test_advance (const string &grug)
+{
+    context_t ctx;
+    ok ((setup (ctx, grug) == 0), "traverser initialized on %s",
+        grug.c_str ());
+
+    // Job 1: a socket over [0, 3600); job 2: 8 cores over [0, 7200);
+    // job 3: a socket over [5000, 8600)
+    bool alloc = (allocate (ctx.traverser, basics[5], 1, 0) == 0)
+                 && (allocate (ctx.traverser, basics[3], 2, 0) == 0)
+                 && (allocate (ctx.traverser, basics[5], 3, 5000) == 0);
+    ok (alloc, "jobs 1 and 2 allocated at 0 and job 3 at 5000");
+    size_t n1 = count_job (ctx, 1);
+    size_t n2 = count_job (ctx, 2);
+    size_t n3 = count_job (ctx, 3);
+    ok ((n1 > 0 && n2 > 0 && n3 > 0), "each job is recorded on vertices");
+
+    ok ((ctx.traverser.advance (4000) == 0), "advance to 4000 works");
+    ok ((count_job (ctx, 1) == 0), "expired job 1 is forgotten everywhere");
+    ok ((count_job (ctx, 2) == n2 && count_job (ctx, 3) == n3),
+        "live jobs 2 and 3 keep all of their records");
+    ok ((ctx.traverser.remove (1) == 0 && count_job (ctx, 2) == n2
+         && count_job (ctx, 3) == n3), "removing expired job 1 is a no-op");
+
+    // Job 2 holds part of one socket and job 3 reserves another from 5000:
+    // of the four sockets, only the two job 1 and nobody else used are left
+    alloc = (allocate (ctx.traverser, basics[5], 4, 4000) == 0)
+            && (allocate (ctx.traverser, basics[5], 5, 4000) == 0);
+    ok (alloc, "two sockets allocated at 4000");
+    ok ((allocate (ctx.traverser, basics[5], 6, 4000) != 0),
+        "a third socket at 4000 is not available");
+    Jobspec job = load (basics[0]);
+    errno = 0;
+    ok ((allocate (ctx.traverser, basics[0], 7, 0) != 0 && errno == EINVAL
+         && count_job (ctx, 7) == 0
+         && ctx.traverser.satisfiable (job, 0) == -1 && errno == EINVAL),
+        "matches before the base time fail with EINVAL");
+
+    ok ((ctx.traverser.remove (2) == 0 && count_job (ctx, 2) == 0),
+        "live job 2 can still be removed");
+    ok ((allocate (ctx.traverser, basics[5], 8, 4000) == 0),
+        "job 2's socket is allocated at 4000 once it is removed");
+    return 0;
+}
+
+static int test_snapshot (const string &grug)
+{
+    context_t ctx;
+    resource_graph_snapshot_t snapshot;
+    resource_graph_t &g = ctx.db.resource_graph;
+    ok ((setup (ctx, grug) == 0), "traverser initialized on %s",
+        grug.c_str ());
+
+    bool alloc = (allocate (ctx.traverser, basics[5], 1, 0) == 0);
+    size_t n1 = count_job (ctx, 1);
+    vector<int> before = satisfy_all (ctx.traverser, 0);
+    snapshot.take (g);
+    alloc = alloc && (allocate (ctx.traverser, basics[5], 2, 0) == 0)
+                  && (allocate (ctx.traverser, basics[5], 3, 0) == 0);
+    ok ((alloc && snapshot.size () == num_vertices (g)
+         && satisfy_all (ctx.traverser, 0) != before),
+        "jobs allocated after the snapshot change what is satisfiable");
+
+    // A view added after the snapshot must survive its restore
+    int view = ctx.db.add_view (ctx.matcher.subsystemsS ());
+    vtx_t root = ctx.db.roots.at (ctx.matcher.dom_subsystem ());
+    ok ((view > 0 && snapshot.restore (g) == 0
+         && satisfy_all (ctx.traverser, 0) == before
+         && count_job (ctx, 1) == n1 && count_job (ctx, 2) == 0
+         && count_job (ctx, 3) == 0 && g[root].idata.in_view (view)),
+        "restore answers as before the allocations and keeps new views");
+
+    // Update and free the restored planners, which share the planned spans
+    // of the snapshot until either side changes
+    alloc = (allocate (ctx.traverser, basics[5], 4, 0) == 0)
+            && (ctx.traverser.remove (1) == 0)
+            && (ctx.traverser.remove (4) == 0);
+    ok ((alloc && count_job (ctx, 1) == 0 && count_job (ctx, 4) == 0
+         && satisfy_all (ctx.traverser, 0) != before),
+        "restored planners can be updated");
+    ok ((snapshot.restore (g) == 0 && count_job (ctx, 1) == n1
+         && satisfy_all (ctx.traverser, 0) == before),
+        "the snapshot is intact after the restored planners change");
+    return 0;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 3) {
+        fprintf (stderr, "usage: %s <tiny.graphml> <jobspec dir>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    jobspec_dir = argv[2];
+
+    plan (25);
+
+    test_satisfiable (argv[1]);
+
+    test_advance (argv[1]);
+
+    test_snapshot (argv[1]);
+
+    done_testing ();
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
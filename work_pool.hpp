@@ -0,0 +1,225 @@
+/*****************************************************************************\
+ *  Copyright (c) 2017 Lawrence Livermore National Security, LLC.  Produced at
+ *  the Lawrence Livermore National Laboratory (cf, AUTHORS, DISCLAIMER.LLNS).
+ *  LLNL-CODE-658032 All rights reserved.
+ *
+ *  This file is part of the Flux resource manager framework.
+ *  For details, see https://github.com/flux-framework.
+ *
+ *  This program is free software; you can redistribute it and/or modify it
+ *  under the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the license, or (at your option)
+ *  any later version.
+ *
+ *  Flux is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the IMPLIED WARRANTY OF MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the terms and conditions of the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+ *  See also:  http://www.gnu.org/licenses/
+\*****************************************************************************/
+
+#ifndef WORK_POOL_HPP
+#define WORK_POOL_HPP
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace Flux {
+
+/*! Work-stealing pool of worker threads. Each worker has its own queue of
+ *  tasks: it takes the task it queued last from the back of its own queue
+ *  and, when that is empty, steals the oldest task from the front of
+ *  another's. run_all () queues a batch of tasks on the calling thread's
+ *  queue and runs tasks itself until the whole batch is done, so a task
+ *  may call run_all () again for its own subtasks without tying up a
+ *  worker. Threads with nothing to run sleep until tasks are queued or,
+ *  in run_all (), until their batch is done.
+ */
+class work_pool_t {
+public:
+    /*! Start n_workers worker threads. */
+    explicit work_pool_t (unsigned n_workers)
+    {
+        // The last queue is shared by the threads that are not workers
+        for (unsigned i = 0; i < n_workers + 1; ++i)
+            m_queues.emplace_back (new queue_t ());
+        for (unsigned i = 0; i < n_workers; ++i)
+            m_threads.emplace_back (&work_pool_t::worker, this, i);
+    }
+
+    ~work_pool_t ()
+    {
+        {
+            std::lock_guard<std::mutex> guard (m_lock);
+            m_stop = true;
+        }
+        m_cv.notify_all ();
+        for (auto &t : m_threads)
+            t.join ();
+    }
+
+    work_pool_t (const work_pool_t &o) = delete;
+    work_pool_t &operator= (const work_pool_t &o) = delete;
+
+    unsigned size () const
+    {
+        return m_threads.size ();
+    }
+
+    /*! Call f (i) for each i in [0, n) on the pool and return once all of
+     *  the calls have returned. The calls may run in any order and at once.
+     *  If any of them throws, the exception of the lowest i is rethrown
+     *  here after the others have finished.
+     */
+    void run_all (size_t n, const std::function<void (size_t)> &f)
+    {
+        batch_t b (n);
+        size_t self = self_index ();
+        {
+            std::lock_guard<std::mutex> guard (m_queues[self]->lock);
+            for (size_t i = n; i > 0; --i)
+                m_queues[self]->tasks.push_back (task_t{&f, i - 1, &b});
+        }
+        {
+            std::lock_guard<std::mutex> guard (m_lock);
+            m_queued += n;
+        }
+        m_cv.notify_all ();
+
+        task_t t;
+        while (b.pending.load () != 0) {
+            if (pop (self, t)) {
+                run (t);
+                continue;
+            }
+            // Nothing to steal: the rest of the batch is running elsewhere
+            std::unique_lock<std::mutex> guard (m_lock);
+            m_cv.wait (guard, [this, &b] {
+                return b.pending.load () == 0 || m_queued.load () > 0;
+            });
+        }
+        for (auto &e : b.errors)
+            if (e)
+                std::rethrow_exception (e);
+    }
+
+private:
+    struct batch_t {
+        batch_t (size_t n) : pending (n), errors (n) { }
+        std::atomic<size_t> pending;
+        std::vector<std::exception_ptr> errors;
+    };
+
+    struct task_t {
+        const std::function<void (size_t)> *f;
+        size_t i;
+        batch_t *batch;
+    };
+
+    struct queue_t {
+        std::mutex lock;
+        std::deque<task_t> tasks;
+    };
+
+    struct thread_id_t {
+        const work_pool_t *pool;
+        size_t index;
+    };
+
+    static thread_id_t &this_thread_id ()
+    {
+        static thread_local thread_id_t id = {nullptr, 0};
+        return id;
+    }
+
+    size_t self_index () const
+    {
+        const thread_id_t &id = this_thread_id ();
+        return (id.pool == this)? id.index : m_queues.size () - 1;
+    }
+
+    bool pop (size_t self, task_t &t)
+    {
+        {
+            queue_t &q = *m_queues[self];
+            std::lock_guard<std::mutex> guard (q.lock);
+            if (!q.tasks.empty ()) {
+                t = q.tasks.back ();
+                q.tasks.pop_back ();
+                m_queued--;
+                return true;
+            }
+        }
+        for (size_t k = 1; k < m_queues.size (); ++k) {
+            queue_t &q = *m_queues[(self + k) % m_queues.size ()];
+            std::lock_guard<std::mutex> guard (q.lock);
+            if (!q.tasks.empty ()) {
+                t = q.tasks.front ();
+                q.tasks.pop_front ();
+                m_queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run (task_t &t)
+    {
+        try {
+            (*t.f) (t.i);
+        } catch (...) {
+            t.batch->errors[t.i] = std::current_exception ();
+        }
+        if (--t.batch->pending == 0) {
+            // Taking m_lock orders this after the waiter's last check
+            { std::lock_guard<std::mutex> guard (m_lock); }
+            m_cv.notify_all ();
+        }
+    }
+
+    void worker (size_t self)
+    {
+        this_thread_id () = thread_id_t{this, self};
+        task_t t;
+        for (;;) {
+            if (pop (self, t)) {
+                run (t);
+                continue;
+            }
+            std::unique_lock<std::mutex> guard (m_lock);
+            m_cv.wait (guard, [this] {
+                return m_stop || m_queued.load () > 0;
+            });
+            if (m_stop)
+                break;
+        }
+    }
+
+    std::vector<std::unique_ptr<queue_t> > m_queues;
+    std::vector<std::thread> m_threads;
+    // Tasks in the queues. It is raised under m_lock once the tasks are
+    // queued, so it can briefly drop below 0 when they are taken first.
+    std::atomic<long> m_queued{0};
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+};
+
+} // namespace Flux
+
+#endif // WORK_POOL_HPP
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */